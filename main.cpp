@@ -1,13 +1,22 @@
 #include <iomanip>
 
 #include "TwsApi.h"
+#include "ReaderBenchmark.h"
+#include "IndicatorBenchmark.h"
+#include "PricingBenchmark.h"
+#include "Indicators.h"
 #include <iostream>
 #include <string>
 #include <vector>
 #include <thread>
+#include <sstream>
+#include <cmath>
 
 int main() {
     TwsApi api;
+    api.setBarCacheDirectory("bar_cache");
+    api.setOptionChainCacheDirectory("option_chains");
+    api.setContractCacheFile("contracts.cache");
 
     std::cout << "Conectando a TWS..." << std::endl;
     if(api.connect("127.0.0.1", 7497, 0)) {
@@ -38,6 +47,23 @@ int main() {
         std::cout << "15: Filtrar quotes por simbolo y tiempo" << std::endl;
         std::cout << "16: Recibir data de mercado para opciones (IV y OI)" << std::endl;
         std::cout << "17: Recibir cash amount" << std::endl;
+        std::cout << "18: Estadísticas de colas de eventos" << std::endl;
+        std::cout << "19: Benchmark de latencia del lector (socket -> callback)" << std::endl;
+        std::cout << "20: Datos históricos de varios símbolos en paralelo (coroutines)" << std::endl;
+        std::cout << "21: Estado del enlace con TWS (RTT, desfase de reloj, bloqueos)" << std::endl;
+        std::cout << "22: Datos históricos por rango (por bloques, en paralelo)" << std::endl;
+        std::cout << "23: Ticks históricos de un rango (TRADES, BID_ASK, MIDPOINT)" << std::endl;
+        std::cout << "24: Serie de barras en vivo (keepUpToDate)" << std::endl;
+        std::cout << "25: Benchmark de indicadores (ingenuo vs. columnas escalar/AVX2 vs. incremental)" << std::endl;
+        std::cout << "26: Huecos en la caché de barras (detectar y completar)" << std::endl;
+        std::cout << "27: Cadena de opciones (vencimientos, strike ATM y deltas)" << std::endl;
+        std::cout << "28: Cotizaciones de todas las opciones de un vencimiento (en bloque)" << std::endl;
+        std::cout << "29: Griegas netas de la cartera (por subyacente y total)" << std::endl;
+        std::cout << "30: Volatilidad implícita y griegas locales de una cadena" << std::endl;
+        std::cout << "31: Benchmark de valoración de opciones (ingenuo vs. escalar/AVX2 vs. hilos)" << std::endl;
+        std::cout << "32: Superficie de volatilidad (por moneyness y plazo)" << std::endl;
+        std::cout << "33: Estado de la cuenta en streaming (valores y cartera)" << std::endl;
+        std::cout << "34: PnL en tiempo real (cuenta y posiciones) con alerta" << std::endl;
         std::cout << "0: Salir" << std::endl;
         std::cout << "Ingrese una opción: ";
 
@@ -257,9 +283,10 @@ int main() {
                 std::cin >> fin;
                 std::cout << "Ingrese el límite de registros: ";
                 std::cin >> limite;
-                std::vector<HistoricalBar> barras = api.get_historical_data_stocks(simbolo, inicio, fin, limite);
-                for (const auto& barra : barras) {
-                    std::cout << "Barra histórica en " << barra.time << ": O = " << barra.open
+                BarSeries barras = api.get_historical_data_stocks(simbolo, inicio, fin, limite);
+                for (size_t i = 0; i < barras.size(); ++i) {
+                    const HistoricalBar barra = barras[i];
+                    std::cout << "Barra histórica en " << formatBarTime(barra.time, true) << ": O = " << barra.open
                               << ", H = " << barra.high << ", L = " << barra.low
                               << ", C = " << barra.close << ", Volumen = " << barra.volume << std::endl;
                 }
@@ -269,7 +296,7 @@ int main() {
                 std::string symbol;
                 std::cout << "Ingrese el simbolo: ";
                 std::cin >> symbol;
-                api.requestMarketData(symbol);
+                int tickerId = api.requestMarketData(symbol);
                 std::this_thread::sleep_for(std::chrono::milliseconds(200));
 
                 // Display latest quote for this symbol
@@ -280,7 +307,7 @@ int main() {
                                   << ", Close = " << quote.close_price << std::endl;
                     }
                 }
-                api.cancelMarketData(api.m_nextTickerId - 1);
+                api.cancelMarketData(tickerId);
                 break;
             }
             case 14: {
@@ -334,6 +361,476 @@ int main() {
                 std::cout << "Cash: " << cash_amount << std::endl;
                 break;
             }
+            case 18: {
+                std::cout << std::left
+                          << std::setw(14) << "Dominio"
+                          << std::setw(10) << "Profund."
+                          << std::setw(10) << "Capacidad"
+                          << std::setw(12) << "Recibidos"
+                          << std::setw(12) << "Perdidos"
+                          << std::setw(12) << "Esperas"
+                          << std::endl;
+                for (const auto& q : api.getQueueStats()) {
+                    std::cout << std::left
+                              << std::setw(14) << q.domain
+                              << std::setw(10) << q.depth
+                              << std::setw(10) << q.capacity
+                              << std::setw(12) << q.pushed
+                              << std::setw(12) << q.dropped
+                              << std::setw(12) << q.fullWaits
+                              << std::endl;
+                }
+                break;
+            }
+            case 19: {
+                int muestras, cpu;
+                std::cout << "Ingrese el número de muestras: ";
+                std::cin >> muestras;
+                std::cout << "Ingrese la CPU para fijar el hilo (-1 si no aplica): ";
+                std::cin >> cpu;
+
+                std::cout << std::left << std::setw(12) << "Modo"
+                          << std::setw(10) << "p50(us)" << std::setw(10) << "p90(us)"
+                          << std::setw(10) << "p99(us)" << std::setw(11) << "p99.9(us)"
+                          << std::setw(10) << "max(us)" << std::endl;
+                for (WaitStrategy modo : {WaitStrategy::Block, WaitStrategy::SpinYield, WaitStrategy::BusyPoll}) {
+                    ReaderConfig config;
+                    config.waitStrategy = modo;
+                    config.readerCpu = cpu;
+                    LatencySummary r = benchmarkReaderLatency(config, muestras);
+                    std::cout << std::left << std::fixed << std::setprecision(1)
+                              << std::setw(12) << waitStrategyName(modo)
+                              << std::setw(10) << r.p50 << std::setw(10) << r.p90
+                              << std::setw(10) << r.p99 << std::setw(11) << r.p999
+                              << std::setw(10) << r.max << std::endl;
+                }
+                break;
+            }
+            case 20: {
+                std::string simbolos, fin;
+                int limite;
+                std::cout << "Ingrese los símbolos (separados por comas): ";
+                std::cin >> simbolos;
+                std::cout << "Ingrese el datetime de fin: ";
+                std::cin >> fin;
+                std::cout << "Ingrese el límite de registros: ";
+                std::cin >> limite;
+
+                std::vector<std::string> lista;
+                std::istringstream ss(simbolos);
+                for (std::string s; std::getline(ss, s, ',');)
+                    if (!s.empty()) lista.push_back(s);
+
+                // All requests are in flight at once; no thread blocks per symbol.
+                std::vector<Task<BarSeries>> tareas;
+                for (const auto& s : lista)
+                    tareas.push_back(api.historical(s, "", fin, limite));
+                auto resultados = syncWait(whenAll(std::move(tareas)));
+
+                for (size_t i = 0; i < lista.size(); ++i)
+                    std::cout << lista[i] << ": " << resultados[i].size() << " barras" << std::endl;
+                break;
+            }
+            case 21: {
+                LinkStats l = api.getLinkStats();
+                std::cout << "Sondas: enviadas = " << l.probesSent << ", respondidas = " << l.probesAnswered
+                          << ", perdidas = " << l.probesLost << std::endl;
+                std::cout << "RTT (us): último = " << l.lastRttUs << ", p50 = " << l.rtt.p50
+                          << ", p99 = " << l.rtt.p99 << ", max = " << l.rtt.max
+                          << " (" << l.rtt.count << " muestras)" << std::endl;
+                std::cout << "Desfase de reloj TWS - local (ms): último = " << l.lastOffsetMs
+                          << ", mejor estimación = " << l.bestOffsetMs << std::endl;
+                std::cout << "Lector: inactivo " << l.readerIdleMs << " ms"
+                          << (l.readerStalled ? " (BLOQUEADO)" : "") << ", bloqueos = " << l.readerStalls << std::endl;
+                std::cout << "Enlace: sonda pendiente " << l.probeOutstandingMs << " ms"
+                          << (l.linkStalled ? " (SIN RESPUESTA)" : "") << ", bloqueos = " << l.linkStalls << std::endl;
+                break;
+            }
+            case 22: {
+                HistoricalQuery query;
+                std::string inicio, fin;
+                int enVuelo;
+                std::cout << "Ingrese el símbolo de la acción: ";
+                std::cin >> query.symbol;
+                std::cout << "Ingrese la fecha de inicio (YYYYMMDD): ";
+                std::cin >> inicio;
+                std::cout << "Ingrese la fecha de fin (YYYYMMDD): ";
+                std::cin >> fin;
+                std::cout << "Ingrese el tamaño de barra (ej. 1 min, 5 mins, 1 hour, 1 day): ";
+                std::cin >> std::ws;
+                std::getline(std::cin, query.barSize);
+                std::cout << "Ingrese el número de solicitudes en vuelo: ";
+                std::cin >> enVuelo;
+                query.start = parseIbDateTime(inicio);
+                query.end = parseIbDateTime(fin);
+                std::cout << "Espera estimada por límites de ritmo de IB: "
+                          << api.estimateHistoricalWait(query).count() / 1000.0 << " s" << std::endl;
+
+                HistoricalRangeResult r = api.get_historical_range(query, enVuelo);
+                std::cout << "Barras: " << r.bars.size() << " (desde caché: " << r.cachedBars << "), bloques: " << r.chunks
+                          << " (fallidos: " << r.failedChunks << "), " << r.seconds << " s, "
+                          << r.barsPerSecond << " barras/s" << std::endl;
+                if (!r.bars.empty()) {
+                    const bool diarias = barSizeSeconds(query.barSize) >= 86400;
+                    std::cout << "Primera: " << formatBarTime(r.bars.time.front(), diarias)
+                              << ", última: " << formatBarTime(r.bars.time.back(), diarias) << std::endl;
+                }
+                PacingStats p = api.getHistoricalPacingStats();
+                std::cout << "Ritmo: " << p.usedInWindow << "/60 en la ventana de 10 min, "
+                          << p.dispatched << " enviadas, " << p.delayed << " demoradas" << std::endl;
+                break;
+            }
+            case 23: {
+                std::string simbolo, inicio, fin, tipo;
+                std::cout << "Ingrese el símbolo de la acción: ";
+                std::cin >> simbolo;
+                std::cout << "Ingrese el inicio (YYYYMMDD-HH:MM:SS, UTC): ";
+                std::cin >> inicio;
+                std::cout << "Ingrese el fin (YYYYMMDD-HH:MM:SS, UTC): ";
+                std::cin >> fin;
+                std::cout << "Ingrese el tipo (TRADES, BID_ASK, MIDPOINT): ";
+                std::cin >> tipo;
+
+                HistoricalTicksResult r = api.get_historical_ticks(simbolo, parseIbDateTime(inicio),
+                                                                   parseIbDateTime(fin), tipo, false, 1 << 20);
+                const TickColumns& t = r.ticks;
+                std::cout << "Ticks: " << t.count() << ", páginas: " << r.pages << " (fallidas: " << r.failedPages
+                          << "), " << r.seconds << " s, " << r.ticksPerSecond << " ticks/s" << std::endl;
+                if (t.count() > 0) {
+                    std::cout << "Primero: " << formatIbDateTimeUtc(t.time.front()) << " " << t.price.front()
+                              << ", último: " << formatIbDateTimeUtc(t.time.back()) << " " << t.price.back() << std::endl;
+                    if (!t.exchanges.empty()) {
+                        std::cout << "Mercados:";
+                        for (const auto& ex : t.exchanges)
+                            std::cout << " " << ex;
+                        std::cout << std::endl;
+                    }
+                }
+                break;
+            }
+            case 24: {
+                std::string simbolo, duracion, barra;
+                int segundos;
+                std::cout << "Ingrese el símbolo de la acción: ";
+                std::cin >> simbolo;
+                std::cout << "Ingrese la duración del historial inicial (ej. 1 D): ";
+                std::cin >> std::ws;
+                std::getline(std::cin, duracion);
+                std::cout << "Ingrese el tamaño de barra (ej. 5 secs, 1 min): ";
+                std::getline(std::cin, barra);
+                std::cout << "Ingrese los segundos a seguir la serie: ";
+                std::cin >> segundos;
+
+                int id = api.subscribeLiveBars(simbolo, duracion, barra, "TRADES", true,
+                    [](const BarSeries& barras, size_t desde) {
+                        if (desde == 0)
+                            return;
+                        const HistoricalBar b = barras[barras.size() - 1];
+                        std::cout << (desde == barras.size() - 1 ? "Barra " : "Revisión ")
+                                  << formatBarTime(b.time, false) << ": C = " << b.close
+                                  << ", Volumen = " << b.volume << std::endl;
+                    });
+                if (id < 0)
+                    break;
+                std::this_thread::sleep_for(std::chrono::seconds(segundos));
+                api.withLiveBars(id, [](const LiveBarSeries& serie) {
+                    std::cout << serie.symbol << ": " << serie.bars.size() << " barras, "
+                              << serie.updates << " actualizaciones, " << serie.rolls << " barras nuevas" << std::endl;
+                });
+                api.cancelLiveBars(id);
+                break;
+            }
+            case 25: {
+                size_t barras, periodo;
+                std::cout << "Ingrese el número de barras: ";
+                std::cin >> barras;
+                std::cout << "Ingrese el periodo: ";
+                std::cin >> periodo;
+
+                std::cout << "SIMD disponible: " << simdLevelName(detectSimdLevel()) << std::endl;
+                std::cout << std::left << std::setw(8) << "Ind."
+                          << std::setw(12) << "ingenuo(ms)" << std::setw(12) << "escalar(ms)"
+                          << std::setw(10) << "AVX2(ms)" << std::setw(16) << "incremental(ms)"
+                          << "error max" << std::endl;
+                for (const IndicatorTiming& t : benchmarkIndicators(barras, periodo)) {
+                    std::cout << std::left << std::fixed << std::setprecision(2)
+                              << std::setw(8) << t.name << std::setw(12) << t.naiveMs
+                              << std::setw(12) << t.scalarMs << std::setw(10);
+                    if (t.simdMs < 0)
+                        std::cout << "-";
+                    else
+                        std::cout << t.simdMs;
+                    std::cout << std::setw(16) << t.incrementalMs
+                              << std::scientific << std::setprecision(1) << t.maxError
+                              << std::defaultfloat << std::endl;
+                }
+                break;
+            }
+            case 26: {
+                HistoricalQuery query;
+                std::string inicio, fin;
+                char completar;
+                std::cout << "Ingrese el símbolo de la acción: ";
+                std::cin >> query.symbol;
+                std::cout << "Ingrese la fecha de inicio (YYYYMMDD): ";
+                std::cin >> inicio;
+                std::cout << "Ingrese la fecha de fin (YYYYMMDD): ";
+                std::cin >> fin;
+                std::cout << "Ingrese el tamaño de barra (ej. 1 min, 5 mins, 1 hour, 1 day): ";
+                std::cin >> std::ws;
+                std::getline(std::cin, query.barSize);
+                query.start = parseIbDateTime(inicio);
+                query.end = parseIbDateTime(fin);
+
+                const time_t primero = api.get_head_timestamp(query.symbol, query.whatToShow, query.useRTH);
+                if (primero >= 0)
+                    std::cout << "Primer dato disponible: " << formatIbDateTimeUtc(primero) << " UTC" << std::endl;
+                std::vector<TimeRange> huecos = api.find_historical_gaps(query);
+                std::cout << "Huecos: " << huecos.size() << std::endl;
+                for (const auto& h : huecos)
+                    std::cout << "  " << formatIbDateTimeUtc(h.first) << " - " << formatIbDateTimeUtc(h.second) << std::endl;
+                if (huecos.empty())
+                    break;
+                std::cout << "¿Completar los huecos? (s/n): ";
+                std::cin >> completar;
+                if (completar != 's' && completar != 'S')
+                    break;
+                HistoricalRangeResult r = api.backfill_historical_gaps(query);
+                std::cout << "Barras recuperadas: " << r.bars.size() << ", bloques: " << r.chunks
+                          << " (fallidos: " << r.failedChunks << "), " << r.seconds << " s" << std::endl;
+                break;
+            }
+            case 27: {
+                std::string simbolo;
+                double precio, volatilidad;
+                std::cout << "Ingrese el símbolo del subyacente: ";
+                std::cin >> simbolo;
+                std::cout << "Ingrese el precio del subyacente: ";
+                std::cin >> precio;
+                std::cout << "Ingrese la volatilidad (ej. 0.25): ";
+                std::cin >> volatilidad;
+
+                std::shared_ptr<const OptionChain> cadena = api.get_option_chain(simbolo);
+                if (!cadena || cadena->empty()) {
+                    std::cout << "Cadena no disponible." << std::endl;
+                    break;
+                }
+                std::cout << "Vencimientos: " << cadena->expiries().size() << ", contratos: "
+                          << cadena->slotCount() << std::endl;
+                const std::vector<double> deltas = {0.10, 0.25, 0.50, 0.75, 0.90};
+                const size_t mostrar = std::min<size_t>(cadena->expiries().size(), 5);
+                for (size_t e = 0; e < mostrar; ++e) {
+                    const OptionChain::Expiry& v = cadena->expiry(e);
+                    std::cout << v.date << " (" << v.tradingClass << ", " << v.strikes.size() << " strikes): ATM "
+                              << v.strikes[cadena->atmStrike(e, precio)] << ", calls por delta:";
+                    for (size_t k : cadena->deltaBuckets(e, OptionRight::Call, deltas, precio, volatilidad, std::time(nullptr)))
+                        std::cout << " " << v.strikes[k];
+                    std::cout << std::endl;
+                }
+                break;
+            }
+            case 28: {
+                std::string simbolo;
+                int vencimiento, lineas;
+                std::cout << "Ingrese el símbolo del subyacente: ";
+                std::cin >> simbolo;
+                std::cout << "Ingrese el vencimiento (YYYYMMDD): ";
+                std::cin >> vencimiento;
+                std::cout << "Ingrese el número de líneas de datos simultáneas: ";
+                std::cin >> lineas;
+
+                std::shared_ptr<const OptionChain> cadena = api.get_option_chain(simbolo);
+                const long e = cadena ? cadena->findExpiry(vencimiento) : -1;
+                if (e < 0) {
+                    std::cout << "Vencimiento no encontrado." << std::endl;
+                    break;
+                }
+                std::vector<Contract> contratos;
+                for (size_t k = 0; k < cadena->expiry(e).strikes.size(); ++k) {
+                    contratos.push_back(api.createOptionContract(*cadena, e, k, OptionRight::Call));
+                    contratos.push_back(api.createOptionContract(*cadena, e, k, OptionRight::Put));
+                }
+                OptionSnapshotResult r = api.get_option_snapshots(contratos, lineas);
+                std::cout << "Contratos: " << r.snapshots.size() << ", completos: " << r.completed
+                          << ", rechazados: " << r.failed << ", " << r.seconds << " s" << std::endl;
+                for (const OptionSnapshot& q : r.snapshots) {
+                    if (q.complete)
+                        std::cout << q.symbol << ": " << q.bid << " x " << q.ask
+                                  << ", IV = " << q.model.impliedVol << ", delta = " << q.model.delta << std::endl;
+                }
+                break;
+            }
+            case 29: {
+                int segundos;
+                std::cout << "Ingrese los segundos de espera para recibir griegas: ";
+                std::cin >> segundos;
+
+                std::vector<int> tickers;
+                for (const Position& p : api.list_positions()) {
+                    // Las posiciones en opciones vienen con el símbolo OCC (contiene dígitos).
+                    if (p.symbol.find_first_of("0123456789") == std::string::npos)
+                        continue;
+                    const int id = api.requestOptionMarketData(p.symbol);
+                    if (id >= 0)
+                        tickers.push_back(id);
+                }
+                std::this_thread::sleep_for(std::chrono::seconds(segundos));
+                PortfolioGreeks g = api.getPortfolioGreeks();
+                for (int id : tickers)
+                    api.cancelMarketData(id);
+
+                std::cout << "Posiciones: " << g.positions << " (opciones sin griegas: "
+                          << g.positionsWithoutGreeks << ")" << std::endl;
+                auto imprimir = [](const std::string& nombre, const Greeks& x) {
+                    std::cout << std::left << std::setw(8) << nombre << " delta = " << x.delta << ", gamma = " << x.gamma
+                              << ", vega = " << x.vega << ", theta = " << x.theta << std::endl;
+                };
+                for (const auto& [subyacente, x] : g.underlyings)
+                    imprimir(subyacente, x);
+                imprimir("Total", g.book);
+                break;
+            }
+            case 30: {
+                std::string simbolo;
+                int desde, hasta, lineas;
+                double tasa;
+                std::cout << "Ingrese el símbolo del subyacente: ";
+                std::cin >> simbolo;
+                std::cout << "Ingrese el primer vencimiento (YYYYMMDD): ";
+                std::cin >> desde;
+                std::cout << "Ingrese el último vencimiento (YYYYMMDD): ";
+                std::cin >> hasta;
+                std::cout << "Ingrese la tasa libre de riesgo (ej. 0.04): ";
+                std::cin >> tasa;
+                std::cout << "Ingrese el número de líneas de datos simultáneas: ";
+                std::cin >> lineas;
+
+                ChainGreeks g = api.get_chain_greeks(simbolo, desde, hasta, tasa, 0.0, lineas);
+                std::shared_ptr<const OptionChain> cadena = api.get_option_chain(simbolo);
+                if (!cadena || g.iv.size() != cadena->slotCount()) {
+                    std::cout << "Cadena no disponible." << std::endl;
+                    break;
+                }
+                std::cout << "Valoradas: " << g.priced << ", sin volatilidad: " << g.failed << ", "
+                          << g.optionsPerSecond << " opciones/s" << std::endl;
+                for (size_t s = 0; s < g.iv.size(); ++s) {
+                    if (!std::isfinite(g.iv[s]))
+                        continue;
+                    const OptionKey k = cadena->key(s);
+                    std::cout << cadena->occSymbol(k.expiry, k.strike, k.right) << ": IV = " << g.iv[s]
+                              << ", delta = " << g.delta[s] << ", gamma = " << g.gamma[s]
+                              << ", vega = " << g.vega[s] << ", theta = " << g.theta[s] << std::endl;
+                }
+                break;
+            }
+            case 31: {
+                size_t vencimientos, strikes;
+                std::cout << "Ingrese el número de vencimientos: ";
+                std::cin >> vencimientos;
+                std::cout << "Ingrese el número de strikes por vencimiento: ";
+                std::cin >> strikes;
+
+                std::cout << "SIMD disponible: " << simdLevelName(detectSimdLevel()) << std::endl;
+                std::cout << std::left << std::setw(16) << "Cálculo" << std::setw(14) << "ingenuo(op/s)"
+                          << std::setw(14) << "escalar(op/s)" << std::setw(12) << "AVX2(op/s)"
+                          << std::setw(14) << "hilos(op/s)" << "error max" << std::endl;
+                for (const PricingTiming& t : benchmarkPricing(vencimientos, strikes)) {
+                    std::cout << std::left << std::fixed << std::setprecision(0)
+                              << std::setw(16) << t.name << std::setw(14) << t.naivePerSecond
+                              << std::setw(14) << t.scalarPerSecond << std::setw(12);
+                    if (t.simdPerSecond < 0)
+                        std::cout << "-";
+                    else
+                        std::cout << t.simdPerSecond;
+                    std::cout << std::setw(14) << t.threadedPerSecond
+                              << std::scientific << std::setprecision(1) << t.maxError
+                              << std::defaultfloat << std::endl;
+                }
+                break;
+            }
+            case 32: {
+                std::string simbolo;
+                int desde, hasta;
+                std::cout << "Ingrese el símbolo del subyacente: ";
+                std::cin >> simbolo;
+                std::cout << "Ingrese el primer vencimiento (YYYYMMDD): ";
+                std::cin >> desde;
+                std::cout << "Ingrese el último vencimiento (YYYYMMDD): ";
+                std::cin >> hasta;
+
+                std::shared_ptr<VolSurface> superficie = api.get_vol_surface(simbolo);
+                if (!superficie) {
+                    std::cout << "Cadena no disponible." << std::endl;
+                    break;
+                }
+                api.get_chain_greeks(simbolo, desde, hasta);  // alimenta la superficie
+                std::shared_ptr<const VolSurfaceSnapshot> s = superficie->snapshot();
+                const std::vector<double> moneyness = {0.8, 0.9, 1.0, 1.1, 1.2};
+                const std::vector<double> plazos = {1.0 / 12, 0.25, 0.5, 1.0};
+                std::cout << "Spot: " << s->spot << ", sonrisas ajustadas: " << superficie->refits() << std::endl;
+                std::cout << std::left << std::setw(10) << "Plazo";
+                for (double m : moneyness)
+                    std::cout << std::setw(9) << m;
+                std::cout << std::endl;
+                for (double t : plazos) {
+                    std::cout << std::left << std::fixed << std::setprecision(3) << std::setw(10) << t;
+                    for (double m : moneyness)
+                        std::cout << std::setw(9) << s->vol(m, t);
+                    std::cout << std::defaultfloat << std::endl;
+                }
+                break;
+            }
+            case 33: {
+                if (!api.subscribe_account_updates()) {
+                    std::cout << "No se pudo suscribir a la cuenta." << std::endl;
+                    break;
+                }
+                std::shared_ptr<const AccountSnapshot> cuenta = api.getAccountState();
+                std::cout << "Cuenta " << cuenta->account << " (" << cuenta->updateTime << ")" << std::endl
+                          << "  Liquidación neta: " << cuenta->netLiquidation << std::endl
+                          << "  Efectivo: " << cuenta->totalCashValue << std::endl
+                          << "  Poder de compra: " << cuenta->buyingPower << std::endl
+                          << "  Margen inicial / de mantenimiento: " << cuenta->initMarginReq
+                          << " / " << cuenta->maintMarginReq << std::endl
+                          << "  Exceso de liquidez: " << cuenta->excessLiquidity << std::endl
+                          << "  PnL no realizado / realizado: " << cuenta->unrealizedPnl
+                          << " / " << cuenta->realizedPnl << std::endl;
+                for (const PortfolioRow& fila : *cuenta->portfolio) {
+                    std::cout << "  " << std::left << std::setw(22) << fila.symbol << std::right
+                              << " pos=" << fila.position << " precio=" << fila.marketPrice
+                              << " valor=" << fila.marketValue << " costo=" << fila.averageCost
+                              << " pnl=" << fila.unrealizedPnl << "/" << fila.realizedPnl << std::endl;
+                }
+                break;
+            }
+            case 34: {
+                if (!api.subscribe_pnl()) {
+                    std::cout << "No se pudo suscribir al PnL." << std::endl;
+                    break;
+                }
+                double umbral = 0.0;
+                std::cout << "Umbral de pérdida diaria de la cuenta para alertar (0 = ninguno): ";
+                std::cin >> umbral;
+                if (umbral != 0.0) {
+                    PnlAlert alerta;
+                    alerta.threshold = -std::fabs(umbral);
+                    api.addPnlAlert(alerta, [](const PnlAlert& a, double valor) {
+                        std::cout << "\nALERTA: PnL diario " << valor << " <= " << a.threshold << std::endl;
+                    });
+                }
+                std::this_thread::sleep_for(std::chrono::seconds(2));  // primeras actualizaciones
+                std::shared_ptr<const PnlSnapshot> pnl = api.getPnl();
+                std::cout << "Cuenta: diario=" << pnl->account.dailyPnl
+                          << " no realizado=" << pnl->account.unrealizedPnl
+                          << " realizado=" << pnl->account.realizedPnl << std::endl;
+                for (const PositionPnl& p : *pnl->positions) {
+                    std::cout << "  " << std::left << std::setw(22) << p.symbol << std::right
+                              << " pos=" << p.position << " valor=" << p.value
+                              << " diario=" << p.pnl.dailyPnl << " no realizado=" << p.pnl.unrealizedPnl
+                              << " realizado=" << p.pnl.realizedPnl << std::endl;
+                }
+                break;
+            }
             case 0:
                 ejecutando = false;
                 break;
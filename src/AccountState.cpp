@@ -0,0 +1,173 @@
+#include "AccountState.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+struct TypedKey {
+    const char* key;
+    double AccountSnapshot::*field;
+};
+
+constexpr TypedKey kTypedKeys[] = {
+    {"NetLiquidation", &AccountSnapshot::netLiquidation},
+    {"TotalCashValue", &AccountSnapshot::totalCashValue},
+    {"SettledCash", &AccountSnapshot::settledCash},
+    {"BuyingPower", &AccountSnapshot::buyingPower},
+    {"AvailableFunds", &AccountSnapshot::availableFunds},
+    {"ExcessLiquidity", &AccountSnapshot::excessLiquidity},
+    {"InitMarginReq", &AccountSnapshot::initMarginReq},
+    {"MaintMarginReq", &AccountSnapshot::maintMarginReq},
+    {"GrossPositionValue", &AccountSnapshot::grossPositionValue},
+    {"EquityWithLoanValue", &AccountSnapshot::equityWithLoanValue},
+    {"UnrealizedPnL", &AccountSnapshot::unrealizedPnl},
+    {"RealizedPnL", &AccountSnapshot::realizedPnl},
+    {"Cushion", &AccountSnapshot::cushion},
+};
+
+double parseNumber(const std::string& text) {
+    if (text.empty())
+        return std::numeric_limits<double>::quiet_NaN();
+    char* end = nullptr;
+    const double v = std::strtod(text.c_str(), &end);
+    return *end == '\0' ? v : std::numeric_limits<double>::quiet_NaN();
+}
+
+bool valueLess(const AccountValue& v, const std::string& key, const std::string& currency) {
+    return v.key != key ? v.key < key : v.currency < currency;
+}
+
+} // namespace
+
+const AccountValue* AccountSnapshot::value(const std::string& key, const std::string& currency) const {
+    if (!values)
+        return nullptr;
+    auto it = std::lower_bound(values->begin(), values->end(), 0, [&](const AccountValue& v, int) {
+        return valueLess(v, key, currency);
+    });
+    return it != values->end() && it->key == key && it->currency == currency ? &*it : nullptr;
+}
+
+const PortfolioRow* AccountSnapshot::row(const std::string& symbol) const {
+    if (!portfolio)
+        return nullptr;
+    auto it = std::lower_bound(portfolio->begin(), portfolio->end(), symbol,
+                               [](const PortfolioRow& r, const std::string& s) { return r.symbol < s; });
+    return it != portfolio->end() && it->symbol == symbol ? &*it : nullptr;
+}
+
+AccountState::AccountState() {
+    reset("");
+}
+
+// Called with m_mutex held.
+bool AccountState::accepts(const std::string& account) const {
+    return m_account.empty() || account.empty() || account == m_account;
+}
+
+// Called with m_mutex held. The tables stay shared until the caller replaces one.
+std::shared_ptr<AccountSnapshot> AccountState::copy() const {
+    return std::make_shared<AccountSnapshot>(*m_snapshot.load(std::memory_order_relaxed));
+}
+
+// Called with m_mutex held.
+void AccountState::publish(std::shared_ptr<AccountSnapshot> next) {
+    m_snapshot.store(std::move(next), std::memory_order_release);
+}
+
+void AccountState::reset(const std::string& account) {
+    auto next = std::make_shared<AccountSnapshot>();
+    next->account = account;
+    next->values = std::make_shared<const std::vector<AccountValue>>();
+    next->portfolio = std::make_shared<const std::vector<PortfolioRow>>();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_account = account;
+    m_typedCurrency.clear();
+    publish(std::move(next));
+}
+
+void AccountState::setValue(const std::string& key, const std::string& text, const std::string& currency,
+                            const std::string& account) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!accepts(account))
+        return;
+    const auto snapshot = m_snapshot.load(std::memory_order_relaxed);
+    const auto& current = *snapshot->values;
+    auto it = std::lower_bound(current.begin(), current.end(), 0, [&](const AccountValue& v, int) {
+        return valueLess(v, key, currency);
+    });
+    const bool found = it != current.end() && it->key == key && it->currency == currency;
+    if (found && it->text == text)
+        return;  // TWS resends unchanged values every few minutes
+
+    AccountValue entry{key, currency, text, parseNumber(text)};
+    auto values = std::make_shared<std::vector<AccountValue>>(current);
+    const size_t i = static_cast<size_t>(it - current.begin());
+    if (found)
+        (*values)[i] = entry;
+    else
+        values->insert(values->begin() + static_cast<std::ptrdiff_t>(i), entry);
+
+    auto next = copy();
+    next->values = std::move(values);
+    if (next->account.empty())
+        next->account = account;
+    for (const TypedKey& typed : kTypedKeys) {
+        if (key != typed.key)
+            continue;
+        // BASE wins over a currency; otherwise the first currency reported keeps the field.
+        auto source = m_typedCurrency.emplace(key, currency).first;
+        if (currency == "BASE" || currency.empty())
+            source->second = currency;
+        if (source->second == currency)
+            next.get()->*typed.field = entry.number;
+        break;
+    }
+    publish(std::move(next));
+}
+
+void AccountState::setPortfolio(const PortfolioRow& row, const std::string& account) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!accepts(account))
+        return;
+    const auto snapshot = m_snapshot.load(std::memory_order_relaxed);
+    const auto& current = *snapshot->portfolio;
+    auto it = std::lower_bound(current.begin(), current.end(), row.symbol,
+                               [](const PortfolioRow& r, const std::string& s) { return r.symbol < s; });
+    const bool found = it != current.end() && it->symbol == row.symbol;
+    if (!found && row.position == 0.0)
+        return;
+
+    auto rows = std::make_shared<std::vector<PortfolioRow>>(current);
+    const auto pos = rows->begin() + (it - current.begin());
+    if (row.position == 0.0)
+        rows->erase(pos);
+    else if (found)
+        *pos = row;
+    else
+        rows->insert(pos, row);
+
+    auto next = copy();
+    next->portfolio = std::move(rows);
+    publish(std::move(next));
+}
+
+void AccountState::setTime(const std::string& time) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto next = copy();
+    next->updateTime = time;
+    publish(std::move(next));
+}
+
+void AccountState::setStreaming(bool streaming, const std::string& account) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!accepts(account))
+        return;
+    auto next = copy();
+    next->streaming = streaming;
+    if (next->account.empty())
+        next->account = account;
+    publish(std::move(next));
+}
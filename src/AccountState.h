@@ -0,0 +1,97 @@
+#ifndef ACCOUNT_STATE_H
+#define ACCOUNT_STATE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One updateAccountValue pair. `number` is the value parsed once on arrival (NaN if the value
+// is not numeric, e.g. AccountType).
+struct AccountValue {
+    std::string key;
+    std::string currency;  // "BASE", an ISO code, or empty
+    std::string text;
+    double number = 0.0;
+};
+
+// One updatePortfolio row.
+struct PortfolioRow {
+    std::string symbol;    // stock ticker or OCC symbol, as in Position
+    long conId = 0;
+    std::string secType;
+    double position = 0.0;
+    double marketPrice = 0.0;
+    double marketValue = 0.0;
+    double averageCost = 0.0;
+    double unrealizedPnl = 0.0;
+    double realizedPnl = 0.0;
+};
+
+// Immutable state of the subscribed account. Once a reader holds it through a shared_ptr it
+// reads it without any synchronization while AccountState publishes newer versions.
+struct AccountSnapshot {
+    std::string account;
+    std::string updateTime;   // HH:MM of the last updateAccountTime
+    bool streaming = false;   // accountDownloadEnd arrived and the subscription is still open
+
+    // The common keys, in the base currency (or the account's only currency when TWS sends no
+    // BASE value for the key). 0 until reported.
+    double netLiquidation = 0.0;
+    double totalCashValue = 0.0;
+    double settledCash = 0.0;
+    double buyingPower = 0.0;
+    double availableFunds = 0.0;
+    double excessLiquidity = 0.0;
+    double initMarginReq = 0.0;
+    double maintMarginReq = 0.0;
+    double grossPositionValue = 0.0;
+    double equityWithLoanValue = 0.0;
+    double unrealizedPnl = 0.0;
+    double realizedPnl = 0.0;
+    double cushion = 0.0;
+
+    // Every key/currency pair, sorted by key then currency, and the open positions sorted by
+    // symbol. Both are shared with the previous snapshot while they do not change.
+    std::shared_ptr<const std::vector<AccountValue>> values;
+    std::shared_ptr<const std::vector<PortfolioRow>> portfolio;
+
+    const AccountValue* value(const std::string& key, const std::string& currency = "BASE") const;
+    const PortfolioRow* row(const std::string& symbol) const;
+};
+
+// Account state streamed by reqAccountUpdates. The callbacks feed it one pair or row at a
+// time; each change publishes a new snapshot that copies only the table it touched. Writers
+// serialize on a mutex (in practice the account dispatch thread is the only one); readers
+// never take it. Reading is mutex-free but not lock-free: libstdc++ (GCC 12) implements
+// std::atomic<std::shared_ptr> with a short spinlock in the pointer, held by load() and
+// store() only for the reference count update, never while a snapshot is being built.
+class AccountState {
+public:
+    AccountState();
+
+    std::shared_ptr<const AccountSnapshot> snapshot() const { return m_snapshot.load(std::memory_order_acquire); }
+
+    // Forgets everything and accepts updates for `account` only (any account if empty).
+    void reset(const std::string& account);
+    void setValue(const std::string& key, const std::string& text, const std::string& currency,
+                  const std::string& account);
+    // Rows with a zero position are removed.
+    void setPortfolio(const PortfolioRow& row, const std::string& account);
+    void setTime(const std::string& time);
+    void setStreaming(bool streaming, const std::string& account);
+
+private:
+    bool accepts(const std::string& account) const;
+    void publish(std::shared_ptr<AccountSnapshot> next);
+    std::shared_ptr<AccountSnapshot> copy() const;
+
+    std::mutex m_mutex;  // guards the members below
+    std::string m_account;
+    std::unordered_map<std::string, std::string> m_typedCurrency;  // key -> currency in the typed field
+    std::atomic<std::shared_ptr<const AccountSnapshot>> m_snapshot;
+};
+
+#endif // ACCOUNT_STATE_H
@@ -0,0 +1,46 @@
+#ifndef ASYNC_REQUEST_H
+#define ASYNC_REQUEST_H
+
+#include <chrono>
+#include <coroutine>
+#include <functional>
+#include <utility>
+
+#include "Executor.h"
+#include "RequestRegistry.h"
+
+// co_await-able TWS request: registers reqId in the registry, sends the request and suspends
+// until its End callback, error or timeout. The coroutine is resumed on the executor.
+class RequestAwaiter {
+public:
+    RequestAwaiter(RequestRegistry& registry, Executor& executor, int reqId,
+                   std::chrono::milliseconds timeout, std::function<void()> send)
+        : m_registry(registry), m_executor(executor), m_reqId(reqId),
+          m_timeout(timeout), m_send(std::move(send)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        // The handler may resume (and destroy) this awaiter before send() returns, so nothing
+        // below the registration may touch members.
+        auto send = std::move(m_send);
+        Executor& executor = m_executor;
+        m_registry.add(m_reqId, m_timeout, [this, handle, &executor](const RequestResult& result) {
+            m_result = result;
+            executor.post(handle);
+        });
+        send();
+    }
+
+    RequestResult await_resume() { return std::move(m_result); }
+
+private:
+    RequestRegistry& m_registry;
+    Executor& m_executor;
+    int m_reqId;
+    std::chrono::milliseconds m_timeout;
+    std::function<void()> m_send;
+    RequestResult m_result;
+};
+
+#endif // ASYNC_REQUEST_H
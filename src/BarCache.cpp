@@ -0,0 +1,264 @@
+#include "BarCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'T', 'W', 'S', 'B', 'A', 'R', 'S', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kMaxCoverage = 256;  // oldest ranges are forgotten (and refetched) beyond this
+
+// Fixed-size header followed by six column arrays of `count` 8-byte values each, in the order
+// time, open, high, low, close, volume.
+struct BarFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t coverageCount;
+    uint64_t count;
+    int64_t coverage[kMaxCoverage][2];
+};
+static_assert(sizeof(BarFileHeader) % 8 == 0, "columns must stay 8-byte aligned");
+
+// Coverage is a fixed-size table in the header.
+std::vector<TimeRange> mergeCoverage(std::vector<TimeRange> ranges) {
+    std::vector<TimeRange> merged = mergeRanges(std::move(ranges));
+    if (merged.size() > kMaxCoverage)
+        merged.erase(merged.begin(), merged.end() - kMaxCoverage);
+    return merged;
+}
+
+} // namespace
+
+// A read-only mapping of one cache file.
+class MappedBarFile {
+public:
+    static std::shared_ptr<const MappedBarFile> open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return nullptr;
+        struct stat st{};
+        if (::fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(BarFileHeader)) {
+            ::close(fd);
+            return nullptr;
+        }
+        void* base = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);  // the mapping keeps the file open
+        if (base == MAP_FAILED)
+            return nullptr;
+
+        std::shared_ptr<MappedBarFile> file(new MappedBarFile(base, static_cast<size_t>(st.st_size)));
+        const BarFileHeader& h = file->header();
+        if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion ||
+            h.coverageCount > kMaxCoverage ||
+            file->m_size < sizeof(BarFileHeader) + h.count * 6 * sizeof(int64_t)) {
+            std::cerr << "error at BarCache: ignoring invalid cache file " << path << std::endl;
+            return nullptr;
+        }
+        return file;
+    }
+
+    ~MappedBarFile() { ::munmap(m_base, m_size); }
+
+    MappedBarFile(const MappedBarFile&) = delete;
+    MappedBarFile& operator=(const MappedBarFile&) = delete;
+
+    const BarFileHeader& header() const { return *static_cast<const BarFileHeader*>(m_base); }
+    size_t count() const { return static_cast<size_t>(header().count); }
+
+    // Column i (0 = time ... 5 = volume) as raw 8-byte values.
+    const char* column(int i) const {
+        return static_cast<const char*>(m_base) + sizeof(BarFileHeader) + static_cast<size_t>(i) * count() * 8;
+    }
+    const int64_t* time() const { return reinterpret_cast<const int64_t*>(column(0)); }
+
+    std::vector<TimeRange> coverage() const {
+        std::vector<TimeRange> ranges;
+        for (uint32_t i = 0; i < header().coverageCount; ++i)
+            ranges.emplace_back(static_cast<time_t>(header().coverage[i][0]),
+                                static_cast<time_t>(header().coverage[i][1]));
+        return ranges;
+    }
+
+private:
+    MappedBarFile(void* base, size_t size) : m_base(base), m_size(size) {}
+
+    void* m_base;
+    size_t m_size;
+};
+
+BarCache::BarCache(std::string directory) : m_directory(std::move(directory)) {
+    ::mkdir(m_directory.c_str(), 0755);
+}
+
+std::string BarCache::pathFor(const HistoricalQuery& query) const {
+    std::string name = query.symbol + "_" + query.barSize + "_" + query.whatToShow + (query.useRTH ? "_rth" : "_all");
+    for (char& c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.')
+            c = '_';
+    }
+    return m_directory + "/" + name + ".bars";
+}
+
+// Called with m_mutex held.
+std::shared_ptr<const MappedBarFile> BarCache::mapped(const std::string& path) {
+    auto it = m_files.find(path);
+    if (it != m_files.end())
+        return it->second;
+    auto file = MappedBarFile::open(path);
+    if (file)
+        m_files[path] = file;
+    return file;
+}
+
+BarSlice BarCache::read(const HistoricalQuery& query, std::vector<TimeRange>* missing) {
+    std::shared_ptr<const MappedBarFile> file;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        file = mapped(pathFor(query));
+    }
+
+    if (missing) {
+        *missing = subtractRanges({query.start, query.end},
+                                  file ? file->coverage() : std::vector<TimeRange>{});
+    }
+
+    BarSlice slice;
+    if (!file)
+        return slice;
+    const int64_t* begin = file->time();
+    const int64_t* end = begin + file->count();
+    const int64_t* first = std::lower_bound(begin, end, static_cast<int64_t>(query.start));
+    const int64_t* last = std::lower_bound(first, end, static_cast<int64_t>(query.end));
+    const size_t offset = static_cast<size_t>(first - begin);
+
+    slice.file = file;
+    slice.count = static_cast<size_t>(last - first);
+    slice.time = first;
+    slice.open = reinterpret_cast<const double*>(file->column(1)) + offset;
+    slice.high = reinterpret_cast<const double*>(file->column(2)) + offset;
+    slice.low = reinterpret_cast<const double*>(file->column(3)) + offset;
+    slice.close = reinterpret_cast<const double*>(file->column(4)) + offset;
+    slice.volume = reinterpret_cast<const int64_t*>(file->column(5)) + offset;
+    return slice;
+}
+
+bool BarCache::store(const HistoricalQuery& query, const TimeRange& covered, const BarSeries& bars) {
+    std::lock_guard<std::mutex> lock(m_mutex);  // one writer at a time per cache
+    const std::string path = pathFor(query);
+    std::shared_ptr<const MappedBarFile> old = mapped(path);
+
+    // Merge by timestamp: existing bars first, then the new ones overwrite on collisions.
+    struct Row { double open, high, low, close; int64_t volume; };
+    std::map<int64_t, Row> rows;
+    std::vector<TimeRange> coverage;
+    if (old) {
+        const size_t n = old->count();
+        const int64_t* t = old->time();
+        const double* o = reinterpret_cast<const double*>(old->column(1));
+        const double* h = reinterpret_cast<const double*>(old->column(2));
+        const double* l = reinterpret_cast<const double*>(old->column(3));
+        const double* c = reinterpret_cast<const double*>(old->column(4));
+        const int64_t* v = reinterpret_cast<const int64_t*>(old->column(5));
+        for (size_t i = 0; i < n; ++i)
+            rows[t[i]] = Row{o[i], h[i], l[i], c[i], v[i]};
+        coverage = old->coverage();
+    }
+    for (size_t i = 0; i < bars.size(); ++i)
+        rows[bars.time[i]] = Row{bars.open[i], bars.high[i], bars.low[i], bars.close[i], bars.volume[i]};
+    coverage.push_back(covered);
+    coverage = mergeCoverage(std::move(coverage));
+
+    auto header = std::make_unique<BarFileHeader>();
+    std::memset(header.get(), 0, sizeof(BarFileHeader));
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+    header->version = kVersion;
+    header->count = rows.size();
+    header->coverageCount = static_cast<uint32_t>(coverage.size());
+    for (size_t i = 0; i < coverage.size(); ++i) {
+        header->coverage[i][0] = static_cast<int64_t>(coverage[i].first);
+        header->coverage[i][1] = static_cast<int64_t>(coverage[i].second);
+    }
+
+    std::vector<int64_t> t;
+    std::vector<double> o, h, l, c;
+    std::vector<int64_t> v;
+    t.reserve(rows.size()); o.reserve(rows.size()); h.reserve(rows.size());
+    l.reserve(rows.size()); c.reserve(rows.size()); v.reserve(rows.size());
+    for (const auto& [time, row] : rows) {
+        t.push_back(time);
+        o.push_back(row.open);
+        h.push_back(row.high);
+        l.push_back(row.low);
+        c.push_back(row.close);
+        v.push_back(row.volume);
+    }
+
+    // Write a sibling file and rename it over the old one, so readers never see a torn file
+    // and existing mappings keep the previous contents until they are released.
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(header.get()), sizeof(BarFileHeader));
+        auto writeColumn = [&out](const auto& column) {
+            out.write(reinterpret_cast<const char*>(column.data()),
+                      static_cast<std::streamsize>(column.size() * sizeof(column[0])));
+        };
+        writeColumn(t); writeColumn(o); writeColumn(h); writeColumn(l); writeColumn(c); writeColumn(v);
+        if (!out) {
+            std::cerr << "error at BarCache::store: cannot write " << tmp << std::endl;
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "error at BarCache::store: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    m_files.erase(path);  // remapped on next use; slices of the old mapping stay valid
+    return true;
+}
+
+time_t BarCache::headTimestamp(const std::string& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_headTimestampsLoaded) {
+        m_headTimestampsLoaded = true;
+        // One "key<TAB>epoch" line per entry; keys may contain spaces ("BRK B").
+        std::ifstream in(m_directory + "/head_timestamps.txt");
+        for (std::string line; std::getline(in, line);) {
+            const size_t tab = line.rfind('\t');
+            if (tab != std::string::npos)
+                m_headTimestamps[line.substr(0, tab)] = static_cast<time_t>(std::atoll(line.c_str() + tab + 1));
+        }
+    }
+    auto it = m_headTimestamps.find(key);
+    return it == m_headTimestamps.end() ? -1 : it->second;
+}
+
+void BarCache::storeHeadTimestamp(const std::string& key, time_t t) {
+    headTimestamp(key);  // loads the file first, so existing entries are kept
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_headTimestamps[key] = t;
+    const std::string path = m_directory + "/head_timestamps.txt";
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        for (const auto& [k, v] : m_headTimestamps)
+            out << k << '\t' << static_cast<long long>(v) << '\n';
+        if (!out) {
+            std::cerr << "error at BarCache::storeHeadTimestamp: cannot write " << tmp << std::endl;
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+        std::cerr << "error at BarCache::storeHeadTimestamp: " << std::strerror(errno) << std::endl;
+}
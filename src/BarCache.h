@@ -0,0 +1,57 @@
+#ifndef BAR_CACHE_H
+#define BAR_CACHE_H
+
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BarSeries.h"
+#include "HistoricalPlanner.h"
+
+class MappedBarFile;
+
+// Cached bars within the requested window. The slice keeps its file mapping alive, so it
+// stays valid even if the cache is rewritten meanwhile.
+struct BarSlice : BarView {
+    std::shared_ptr<const MappedBarFile> file;
+};
+
+// On-disk cache of historical bars, one memory-mapped file per (symbol, bar size, whatToShow,
+// useRTH). Files are columnar (time, open, high, low, close, volume arrays) and also record
+// which time ranges were fully fetched, so gaps in the data (weekends, halts) are not
+// mistaken for missing ranges. Files use native byte order and are replaced atomically.
+class BarCache {
+public:
+    explicit BarCache(std::string directory);
+
+    // Cached bars within [query.start, query.end) and the parts of that window never fetched.
+    BarSlice read(const HistoricalQuery& query, std::vector<TimeRange>* missing = nullptr);
+
+    // Merges bars into the file (newer values win on equal timestamps) and marks `covered`
+    // as fetched. Returns false if the file could not be written.
+    bool store(const HistoricalQuery& query, const TimeRange& covered, const BarSeries& bars);
+
+    // Earliest available data per contract and whatToShow (see TwsApi::get_head_timestamp),
+    // kept in <directory>/head_timestamps.txt. Returns -1 if unknown.
+    time_t headTimestamp(const std::string& key);
+    void storeHeadTimestamp(const std::string& key, time_t t);
+
+    const std::string& directory() const { return m_directory; }
+
+private:
+    std::string pathFor(const HistoricalQuery& query) const;
+    std::shared_ptr<const MappedBarFile> mapped(const std::string& path);
+
+    std::string m_directory;
+    std::mutex m_mutex;
+    std::map<std::string, std::shared_ptr<const MappedBarFile>> m_files;  // keyed by path
+    std::map<std::string, time_t> m_headTimestamps;
+    bool m_headTimestampsLoaded = false;
+};
+
+#endif // BAR_CACHE_H
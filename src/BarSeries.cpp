@@ -0,0 +1,102 @@
+#include "BarSeries.h"
+
+#include <algorithm>
+#include <ctime>
+#include <numeric>
+
+BarView BarView::slice(size_t from, size_t to) const {
+    to = std::min(to, count);
+    from = std::min(from, to);
+    BarView v;
+    v.time = time + from;
+    v.open = open + from;
+    v.high = high + from;
+    v.low = low + from;
+    v.close = close + from;
+    v.volume = volume + from;
+    v.count = to - from;
+    return v;
+}
+
+BarView BarView::between(int64_t start, int64_t end) const {
+    const int64_t* first = std::lower_bound(time, time + count, start);
+    const int64_t* last = std::lower_bound(first, time + count, std::max(start, end));
+    return slice(static_cast<size_t>(first - time), static_cast<size_t>(last - time));
+}
+
+void BarSeries::reserve(size_t n) {
+    time.reserve(n);
+    open.reserve(n);
+    high.reserve(n);
+    low.reserve(n);
+    close.reserve(n);
+    volume.reserve(n);
+}
+
+void BarSeries::clear() {
+    truncate(0);
+}
+
+void BarSeries::truncate(size_t n) {
+    if (n >= size())
+        return;
+    time.resize(n);
+    open.resize(n);
+    high.resize(n);
+    low.resize(n);
+    close.resize(n);
+    volume.resize(n);
+}
+
+void BarSeries::append(const BarView& bars) {
+    time.insert(time.end(), bars.time, bars.time + bars.count);
+    open.insert(open.end(), bars.open, bars.open + bars.count);
+    high.insert(high.end(), bars.high, bars.high + bars.count);
+    low.insert(low.end(), bars.low, bars.low + bars.count);
+    close.insert(close.end(), bars.close, bars.close + bars.count);
+    volume.insert(volume.end(), bars.volume, bars.volume + bars.count);
+}
+
+void BarSeries::normalize() {
+    const size_t n = size();
+    bool sorted = true;
+    for (size_t i = 1; i < n && sorted; ++i)
+        sorted = time[i - 1] < time[i];
+    if (sorted)
+        return;  // the common case: chunks arrive in order and do not overlap
+
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return time[a] < time[b]; });
+
+    BarSeries out;
+    out.reserve(n);
+    for (size_t k = 0; k < n; ++k) {
+        // Stable order puts the last-appended duplicate at the end of its run.
+        if (k + 1 < n && time[order[k + 1]] == time[order[k]])
+            continue;
+        out.push_back((*this)[order[k]]);
+    }
+    *this = std::move(out);
+}
+
+BarView BarSeries::view() const {
+    BarView v;
+    v.time = time.data();
+    v.open = open.data();
+    v.high = high.data();
+    v.low = low.data();
+    v.close = close.data();
+    v.volume = volume.data();
+    v.count = size();
+    return v;
+}
+
+std::string formatBarTime(int64_t time, bool daily) {
+    const time_t t = static_cast<time_t>(time);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), daily ? "%Y%m%d" : "%Y%m%d %H:%M:%S", &tm);
+    return buf;
+}
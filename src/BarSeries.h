@@ -0,0 +1,82 @@
+#ifndef BAR_SERIES_H
+#define BAR_SERIES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One bar, as delivered by historicalData. The time is parsed once on arrival.
+struct HistoricalBar {
+    int64_t time = 0;      // UTC epoch seconds (bar start; daily bars are midnight UTC of the date)
+    double open = 0.0;
+    double high = 0.0;
+    double low = 0.0;
+    double close = 0.0;
+    int64_t volume = 0;
+};
+
+// Non-owning window onto bar columns, one pointer per column. Copying or slicing a view never
+// touches the bars themselves. A view of a BarSeries is invalidated when the series grows.
+struct BarView {
+    const int64_t* time = nullptr;   // ascending
+    const double* open = nullptr;
+    const double* high = nullptr;
+    const double* low = nullptr;
+    const double* close = nullptr;
+    const int64_t* volume = nullptr;
+    size_t count = 0;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    HistoricalBar operator[](size_t i) const {
+        return HistoricalBar{time[i], open[i], high[i], low[i], close[i], volume[i]};
+    }
+    // Bars [from, to), clamped to the view.
+    BarView slice(size_t from, size_t to) const;
+    // Bars with start <= time < end.
+    BarView between(int64_t start, int64_t end) const;
+};
+
+// Owned bars in column layout (struct of arrays), the result type of the historical APIs.
+struct BarSeries {
+    std::vector<int64_t> time;
+    std::vector<double> open;
+    std::vector<double> high;
+    std::vector<double> low;
+    std::vector<double> close;
+    std::vector<int64_t> volume;
+
+    size_t size() const { return time.size(); }
+    bool empty() const { return time.empty(); }
+    HistoricalBar operator[](size_t i) const {
+        return HistoricalBar{time[i], open[i], high[i], low[i], close[i], volume[i]};
+    }
+
+    void reserve(size_t n);
+    void clear();
+    void truncate(size_t n);  // keeps the first n bars
+    void push_back(const HistoricalBar& bar) {
+        push_back(bar.time, bar.open, bar.high, bar.low, bar.close, bar.volume);
+    }
+    void push_back(int64_t t, double o, double h, double l, double c, int64_t v) {
+        time.push_back(t);
+        open.push_back(o);
+        high.push_back(h);
+        low.push_back(l);
+        close.push_back(c);
+        volume.push_back(v);
+    }
+    void append(const BarView& bars);
+    // Sorts by time; of several bars with the same timestamp, the one appended last is kept.
+    void normalize();
+
+    BarView view() const;
+    BarView slice(size_t from, size_t to) const { return view().slice(from, to); }
+    BarView between(int64_t start, int64_t end) const { return view().between(start, end); }
+};
+
+// "YYYYMMDD HH:MM:SS" in UTC, or "YYYYMMDD" for daily bars.
+std::string formatBarTime(int64_t time, bool daily);
+
+#endif // BAR_SERIES_H
@@ -0,0 +1,205 @@
+#include "ContractCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr const char* kFileTag = "CONTRACTCACHE 1";
+
+time_t ymdToTime(int32_t date) {
+    std::tm tm{};
+    tm.tm_year = date / 10000 - 1900;
+    tm.tm_mon = date / 100 % 100 - 1;
+    tm.tm_mday = date % 100;
+    return timegm(&tm);
+}
+
+// Market rule of the SMART entry of validExchanges, else of the first one.
+int smartMarketRule(const std::string& validExchanges, const std::string& marketRuleIds) {
+    std::istringstream exchanges(validExchanges), rules(marketRuleIds);
+    int first = 0;
+    std::string exchange, rule;
+    while (std::getline(rules, rule, ',')) {
+        const bool more = static_cast<bool>(std::getline(exchanges, exchange, ','));
+        const int id = std::atoi(rule.c_str());
+        if (first == 0)
+            first = id;
+        if (more && exchange == "SMART")
+            return id;
+    }
+    return first;
+}
+
+// One line per entry, tab-separated; none of the fields contain tabs or newlines.
+void writeLine(std::ostream& out, const std::string& key, const ContractInfo& info) {
+    const Contract& c = info.contract;
+    out << key << '\t' << c.conId << '\t' << c.secType << '\t' << c.symbol << '\t' << c.localSymbol << '\t'
+        << c.primaryExchange << '\t' << c.currency << '\t' << c.tradingClass << '\t' << c.multiplier << '\t'
+        << c.lastTradeDateOrContractMonth << '\t' << c.strike << '\t' << c.right << '\t' << info.minTick << '\t'
+        << info.validExchanges << '\t' << info.marketRuleIds << '\t' << info.timeZoneId << '\t'
+        << info.tradingHours << '\t' << info.liquidHours << '\t' << info.fetchedDate << '\n';
+}
+
+bool readLine(const std::string& line, std::string& key, ContractInfo& info) {
+    std::vector<std::string> f;
+    std::istringstream in(line);
+    for (std::string field; std::getline(in, field, '\t');)
+        f.push_back(field);
+    if (f.size() != 19)
+        return false;
+    key = f[0];
+    Contract& c = info.contract;
+    c.conId = std::atol(f[1].c_str());
+    c.secType = f[2];
+    c.symbol = f[3];
+    c.localSymbol = f[4];
+    c.exchange = "SMART";
+    c.primaryExchange = f[5];
+    c.currency = f[6];
+    c.tradingClass = f[7];
+    c.multiplier = f[8];
+    c.lastTradeDateOrContractMonth = f[9];
+    c.strike = std::atof(f[10].c_str());
+    c.right = f[11];
+    info.minTick = std::atof(f[12].c_str());
+    info.validExchanges = f[13];
+    info.marketRuleIds = f[14];
+    info.timeZoneId = f[15];
+    info.tradingHours = f[16];
+    info.liquidHours = f[17];
+    info.fetchedDate = static_cast<int32_t>(std::atol(f[18].c_str()));
+    info.marketRuleId = smartMarketRule(info.validExchanges, info.marketRuleIds);
+    return !key.empty() && info.resolved();
+}
+
+} // namespace
+
+ContractInfo contractInfoFromDetails(const ContractDetails& details, int32_t fetchedDate) {
+    ContractInfo info;
+    info.contract = details.contract;
+    info.contract.exchange = "SMART";
+    info.minTick = details.minTick;
+    info.validExchanges = details.validExchanges;
+    info.marketRuleIds = details.marketRuleIds;
+    info.marketRuleId = smartMarketRule(details.validExchanges, details.marketRuleIds);
+    info.timeZoneId = details.timeZoneId;
+    info.tradingHours = details.tradingHours;
+    info.liquidHours = details.liquidHours;
+    info.fetchedDate = fetchedDate;
+    return info;
+}
+
+std::shared_ptr<const ContractInfo> ContractCache::find(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_bySymbol.find(key);
+    return it == m_bySymbol.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const ContractInfo> ContractCache::findConId(long conId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_byConId.find(conId);
+    return it == m_byConId.end() ? nullptr : it->second;
+}
+
+std::pair<std::shared_ptr<const ContractInfo>, bool> ContractCache::insert(const std::string& key, ContractInfo info) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_bySymbol.find(key);
+    if (it != m_bySymbol.end())
+        return {it->second, false};
+    auto entry = std::make_shared<const ContractInfo>(std::move(info));
+    m_bySymbol.emplace(key, entry);
+    if (entry->resolved()) {
+        m_byConId[entry->contract.conId] = entry;
+        append(key, *entry);
+    }
+    return {entry, true};
+}
+
+std::shared_ptr<const ContractInfo> ContractCache::store(const std::string& key, ContractInfo info) {
+    auto entry = std::make_shared<const ContractInfo>(std::move(info));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bySymbol[key] = entry;
+    if (entry->resolved()) {
+        m_byConId[entry->contract.conId] = entry;
+        append(key, *entry);
+    }
+    return entry;
+}
+
+// Called with m_mutex held.
+bool ContractCache::append(const std::string& key, const ContractInfo& info) {
+    if (m_path.empty())
+        return true;
+    std::ofstream out(m_path, std::ios::app);
+    out << std::setprecision(std::numeric_limits<double>::max_digits10);
+    writeLine(out, key, info);
+    if (!out) {
+        std::cerr << "error at ContractCache::append: cannot write " << m_path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+size_t ContractCache::setFile(const std::string& path, int32_t today) {
+    std::vector<std::pair<std::string, ContractInfo>> entries;
+    {
+        std::ifstream in(path);
+        std::string line;
+        if (in && std::getline(in, line) && line == kFileTag) {
+            const time_t now = ymdToTime(today);
+            while (std::getline(in, line)) {
+                std::string key;
+                ContractInfo info;
+                if (!readLine(line, key, info))
+                    continue;
+                if (now - ymdToTime(info.fetchedDate) > kMaxAgeDays * 86400)
+                    continue;
+                const std::string& expiry = info.contract.lastTradeDateOrContractMonth;
+                if (info.contract.secType == "OPT" && expiry.size() == 8 && expiry < std::to_string(today))
+                    continue;
+                entries.emplace_back(std::move(key), std::move(info));
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& [key, info] : entries) {
+        auto entry = std::make_shared<const ContractInfo>(std::move(info));
+        m_bySymbol[key] = entry;  // later lines supersede earlier ones
+        m_byConId[entry->contract.conId] = entry;
+    }
+
+    // Rewrite without superseded or dropped lines, then append from here on.
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << kFileTag << '\n' << std::setprecision(std::numeric_limits<double>::max_digits10);
+        for (const auto& [key, entry] : m_bySymbol) {
+            if (entry->resolved())
+                writeLine(out, key, *entry);
+        }
+        if (!out) {
+            std::cerr << "error at ContractCache::setFile: cannot write " << tmp << std::endl;
+            return m_bySymbol.size();
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "error at ContractCache::setFile: cannot replace " << path << std::endl;
+        return m_bySymbol.size();
+    }
+    m_path = path;
+    return m_bySymbol.size();
+}
+
+size_t ContractCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bySymbol.size();
+}
@@ -0,0 +1,63 @@
+#ifndef CONTRACT_CACHE_H
+#define CONTRACT_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "Contract.h"
+
+// Reference data of one instrument, as contractDetails reported it.
+struct ContractInfo {
+    // Ready to send: conId plus the descriptive fields, routed SMART. Before the instrument is
+    // resolved it is the contract built from the symbol alone (conId 0).
+    Contract contract;
+    double minTick = 0.0;
+    std::string validExchanges;  // comma-separated
+    std::string marketRuleIds;   // comma-separated, one per valid exchange
+    int marketRuleId = 0;        // rule of the SMART route (else the first exchange), 0 if unknown
+    std::string timeZoneId;
+    std::string tradingHours;
+    std::string liquidHours;
+    int32_t fetchedDate = 0;     // YYYYMMDD (UTC)
+
+    bool resolved() const { return contract.conId != 0; }
+};
+
+ContractInfo contractInfoFromDetails(const ContractDetails& details, int32_t fetchedDate);
+
+// Resolved instruments keyed by the symbol callers use (stock ticker or OCC option symbol) and
+// by conId. With a file set, every resolved entry is appended to it as one line, and the file
+// is loaded (and rewritten without superseded lines) at start-up, so a warm start needs no
+// contract details round trips. Entries older than kMaxAgeDays (their trading hours only
+// cover the next few days) and options past their expiry are dropped on load.
+// Thread-safe.
+class ContractCache {
+public:
+    static constexpr int kMaxAgeDays = 7;
+
+    std::shared_ptr<const ContractInfo> find(const std::string& key) const;
+    std::shared_ptr<const ContractInfo> findConId(long conId) const;
+
+    // Adds `info` unless the key is present; returns the entry and whether it was added.
+    std::pair<std::shared_ptr<const ContractInfo>, bool> insert(const std::string& key, ContractInfo info);
+    // Adds or replaces; resolved entries are also appended to the file.
+    std::shared_ptr<const ContractInfo> store(const std::string& key, ContractInfo info);
+
+    // Loads `path` (if it exists) into the cache and appends to it from now on.
+    size_t setFile(const std::string& path, int32_t today);
+    size_t size() const;
+
+private:
+    bool append(const std::string& key, const ContractInfo& info);
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, std::shared_ptr<const ContractInfo>> m_bySymbol;
+    std::unordered_map<long, std::shared_ptr<const ContractInfo>> m_byConId;
+    std::string m_path;
+};
+
+#endif // CONTRACT_CACHE_H
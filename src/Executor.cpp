@@ -0,0 +1,43 @@
+#include "Executor.h"
+
+Executor::Executor(size_t threads) {
+    if (threads == 0)
+        threads = 1;
+    for (size_t i = 0; i < threads; ++i)
+        m_threads.emplace_back([this]() { run(); });
+}
+
+Executor::~Executor() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    for (auto& t : m_threads) {
+        if (t.joinable())
+            t.join();
+    }
+}
+
+void Executor::post(std::function<void()> work) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_work.push_back(std::move(work));
+    }
+    m_cond.notify_one();
+}
+
+void Executor::run() {
+    for (;;) {
+        std::function<void()> work;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() { return m_stop || !m_work.empty(); });
+            if (m_work.empty())
+                return; // stopping and drained
+            work = std::move(m_work.front());
+            m_work.pop_front();
+        }
+        work();
+    }
+}
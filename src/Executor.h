@@ -0,0 +1,37 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small fixed-size thread pool used to resume coroutines when their TWS response arrives,
+// so neither the reader nor the dispatch threads ever run user continuations.
+class Executor {
+public:
+    explicit Executor(size_t threads = 2);
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    void post(std::function<void()> work);
+    void post(std::coroutine_handle<> handle) {
+        post([handle]() { handle.resume(); });
+    }
+
+private:
+    void run();
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<std::function<void()>> m_work;
+    bool m_stop = false;
+    std::vector<std::thread> m_threads;
+};
+
+#endif // EXECUTOR_H
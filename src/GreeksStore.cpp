@@ -0,0 +1,246 @@
+#include "GreeksStore.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+
+// TWS sends DBL_MAX for values it could not compute, and -1 or -2 for some that cannot be negative.
+bool isSet(double v) { return std::isfinite(v) && v != DBL_MAX; }
+bool isSetNonNegative(double v) { return isSet(v) && v >= 0.0; }
+
+void assign(std::vector<double>& column, size_t row, double v, bool valid) {
+    if (valid)
+        column[row] = v;
+}
+
+Greeks operator-(const Greeks& a, const Greeks& b) {
+    return {a.delta - b.delta, a.gamma - b.gamma, a.vega - b.vega, a.theta - b.theta};
+}
+
+Greeks& operator+=(Greeks& a, const Greeks& b) {
+    a.delta += b.delta;
+    a.gamma += b.gamma;
+    a.vega += b.vega;
+    a.theta += b.theta;
+    return a;
+}
+
+} // namespace
+
+int greekSourceOf(int tickType) {
+    if (tickType >= 10 && tickType <= 13)  // BID/ASK/LAST_OPTION_COMPUTATION, MODEL_OPTION
+        return tickType - 10;
+    if (tickType >= 80 && tickType <= 83)  // DELAYED_* variants
+        return tickType - 80;
+    return -1;
+}
+
+long GreeksStore::row(int tickerId) const {
+    auto it = m_tickerRows.find(tickerId);
+    return it == m_tickerRows.end() ? -1 : static_cast<long>(it->second);
+}
+
+size_t GreeksStore::addTicker(int tickerId, const std::string& symbol) {
+    auto it = m_tickerRows.find(tickerId);
+    if (it != m_tickerRows.end())
+        return it->second;
+
+    size_t r;
+    if (!m_freeRows.empty()) {
+        r = m_freeRows.back();
+        m_freeRows.pop_back();
+    } else {
+        r = m_rowSymbols.size();
+        const size_t n = r + 1;
+        for (Columns& c : m_columns) {
+            for (auto* column : {&c.impliedVol, &c.delta, &c.optPrice, &c.pvDividend, &c.gamma, &c.vega, &c.theta, &c.undPrice})
+                column->resize(n, 0.0);
+            c.time.resize(n, 0);
+        }
+        m_present.resize(n);
+        m_exposureSource.resize(n);
+        m_rowPosition.resize(n);
+        m_rowSymbols.resize(n);
+    }
+    // A reused row still holds the previous ticker's values, and update() keeps a column's old
+    // value when a field arrives unset, so clear all of them.
+    for (Columns& c : m_columns) {
+        for (auto* column : {&c.impliedVol, &c.delta, &c.optPrice, &c.pvDividend, &c.gamma, &c.vega, &c.theta, &c.undPrice})
+            (*column)[r] = 0.0;
+        c.time[r] = 0;
+    }
+    m_present[r] = 0;
+    m_exposureSource[r] = GreekSource::Model;
+    m_rowSymbols[r] = symbol;
+    auto pos = m_positionIndex.find(symbol);
+    m_rowPosition[r] = pos == m_positionIndex.end() ? -1 : static_cast<long>(pos->second);
+    m_tickerRows.emplace(tickerId, r);
+    return r;
+}
+
+void GreeksStore::removeTicker(int tickerId) {
+    auto it = m_tickerRows.find(tickerId);
+    if (it == m_tickerRows.end())
+        return;
+    // The position keeps the last contribution it got from this row.
+    m_rowPosition[it->second] = -1;
+    m_rowSymbols[it->second].clear();
+    m_freeRows.push_back(it->second);
+    m_tickerRows.erase(it);
+}
+
+void GreeksStore::update(size_t row, GreekSource source, const OptionComputation& c, int64_t time) {
+    Columns& col = m_columns[static_cast<size_t>(source)];
+    assign(col.impliedVol, row, c.impliedVol, isSetNonNegative(c.impliedVol));
+    assign(col.delta, row, c.delta, isSet(c.delta) && std::abs(c.delta) <= 1.0);
+    assign(col.optPrice, row, c.optPrice, isSetNonNegative(c.optPrice));
+    assign(col.pvDividend, row, c.pvDividend, isSetNonNegative(c.pvDividend));
+    assign(col.gamma, row, c.gamma, isSet(c.gamma));
+    assign(col.vega, row, c.vega, isSet(c.vega));
+    assign(col.theta, row, c.theta, isSet(c.theta));
+    assign(col.undPrice, row, c.undPrice, isSetNonNegative(c.undPrice));
+    col.time[row] = time;
+
+    const uint8_t modelBit = 1u << static_cast<unsigned>(GreekSource::Model);
+    m_present[row] |= static_cast<uint8_t>(1u << static_cast<unsigned>(source));
+    if (source != GreekSource::Model && (m_present[row] & modelBit))
+        return;  // the model computation drives exposure once there is one
+    m_exposureSource[row] = source;
+    if (m_rowPosition[row] >= 0) {
+        PositionEntry& p = m_positions[static_cast<size_t>(m_rowPosition[row])];
+        const Greeks g = rowGreeks(row, source);
+        setContribution(p, {p.weight * g.delta, p.weight * g.gamma, p.weight * g.vega, p.weight * g.theta});
+    }
+}
+
+bool GreeksStore::get(size_t row, GreekSource source, OptionComputation& out) const {
+    if (row >= m_present.size() || !(m_present[row] & (1u << static_cast<unsigned>(source))))
+        return false;
+    const Columns& c = m_columns[static_cast<size_t>(source)];
+    out = {c.impliedVol[row], c.delta[row], c.optPrice[row], c.pvDividend[row],
+           c.gamma[row], c.vega[row], c.theta[row], c.undPrice[row]};
+    return true;
+}
+
+Greeks GreeksStore::rowGreeks(size_t row, GreekSource source) const {
+    const Columns& c = m_columns[static_cast<size_t>(source)];
+    return {c.delta[row], c.gamma[row], c.vega[row], c.theta[row]};
+}
+
+void GreeksStore::setContribution(PositionEntry& p, const Greeks& g) {
+    const Greeks change = g - p.contribution;
+    m_underlyings[p.underlying].second += change;
+    m_book += change;
+    p.contribution = g;
+    p.priced = true;
+}
+
+void GreeksStore::setPosition(const std::string& symbol, const std::string& underlying, double quantity,
+                              double multiplier, bool option) {
+    auto it = m_positionIndex.find(symbol);
+    if (quantity == 0.0) {
+        if (it == m_positionIndex.end())
+            return;
+        // Swap-and-pop, then relink the rows; positions change rarely compared to ticks.
+        const size_t i = it->second;
+        m_positionIndex.erase(it);
+        if (i + 1 != m_positions.size()) {
+            m_positions[i] = std::move(m_positions.back());
+            m_positionIndex[m_positions[i].symbol] = i;
+        }
+        m_positions.pop_back();
+        for (size_t r = 0; r < m_rowSymbols.size(); ++r) {
+            auto pos = m_positionIndex.find(m_rowSymbols[r]);
+            m_rowPosition[r] = pos == m_positionIndex.end() ? -1 : static_cast<long>(pos->second);
+        }
+        rebuildTotals();
+        return;
+    }
+
+    size_t i;
+    if (it == m_positionIndex.end()) {
+        auto u = m_underlyingIndex.find(underlying);
+        if (u == m_underlyingIndex.end()) {
+            u = m_underlyingIndex.emplace(underlying, m_underlyings.size()).first;
+            m_underlyings.push_back({underlying, Greeks{}});
+        }
+        i = m_positions.size();
+        PositionEntry entry;
+        entry.symbol = symbol;
+        entry.underlying = u->second;
+        m_positions.push_back(std::move(entry));
+        m_positionIndex.emplace(symbol, i);
+        for (size_t r = 0; r < m_rowSymbols.size(); ++r) {
+            if (m_rowSymbols[r] == symbol)
+                m_rowPosition[r] = static_cast<long>(i);
+        }
+    } else {
+        i = it->second;
+    }
+
+    PositionEntry& p = m_positions[i];
+    const double previousWeight = p.weight;
+    p.weight = quantity * multiplier;
+    p.option = option;
+    if (!option) {
+        setContribution(p, {p.weight, 0.0, 0.0, 0.0});
+        return;
+    }
+    for (size_t r = 0; r < m_rowSymbols.size(); ++r) {
+        if (m_rowPosition[r] == static_cast<long>(i) && m_present[r]) {
+            const Greeks g = rowGreeks(r, m_exposureSource[r]);
+            setContribution(p, {p.weight * g.delta, p.weight * g.gamma, p.weight * g.vega, p.weight * g.theta});
+            return;
+        }
+    }
+    // No ticker streams it any more: rescale the last known greeks to the new quantity.
+    if (p.priced && previousWeight != 0.0) {
+        const double k = p.weight / previousWeight;
+        const Greeks& c = p.contribution;
+        setContribution(p, {c.delta * k, c.gamma * k, c.vega * k, c.theta * k});
+    }
+}
+
+void GreeksStore::clearPositions() {
+    m_positions.clear();
+    m_positionIndex.clear();
+    std::fill(m_rowPosition.begin(), m_rowPosition.end(), -1);
+    rebuildTotals();
+}
+
+// Sums from scratch, so rounding left behind by removed positions does not linger.
+void GreeksStore::rebuildTotals() {
+    m_book = {};
+    for (auto& u : m_underlyings)
+        u.second = {};
+    for (const PositionEntry& p : m_positions) {
+        m_underlyings[p.underlying].second += p.contribution;
+        m_book += p.contribution;
+    }
+}
+
+Greeks GreeksStore::underlyingGreeks(const std::string& underlying) const {
+    auto it = m_underlyingIndex.find(underlying);
+    return it == m_underlyingIndex.end() ? Greeks{} : m_underlyings[it->second].second;
+}
+
+PortfolioGreeks GreeksStore::portfolio() const {
+    PortfolioGreeks out;
+    out.book = m_book;
+    out.positions = m_positions.size();
+    std::vector<bool> held(m_underlyings.size(), false);
+    for (const PositionEntry& p : m_positions) {
+        held[p.underlying] = true;
+        if (p.option && !p.priced)
+            ++out.positionsWithoutGreeks;
+    }
+    for (size_t u = 0; u < m_underlyings.size(); ++u) {
+        if (held[u])
+            out.underlyings.push_back(m_underlyings[u]);
+    }
+    std::sort(out.underlyings.begin(), out.underlyings.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    return out;
+}
@@ -0,0 +1,110 @@
+#ifndef GREEKS_STORE_H
+#define GREEKS_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct OptionComputation {
+    double impliedVol = 0.0;
+    double delta = 0.0;
+    double optPrice = 0.0;
+    double pvDividend = 0.0;
+    double gamma = 0.0;
+    double vega = 0.0;
+    double theta = 0.0;
+    double undPrice = 0.0;
+};
+
+// Which quote TWS computed the values from (tick types 10-13, or 80-83 when delayed).
+enum class GreekSource : uint8_t { Bid, Ask, Last, Model };
+constexpr size_t kGreekSources = 4;
+
+// Source of an option computation tick type, or -1 if it is not one.
+int greekSourceOf(int tickType);
+
+// Position-weighted exposure: quantity x multiplier x the per-contract greek. Delta is in
+// shares of the underlying, vega per volatility point and theta per day, as TWS reports them.
+struct Greeks {
+    double delta = 0.0;
+    double gamma = 0.0;
+    double vega = 0.0;
+    double theta = 0.0;
+};
+
+struct PortfolioGreeks {
+    Greeks book;
+    std::vector<std::pair<std::string, Greeks>> underlyings;  // sorted by underlying
+    size_t positions = 0;
+    size_t positionsWithoutGreeks = 0;  // option positions no computation has arrived for yet
+};
+
+// Latest option computation per ticker and source, stored column-wise: one array per field
+// and source, indexed by the ticker's row. Alongside it, net greeks per underlying and for the
+// whole book, kept current incrementally: a tick only replaces its position's previous
+// contribution, so each update is O(1) regardless of the size of the book. Exposure uses the
+// model computation, or the most recent other source until a model tick has arrived.
+// Not thread-safe; TwsApi guards it with its tick mutex.
+class GreeksStore {
+public:
+    struct Columns {
+        std::vector<double> impliedVol, delta, optPrice, pvDividend, gamma, vega, theta, undPrice;
+        std::vector<int64_t> time;  // epoch seconds of the last update, 0 = never
+    };
+
+    // Row of a ticker, or -1 if it has none yet.
+    long row(int tickerId) const;
+    // Row of a ticker, created for `symbol` (the OCC symbol positions are reported under).
+    size_t addTicker(int tickerId, const std::string& symbol);
+    void removeTicker(int tickerId);
+
+    // Stores a computation and updates the exposure of the row's position, if any. Fields TWS
+    // leaves unset (DBL_MAX, or -1/-2 where a value cannot be negative) keep their previous value.
+    void update(size_t row, GreekSource source, const OptionComputation& c, int64_t time);
+    bool get(size_t row, GreekSource source, OptionComputation& out) const;
+    const Columns& columns(GreekSource source) const { return m_columns[static_cast<size_t>(source)]; }
+    size_t rows() const { return m_rowSymbols.size(); }
+
+    // Sets (quantity 0 removes) a position. Stock positions count quantity x 1 delta; option
+    // positions take their greeks from the rows of tickers streaming that symbol.
+    void setPosition(const std::string& symbol, const std::string& underlying, double quantity,
+                     double multiplier, bool option);
+    void clearPositions();
+
+    Greeks underlyingGreeks(const std::string& underlying) const;
+    Greeks bookGreeks() const { return m_book; }
+    PortfolioGreeks portfolio() const;
+
+private:
+    struct PositionEntry {
+        std::string symbol;
+        size_t underlying = 0;      // index into m_underlyings
+        double weight = 0.0;        // quantity x multiplier
+        bool option = false;
+        bool priced = false;        // has a contribution from a computation
+        Greeks contribution;
+    };
+
+    void setContribution(PositionEntry& p, const Greeks& g);
+    Greeks rowGreeks(size_t row, GreekSource source) const;
+    void rebuildTotals();
+
+    Columns m_columns[kGreekSources];
+    std::vector<uint8_t> m_present;         // bit per source
+    std::vector<GreekSource> m_exposureSource;
+    std::vector<long> m_rowPosition;        // index into m_positions, or -1
+    std::vector<std::string> m_rowSymbols;
+    std::vector<size_t> m_freeRows;
+    std::unordered_map<int, size_t> m_tickerRows;
+
+    std::vector<PositionEntry> m_positions;
+    std::unordered_map<std::string, size_t> m_positionIndex;  // symbol -> m_positions
+    std::vector<std::pair<std::string, Greeks>> m_underlyings;
+    std::unordered_map<std::string, size_t> m_underlyingIndex;
+    Greeks m_book;
+};
+
+#endif // GREEKS_STORE_H
@@ -0,0 +1,209 @@
+#include "HistoricalPacer.h"
+
+#include <algorithm>
+
+HistoricalPacer::HistoricalPacer(PacingLimits limits) : m_limits(limits) {
+    m_thread = std::thread([this]() { run(); });
+}
+
+HistoricalPacer::~HistoricalPacer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+HistoricalPacer::Clock::time_point HistoricalPacer::earliest(const History& history, const Key& key,
+                                                             Clock::time_point now) const {
+    Clock::time_point t = now;
+
+    // The oldest entries have to leave the window until there is room for `weight` more.
+    const size_t used = history.all.size();
+    const size_t weight = static_cast<size_t>(std::max(1, key.weight));
+    if (used + weight > static_cast<size_t>(m_limits.maxRequests)) {
+        const size_t idx = used + weight - static_cast<size_t>(m_limits.maxRequests) - 1;
+        if (idx < used)
+            t = std::max(t, history.all[idx] + m_limits.window + m_limits.margin);
+    }
+
+    auto contract = history.byContract.find(key.contract);
+    if (contract != history.byContract.end()) {
+        const auto& sent = contract->second;
+        if (sent.size() >= static_cast<size_t>(m_limits.maxPerContract)) {
+            const size_t idx = sent.size() - static_cast<size_t>(m_limits.maxPerContract);
+            t = std::max(t, sent[idx] + m_limits.contractWindow + m_limits.margin);
+        }
+    }
+
+    auto identical = history.lastIdentical.find(key.request);
+    if (identical != history.lastIdentical.end())
+        t = std::max(t, identical->second + m_limits.identicalGap + m_limits.margin);
+    return t;
+}
+
+void HistoricalPacer::record(History& history, const Key& key, Clock::time_point when) const {
+    for (int i = 0; i < std::max(1, key.weight); ++i)
+        history.all.push_back(when);
+    history.byContract[key.contract].push_back(when);
+    history.lastIdentical[key.request] = when;
+}
+
+void HistoricalPacer::prune(History& history, Clock::time_point now) const {
+    while (!history.all.empty() && history.all.front() + m_limits.window + m_limits.margin <= now)
+        history.all.pop_front();
+    for (auto it = history.byContract.begin(); it != history.byContract.end();) {
+        auto& sent = it->second;
+        while (!sent.empty() && sent.front() + m_limits.contractWindow + m_limits.margin <= now)
+            sent.pop_front();
+        it = sent.empty() ? history.byContract.erase(it) : std::next(it);
+    }
+    for (auto it = history.lastIdentical.begin(); it != history.lastIdentical.end();) {
+        if (it->second + m_limits.identicalGap + m_limits.margin <= now)
+            it = history.lastIdentical.erase(it);
+        else
+            ++it;
+    }
+}
+
+// Called with m_mutex held. Replays the dispatcher's policy on a copy of the history.
+std::vector<HistoricalPacer::Clock::time_point> HistoricalPacer::simulate(const std::vector<Key>& extra,
+                                                                          Clock::time_point now) const {
+    std::vector<const Key*> keys;
+    keys.reserve(m_queue.size() + extra.size());
+    for (const auto& p : m_queue)
+        keys.push_back(&p.key);
+    for (const auto& k : extra)
+        keys.push_back(&k);
+
+    History history = m_history;
+    std::vector<Clock::time_point> times(keys.size(), now);
+    std::vector<size_t> remaining(keys.size());
+    for (size_t i = 0; i < remaining.size(); ++i)
+        remaining[i] = i;
+
+    Clock::time_point t = now;
+    while (!remaining.empty()) {
+        prune(history, t);
+        Clock::time_point next = Clock::time_point::max();
+        auto ready = remaining.end();
+        for (auto it = remaining.begin(); it != remaining.end(); ++it) {
+            Clock::time_point e = earliest(history, *keys[*it], t);
+            if (e <= t) {
+                ready = it;
+                break;
+            }
+            next = std::min(next, e);
+        }
+        if (ready == remaining.end()) {
+            t = next;
+            continue;
+        }
+        record(history, *keys[*ready], t);
+        times[*ready] = t;
+        remaining.erase(ready);
+    }
+    return times;
+}
+
+std::chrono::milliseconds HistoricalPacer::submit(const Key& key, int reqId, std::function<void()> send) {
+    std::chrono::milliseconds wait{0};
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto now = Clock::now();
+        wait = std::chrono::duration_cast<std::chrono::milliseconds>(simulate({key}, now).back() - now);
+        if (wait.count() > 0)
+            ++m_delayed;
+        m_queue.push_back(Pending{key, reqId, std::move(send), now});
+    }
+    m_cond.notify_all();
+    return wait;
+}
+
+bool HistoricalPacer::cancel(int reqId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find_if(m_queue.begin(), m_queue.end(), [reqId](const Pending& p) { return p.reqId == reqId; });
+    if (it == m_queue.end())
+        return false;
+    m_queue.erase(it);
+    return true;
+}
+
+std::vector<int> HistoricalPacer::cancelAll() {
+    std::vector<int> ids;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& p : m_queue)
+            ids.push_back(p.reqId);
+        m_queue.clear();
+    }
+    std::lock_guard<std::mutex> sending(m_sendMutex);  // wait out a send already in progress
+    return ids;
+}
+
+std::chrono::milliseconds HistoricalPacer::estimate(const std::vector<Key>& keys) const {
+    if (keys.empty())
+        return std::chrono::milliseconds{0};
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto now = Clock::now();
+    auto times = simulate(keys, now);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(times.back() - now);
+}
+
+PacingStats HistoricalPacer::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto now = Clock::now();
+    PacingStats s;
+    s.queued = m_queue.size();
+    s.dispatched = m_dispatched;
+    s.delayed = m_delayed;
+
+    History history = m_history;
+    prune(history, now);
+    s.usedInWindow = static_cast<int>(history.all.size());
+    if (!m_queue.empty()) {
+        auto times = simulate({}, now);
+        s.nextDispatch = std::chrono::duration_cast<std::chrono::milliseconds>(
+            *std::min_element(times.begin(), times.end()) - now);
+        s.drainEstimate = std::chrono::duration_cast<std::chrono::milliseconds>(
+            *std::max_element(times.begin(), times.end()) - now);
+    }
+    return s;
+}
+
+void HistoricalPacer::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        const auto now = Clock::now();
+        prune(m_history, now);
+        Clock::time_point next = Clock::time_point::max();
+        auto ready = m_queue.end();
+        for (auto it = m_queue.begin(); it != m_queue.end(); ++it) {
+            Clock::time_point e = earliest(m_history, it->key, now);
+            if (e <= now) {
+                ready = it;
+                break;
+            }
+            next = std::min(next, e);
+        }
+
+        if (ready != m_queue.end()) {
+            Pending p = std::move(*ready);
+            m_queue.erase(ready);
+            record(m_history, p.key, now);
+            ++m_dispatched;
+            std::unique_lock<std::mutex> sending(m_sendMutex);
+            lock.unlock();
+            p.send();
+            sending.unlock();
+            lock.lock();
+            continue;
+        }
+        if (next == Clock::time_point::max())
+            m_cond.wait(lock);
+        else
+            m_cond.wait_until(lock, next);
+    }
+}
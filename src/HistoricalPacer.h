@@ -0,0 +1,99 @@
+#ifndef HISTORICAL_PACER_H
+#define HISTORICAL_PACER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// IB historical data pacing rules. A small margin is added to each window because the
+// windows are measured on the TWS side.
+struct PacingLimits {
+    int maxRequests = 60;                                  // per `window`
+    std::chrono::milliseconds window{600000};              // 10 minutes
+    std::chrono::milliseconds identicalGap{15000};         // identical requests
+    int maxPerContract = 5;                                // 6+ for the same contract/exchange/tick type...
+    std::chrono::milliseconds contractWindow{2000};        // ...within 2 seconds is a violation
+    std::chrono::milliseconds margin{100};
+};
+
+struct PacingStats {
+    size_t queued = 0;
+    int usedInWindow = 0;                  // weighted requests sent in the current 10-minute window
+    std::chrono::milliseconds nextDispatch{0};   // until the first queued request may go out
+    std::chrono::milliseconds drainEstimate{0};  // until the whole queue has gone out
+    uint64_t dispatched = 0;
+    uint64_t delayed = 0;                  // requests that had to wait for a pacing window
+};
+
+// Queues historical requests and sends each one as soon as all pacing rules allow, on a
+// dedicated thread. Requests that are blocked (e.g. by the per-contract rule) do not hold
+// back later requests for other contracts.
+class HistoricalPacer {
+public:
+    struct Key {
+        std::string contract;  // contract + exchange + whatToShow
+        std::string request;   // every parameter of the request; equal strings = identical requests
+        int weight = 1;        // BID_ASK requests count twice
+    };
+
+    explicit HistoricalPacer(PacingLimits limits = {});
+    ~HistoricalPacer();
+
+    HistoricalPacer(const HistoricalPacer&) = delete;
+    HistoricalPacer& operator=(const HistoricalPacer&) = delete;
+
+    // Queues `send` and returns how long it is expected to wait before being sent.
+    std::chrono::milliseconds submit(const Key& key, int reqId, std::function<void()> send);
+    // Removes a still queued request. Returns false if it was already sent (or unknown).
+    bool cancel(int reqId);
+    // Drops the whole queue and returns the request ids that were never sent. When it returns,
+    // no send callback is running any more.
+    std::vector<int> cancelAll();
+
+    // Expected wait until the last of `keys` would be sent if they were submitted now.
+    std::chrono::milliseconds estimate(const std::vector<Key>& keys) const;
+    PacingStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        Key key;
+        int reqId;
+        std::function<void()> send;
+        Clock::time_point queuedAt;
+    };
+    // Sliding windows of what has been sent.
+    struct History {
+        std::deque<Clock::time_point> all;  // one entry per unit of weight
+        std::map<std::string, std::deque<Clock::time_point>> byContract;
+        std::map<std::string, Clock::time_point> lastIdentical;
+    };
+
+    Clock::time_point earliest(const History& history, const Key& key, Clock::time_point now) const;
+    void record(History& history, const Key& key, Clock::time_point when) const;
+    void prune(History& history, Clock::time_point now) const;
+    // Dispatch times for `queue` followed by `extra`, without touching the real state.
+    std::vector<Clock::time_point> simulate(const std::vector<Key>& extra, Clock::time_point now) const;
+    void run();
+
+    const PacingLimits m_limits;
+    mutable std::mutex m_mutex;
+    std::mutex m_sendMutex;  // held while a send callback runs
+    std::condition_variable m_cond;
+    std::deque<Pending> m_queue;
+    History m_history;
+    uint64_t m_dispatched = 0;
+    uint64_t m_delayed = 0;
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+#endif // HISTORICAL_PACER_H
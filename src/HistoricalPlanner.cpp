@@ -0,0 +1,190 @@
+#include "HistoricalPlanner.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+long long barSizeSeconds(const std::string& barSize) {
+    const long long n = std::atoll(barSize.c_str());
+    if (n <= 0)
+        return 0;
+    if (barSize.find("sec") != std::string::npos) return n;
+    if (barSize.find("min") != std::string::npos) return n * 60;
+    if (barSize.find("hour") != std::string::npos) return n * 3600;
+    if (barSize.find("day") != std::string::npos) return n * 86400;
+    if (barSize.find("week") != std::string::npos) return n * 7 * 86400;
+    if (barSize.find("month") != std::string::npos) return n * 30 * 86400;
+    return 0;
+}
+
+long long maxChunkSeconds(const std::string& barSize) {
+    const long long bar = barSizeSeconds(barSize);
+    if (bar <= 1) return 1800;
+    if (bar <= 5) return 3600;
+    if (bar <= 15) return 14400;
+    if (bar <= 30) return 28800;
+    if (bar <= 60) return 86400;
+    if (bar <= 120) return 2 * 86400;
+    if (bar <= 1200) return 7 * 86400;
+    if (bar < 86400) return 28 * 86400;
+    return 365 * 86400;
+}
+
+// Seconds are only valid up to one day; longer spans are rounded up to whole days (the
+// overlap is trimmed when the chunks are stitched).
+static std::string durationFor(long long seconds, long long barSeconds) {
+    if (seconds < 86400 && barSeconds < 86400)
+        return std::to_string(seconds) + " S";
+    return std::to_string((seconds + 86399) / 86400) + " D";
+}
+
+std::vector<HistoricalChunk> planHistoricalChunks(time_t start, time_t end, const std::string& barSize) {
+    std::vector<HistoricalChunk> chunks;
+    const long long bar = barSizeSeconds(barSize);
+    if (bar == 0 || end <= start)
+        return chunks;
+    const long long step = maxChunkSeconds(barSize);
+    for (time_t chunkEnd = end; chunkEnd > start;) {
+        const time_t chunkStart = std::max<time_t>(start, chunkEnd - static_cast<time_t>(step));
+        HistoricalChunk chunk;
+        chunk.start = chunkStart;
+        chunk.end = chunkEnd;
+        chunk.endDateTime = formatIbDateTimeUtc(chunkEnd);
+        chunk.duration = durationFor(std::max<long long>(chunkEnd - chunkStart, bar), bar);
+        chunks.push_back(std::move(chunk));
+        chunkEnd = chunkStart;
+    }
+    return chunks;
+}
+
+time_t parseIbDateTime(const std::string& s) {
+    if (s.size() < 8 || !std::all_of(s.begin(), s.begin() + 8, [](unsigned char c) { return std::isdigit(c); }))
+        return -1;
+    std::tm tm{};
+    tm.tm_year = std::atoi(s.substr(0, 4).c_str()) - 1900;
+    tm.tm_mon = std::atoi(s.substr(4, 2).c_str()) - 1;
+    tm.tm_mday = std::atoi(s.substr(6, 2).c_str());
+    if (s.size() >= 17 && (s[8] == ' ' || s[8] == '-')) {
+        tm.tm_hour = std::atoi(s.substr(9, 2).c_str());
+        tm.tm_min = std::atoi(s.substr(12, 2).c_str());
+        tm.tm_sec = std::atoi(s.substr(15, 2).c_str());
+    }
+    return timegm(&tm);
+}
+
+time_t parseBarTime(const std::string& s) {
+    // Epoch seconds are 9+ digits with no separators; a bare date is exactly 8.
+    if (s.size() > 8 && std::all_of(s.begin(), s.end(), [](unsigned char c) { return std::isdigit(c); }))
+        return static_cast<time_t>(std::atoll(s.c_str()));
+    return parseIbDateTime(s);
+}
+
+std::string formatIbDateTimeUtc(time_t t) {
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y%m%d-%H:%M:%S", &tm);
+    return buf;
+}
+
+std::vector<TimeRange> mergeRanges(std::vector<TimeRange> ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<TimeRange> merged;
+    for (const auto& r : ranges) {
+        if (r.second <= r.first)
+            continue;
+        if (!merged.empty() && r.first <= merged.back().second)
+            merged.back().second = std::max(merged.back().second, r.second);
+        else
+            merged.push_back(r);
+    }
+    return merged;
+}
+
+std::vector<TimeRange> subtractRanges(const TimeRange& want, const std::vector<TimeRange>& covered) {
+    std::vector<TimeRange> missing;
+    time_t cursor = want.first;
+    for (const auto& r : covered) {
+        if (r.second <= cursor)
+            continue;
+        if (r.first >= want.second)
+            break;
+        if (r.first > cursor)
+            missing.emplace_back(cursor, r.first);
+        cursor = std::max(cursor, r.second);
+    }
+    if (cursor < want.second)
+        missing.emplace_back(cursor, want.second);
+    return missing;
+}
+
+std::vector<TimeRange> coalesceRanges(const std::vector<TimeRange>& ranges, long long maxSpan) {
+    std::vector<TimeRange> out;
+    for (const auto& r : ranges) {
+        if (!out.empty() && static_cast<long long>(r.second - out.back().first) <= maxSpan)
+            out.back().second = std::max(out.back().second, r.second);
+        else
+            out.push_back(r);
+    }
+    return out;
+}
+
+static TimeRange sessionSpan(const TradingSession& s, long long barSeconds) {
+    if (barSeconds >= 86400)
+        return {s.day, s.day + 86400};
+    return {s.start, s.end};
+}
+
+TimeRange trimToSessions(const TimeRange& window, const std::vector<TradingSession>& sessions,
+                         long long barSeconds) {
+    time_t first = window.second;
+    time_t last = window.first;
+    for (const auto& s : sessions) {
+        const TimeRange span = sessionSpan(s, barSeconds);
+        if (span.second <= window.first || span.first >= window.second)
+            continue;
+        first = std::min(first, std::max(window.first, span.first));
+        last = std::max(last, std::min(window.second, span.second));
+    }
+    if (first >= last)
+        return {window.first, window.first};
+    return {first, last};
+}
+
+std::vector<TimeRange> findBarGaps(const int64_t* times, size_t count,
+                                   const std::vector<TradingSession>& sessions, long long barSeconds,
+                                   time_t from, time_t to, size_t minMissingBars) {
+    std::vector<TimeRange> gaps;
+    if (barSeconds <= 0)
+        return gaps;
+    size_t next = 0;          // first cached bar not yet passed
+    size_t runBars = 0;
+    TimeRange run{0, 0};
+    auto flush = [&]() {
+        if (runBars > 0 && runBars >= minMissingBars)
+            gaps.push_back(run);
+        runBars = 0;
+    };
+
+    for (const auto& s : sessions) {
+        const TimeRange span = sessionSpan(s, barSeconds);
+        if (span.second <= from || span.first >= to)
+            continue;
+        // Bars start at the session open and then on multiples of the bar size.
+        for (time_t t = span.first; t < span.second; t = (t / barSeconds + 1) * barSeconds) {
+            if (t < from || t >= to)
+                continue;
+            while (next < count && times[next] < t)
+                ++next;
+            if (next < count && times[next] == t) {
+                flush();
+                continue;
+            }
+            if (runBars++ == 0)
+                run.first = t;
+            run.second = std::min<time_t>(span.second, t + barSeconds);
+        }
+    }
+    flush();
+    return gaps;
+}
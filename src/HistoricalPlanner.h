@@ -0,0 +1,79 @@
+#ifndef HISTORICAL_PLANNER_H
+#define HISTORICAL_PLANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+
+// An arbitrary [start, end) window of bars for one contract. Times are UTC epoch seconds.
+struct HistoricalQuery {
+    std::string symbol;
+    std::string barSize = "1 min";     // IB bar size setting, e.g. "1 secs", "5 mins", "1 hour", "1 day"
+    std::string whatToShow = "TRADES";
+    bool useRTH = true;
+    time_t start = 0;
+    time_t end = 0;
+};
+
+using TimeRange = std::pair<time_t, time_t>;  // [first, second)
+
+// One trading session in UTC, with the trading date it belongs to as midnight UTC of that
+// date (which is how daily bars are stamped).
+struct TradingSession {
+    time_t start = 0;
+    time_t end = 0;
+    time_t day = 0;
+};
+
+// One reqHistoricalData call covering [start, end). endDateTime is in IB's UTC form
+// ("YYYYMMDD-HH:MM:SS") and duration is a valid IB duration string for the bar size.
+struct HistoricalChunk {
+    time_t start = 0;
+    time_t end = 0;
+    std::string endDateTime;
+    std::string duration;
+};
+
+// Bar size setting in seconds ("5 mins" -> 300). Returns 0 if it cannot be parsed.
+long long barSizeSeconds(const std::string& barSize);
+
+// Largest duration TWS accepts for a bar size, per the "valid duration / bar size" table of
+// the historical data limitations. Months and years are expressed in weeks and days so every
+// chunk covers an exact number of seconds.
+long long maxChunkSeconds(const std::string& barSize);
+
+// Splits [start, end) into chunks of at most maxChunkSeconds, newest first (the order in
+// which TWS is cheapest to page). The oldest chunk may be shorter.
+std::vector<HistoricalChunk> planHistoricalChunks(time_t start, time_t end, const std::string& barSize);
+
+// "YYYYMMDD", "YYYYMMDD HH:MM:SS" or "YYYYMMDD-HH:MM:SS" as UTC; a trailing time zone is ignored.
+// Returns -1 if the string is not a date.
+time_t parseIbDateTime(const std::string& s);
+// Bar time as reported by TWS: epoch seconds (formatDate = 2) or one of the forms above.
+time_t parseBarTime(const std::string& s);
+std::string formatIbDateTimeUtc(time_t t);  // "YYYYMMDD-HH:MM:SS"
+
+// Sorts, drops empty ranges and joins overlapping or touching ones.
+std::vector<TimeRange> mergeRanges(std::vector<TimeRange> ranges);
+// Parts of `want` outside every range in `covered` (which must be merged).
+std::vector<TimeRange> subtractRanges(const TimeRange& want, const std::vector<TimeRange>& covered);
+// Joins neighbouring ranges while the joined span stays within maxSpan seconds, so a few
+// small gaps cost one request instead of one each. Input must be sorted and disjoint.
+std::vector<TimeRange> coalesceRanges(const std::vector<TimeRange>& ranges, long long maxSpan);
+
+// The part of `window` from the first to the last session bar inside it, or an empty range
+// at window.first if it holds no session at all (weekend, holiday). Sessions are sorted; daily
+// bars count a session as its whole trading date.
+TimeRange trimToSessions(const TimeRange& window, const std::vector<TradingSession>& sessions,
+                         long long barSeconds);
+// Runs of bars the sessions call for but `times` (ascending bar start times) lacks, within
+// [from, to). Runs of fewer than minMissingBars bars are ignored: an illiquid contract has
+// no TRADES bar for a minute without trades, so intraday callers usually want more than 1.
+std::vector<TimeRange> findBarGaps(const int64_t* times, size_t count,
+                                   const std::vector<TradingSession>& sessions, long long barSeconds,
+                                   time_t from, time_t to, size_t minMissingBars = 1);
+
+#endif // HISTORICAL_PLANNER_H
@@ -0,0 +1,218 @@
+#include "IndicatorBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+
+#include "BarSeries.h"
+#include "Indicators.h"
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+BarSeries syntheticBars(size_t n) {
+    std::mt19937_64 rng(42);
+    std::normal_distribution<double> step(0.0, 0.05);
+    std::uniform_real_distribution<double> range(0.0, 0.2);
+    std::uniform_int_distribution<int64_t> volume(100, 10000);
+    BarSeries bars;
+    bars.reserve(n);
+    double price = 100.0;
+    for (size_t i = 0; i < n; ++i) {
+        const double open = price;
+        price = std::max(1.0, price + step(rng));
+        const double high = std::max(open, price) + range(rng);
+        const double low = std::min(open, price) - range(rng);
+        bars.push_back(static_cast<int64_t>(i) * 60, open, high, low, price, volume(rng));
+    }
+    return bars;
+}
+
+// --- Naive baselines: one struct per bar, windows recomputed from scratch ---
+
+std::vector<double> naiveSma(const std::vector<HistoricalBar>& bars, size_t p) {
+    std::vector<double> out(bars.size(), kNaN);
+    for (size_t i = p - 1; i < bars.size(); ++i) {
+        double sum = 0.0;
+        for (size_t j = i + 1 - p; j <= i; ++j)
+            sum += bars[j].close;
+        out[i] = sum / static_cast<double>(p);
+    }
+    return out;
+}
+
+std::vector<double> naiveSmoothed(const std::vector<double>& x, size_t p, double alpha) {
+    std::vector<double> out(x.size(), kNaN);
+    if (x.size() < p)
+        return out;
+    double y = 0.0;
+    for (size_t j = 0; j < p; ++j)
+        y += x[j];
+    y /= static_cast<double>(p);
+    out[p - 1] = y;
+    for (size_t i = p; i < x.size(); ++i) {
+        y = alpha * x[i] + (1.0 - alpha) * y;
+        out[i] = y;
+    }
+    return out;
+}
+
+std::vector<double> naiveEma(const std::vector<HistoricalBar>& bars, size_t p) {
+    std::vector<double> closes;
+    for (const auto& b : bars)
+        closes.push_back(b.close);
+    return naiveSmoothed(closes, p, 2.0 / (static_cast<double>(p) + 1.0));
+}
+
+std::vector<double> naiveStdev(const std::vector<HistoricalBar>& bars, size_t p) {
+    std::vector<double> out(bars.size(), kNaN);
+    for (size_t i = p - 1; i < bars.size(); ++i) {
+        double mean = 0.0;
+        for (size_t j = i + 1 - p; j <= i; ++j)
+            mean += bars[j].close;
+        mean /= static_cast<double>(p);
+        double var = 0.0;
+        for (size_t j = i + 1 - p; j <= i; ++j)
+            var += (bars[j].close - mean) * (bars[j].close - mean);
+        out[i] = std::sqrt(var / static_cast<double>(p));
+    }
+    return out;
+}
+
+std::vector<double> naiveVwap(const std::vector<HistoricalBar>& bars, size_t p) {
+    std::vector<double> out(bars.size(), kNaN);
+    for (size_t i = p - 1; i < bars.size(); ++i) {
+        double pv = 0.0, v = 0.0;
+        for (size_t j = i + 1 - p; j <= i; ++j) {
+            const HistoricalBar& b = bars[j];
+            pv += (b.high + b.low + b.close) / 3.0 * static_cast<double>(b.volume);
+            v += static_cast<double>(b.volume);
+        }
+        out[i] = v > 0.0 ? pv / v : kNaN;
+    }
+    return out;
+}
+
+std::vector<double> naiveAtr(const std::vector<HistoricalBar>& bars, size_t p) {
+    std::vector<double> tr;
+    for (size_t i = 0; i < bars.size(); ++i) {
+        const HistoricalBar& b = bars[i];
+        double r = b.high - b.low;
+        if (i > 0) {
+            const double pc = bars[i - 1].close;
+            r = std::max(r, std::max(std::fabs(b.high - pc), std::fabs(b.low - pc)));
+        }
+        tr.push_back(r);
+    }
+    return naiveSmoothed(tr, p, 1.0 / static_cast<double>(p));
+}
+
+template <typename Fn>
+double bestOfThreeMs(Fn&& fn) {
+    double best = std::numeric_limits<double>::max();
+    for (int run = 0; run < 3; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, std::chrono::duration<double, std::milli>(elapsed).count());
+    }
+    return best;
+}
+
+double maxAbsDiff(const std::vector<double>& a, const std::vector<double>& b) {
+    double worst = 0.0;
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+        if (std::isnan(a[i]) != std::isnan(b[i]))
+            return std::numeric_limits<double>::infinity();
+        if (!std::isnan(a[i]))
+            worst = std::max(worst, std::fabs(a[i] - b[i]));
+    }
+    return worst;
+}
+
+struct Case {
+    const char* name;
+    std::function<std::vector<double>(const std::vector<HistoricalBar>&, size_t)> naive;
+    std::function<std::vector<double>(const BarView&, size_t)> batch;
+    std::function<std::vector<double>(const BarView&, size_t)> incremental;
+};
+
+template <typename Indicator, typename Push>
+std::vector<double> runIncremental(const BarView& bars, Indicator indicator, Push push) {
+    std::vector<double> out(bars.size());
+    for (size_t i = 0; i < bars.size(); ++i)
+        out[i] = push(indicator, bars, i);
+    return out;
+}
+
+} // namespace
+
+std::vector<IndicatorTiming> benchmarkIndicators(size_t n, size_t period) {
+    period = std::max<size_t>(period, 1);
+    const BarSeries series = syntheticBars(n);
+    const BarView bars = series.view();
+    std::vector<HistoricalBar> aos;
+    aos.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        aos.push_back(series[i]);
+
+    const std::vector<Case> cases = {
+        {"SMA", naiveSma, [](const BarView& b, size_t p) { return sma(b, p); },
+         [](const BarView& b, size_t p) {
+             return runIncremental(b, SmaIndicator(p), [](SmaIndicator& s, const BarView& v, size_t i) { return s.push(v.close[i]); });
+         }},
+        {"EMA", naiveEma, [](const BarView& b, size_t p) { return ema(b, p); },
+         [](const BarView& b, size_t p) {
+             return runIncremental(b, EmaIndicator(p), [](EmaIndicator& s, const BarView& v, size_t i) {
+                 const double x = s.push(v.close[i]);
+                 return s.ready() ? x : kNaN;
+             });
+         }},
+        {"Stdev", naiveStdev, [](const BarView& b, size_t p) { return rollingStdev(b, p); },
+         [](const BarView& b, size_t p) {
+             return runIncremental(b, StdevIndicator(p), [](StdevIndicator& s, const BarView& v, size_t i) { return s.push(v.close[i]); });
+         }},
+        {"VWAP", naiveVwap, [](const BarView& b, size_t p) { return vwap(b, p); },
+         [](const BarView& b, size_t p) {
+             return runIncremental(b, VwapIndicator(p), [](VwapIndicator& s, const BarView& v, size_t i) {
+                 return s.push(v.high[i], v.low[i], v.close[i], v.volume[i]);
+             });
+         }},
+        {"ATR", naiveAtr, [](const BarView& b, size_t p) { return atr(b, p); },
+         [](const BarView& b, size_t p) {
+             return runIncremental(b, AtrIndicator(p), [](AtrIndicator& s, const BarView& v, size_t i) {
+                 const double x = s.push(v.high[i], v.low[i], v.close[i]);
+                 return s.ready() ? x : kNaN;
+             });
+         }},
+    };
+
+    const SimdLevel saved = indicatorSimdLevel();
+    std::vector<IndicatorTiming> timings;
+    for (const Case& c : cases) {
+        IndicatorTiming t;
+        t.name = c.name;
+        std::vector<double> reference, result;
+        t.naiveMs = bestOfThreeMs([&] { reference = c.naive(aos, period); });
+
+        setIndicatorSimdLevel(SimdLevel::Scalar);
+        t.scalarMs = bestOfThreeMs([&] { result = c.batch(bars, period); });
+        t.maxError = maxAbsDiff(reference, result);
+
+        if (detectSimdLevel() == SimdLevel::Avx2) {
+            setIndicatorSimdLevel(SimdLevel::Avx2);
+            t.simdMs = bestOfThreeMs([&] { result = c.batch(bars, period); });
+            t.maxError = std::max(t.maxError, maxAbsDiff(reference, result));
+        }
+
+        t.incrementalMs = bestOfThreeMs([&] { result = c.incremental(bars, period); });
+        t.maxError = std::max(t.maxError, maxAbsDiff(reference, result));
+        timings.push_back(t);
+    }
+    setIndicatorSimdLevel(saved);
+    return timings;
+}
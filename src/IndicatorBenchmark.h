@@ -0,0 +1,20 @@
+#ifndef INDICATOR_BENCHMARK_H
+#define INDICATOR_BENCHMARK_H
+
+#include <cstddef>
+#include <vector>
+
+struct IndicatorTiming {
+    const char* name = "";
+    double naiveMs = 0.0;        // loop over std::vector<HistoricalBar>, window re-summed for every bar
+    double scalarMs = 0.0;       // batch kernels on columns, scalar path
+    double simdMs = -1.0;        // batch kernels on columns, AVX2 path (-1 if this CPU lacks AVX2)
+    double incrementalMs = 0.0;  // incremental indicator, one push() per bar
+    double maxError = 0.0;       // largest |batch - naive| over both batch paths and the incremental run
+};
+
+// Runs SMA, EMA, rolling stdev, VWAP and ATR over `bars` synthetic bars (seeded random walk)
+// with each implementation and reports the best of three runs.
+std::vector<IndicatorTiming> benchmarkIndicators(size_t bars, size_t period);
+
+#endif // INDICATOR_BENCHMARK_H
@@ -0,0 +1,560 @@
+#include "Indicators.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define INDICATORS_HAVE_AVX2 1
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// Every batch indicator is built from these column kernels. The running sums and the EMA
+// recurrence are both the linear scan out[i] = scale * in[i] + decay * out[i - 1]; the rest
+// are element-wise. Kernels that use a window only write i in [period, n); the caller fills
+// the first complete window itself.
+struct Kernels {
+    void (*scan)(const double* in, double* out, size_t n, double scale, double decay, double carry);
+    void (*anchor)(const double* x, size_t n, double x0, double* d, double* d2);
+    void (*windowMean)(const double* sum, double* out, size_t n, size_t period, double offset);
+    void (*windowStdev)(const double* sum, const double* sumSquares, double* out, size_t n, size_t period);
+    void (*windowRatio)(const double* num, const double* den, double* out, size_t n, size_t period);
+    void (*trueRange)(const double* high, const double* low, const double* close, double* out, size_t n);
+    void (*priceVolume)(const double* high, const double* low, const double* close, const double* volume,
+                        double* out, size_t n);
+};
+
+// --- Scalar kernels ---
+
+void scanScalar(const double* in, double* out, size_t n, double scale, double decay, double carry) {
+    for (size_t i = 0; i < n; ++i) {
+        carry = scale * in[i] + decay * carry;
+        out[i] = carry;
+    }
+}
+
+void anchorScalar(const double* x, size_t n, double x0, double* d, double* d2) {
+    for (size_t i = 0; i < n; ++i) {
+        d[i] = x[i] - x0;
+        if (d2)
+            d2[i] = d[i] * d[i];
+    }
+}
+
+void windowMeanScalar(const double* sum, double* out, size_t n, size_t period, double offset) {
+    const double inv = 1.0 / static_cast<double>(period);
+    for (size_t i = period; i < n; ++i)
+        out[i] = (sum[i] - sum[i - period]) * inv + offset;
+}
+
+void windowStdevScalar(const double* sum, const double* sumSquares, double* out, size_t n, size_t period) {
+    const double inv = 1.0 / static_cast<double>(period);
+    for (size_t i = period; i < n; ++i) {
+        const double mean = (sum[i] - sum[i - period]) * inv;
+        const double var = (sumSquares[i] - sumSquares[i - period]) * inv - mean * mean;
+        out[i] = std::sqrt(std::max(var, 0.0));
+    }
+}
+
+void windowRatioScalar(const double* num, const double* den, double* out, size_t n, size_t period) {
+    for (size_t i = period; i < n; ++i) {
+        const double d = period ? den[i] - den[i - period] : den[i];
+        const double v = period ? num[i] - num[i - period] : num[i];
+        out[i] = d > 0.0 ? v / d : kNaN;
+    }
+}
+
+void trueRangeScalar(const double* high, const double* low, const double* close, double* out, size_t n) {
+    for (size_t i = 1; i < n; ++i) {
+        const double hl = high[i] - low[i];
+        const double hc = std::fabs(high[i] - close[i - 1]);
+        const double lc = std::fabs(low[i] - close[i - 1]);
+        out[i] = std::max(hl, std::max(hc, lc));
+    }
+}
+
+void priceVolumeScalar(const double* high, const double* low, const double* close, const double* volume,
+                       double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = (high[i] + low[i] + close[i]) * (1.0 / 3.0) * volume[i];
+}
+
+constexpr Kernels kScalarKernels{scanScalar, anchorScalar, windowMeanScalar, windowStdevScalar,
+                                 windowRatioScalar, trueRangeScalar, priceVolumeScalar};
+
+// --- AVX2 kernels (4 doubles per register) ---
+
+#ifdef INDICATORS_HAVE_AVX2
+
+// Scan of a block of four: two shift-and-add steps give each lane the decayed sum of the
+// lanes before it, then the carry from the previous block is added with decay^(k+1).
+AVX2_TARGET void scanAvx2(const double* in, double* out, size_t n, double scale, double decay, double carry) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d s = _mm256_set1_pd(scale);
+    const __m256d d1 = _mm256_set1_pd(decay);
+    const __m256d d2 = _mm256_set1_pd(decay * decay);
+    const __m256d dk = _mm256_set_pd(decay * decay * decay * decay, decay * decay * decay, decay * decay, decay);
+    __m256d c = _mm256_set1_pd(carry);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d t = _mm256_mul_pd(s, _mm256_loadu_pd(in + i));
+        const __m256d shift1 = _mm256_blend_pd(_mm256_permute4x64_pd(t, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x1);
+        t = _mm256_fmadd_pd(d1, shift1, t);
+        const __m256d shift2 = _mm256_permute2f128_pd(t, t, 0x08);
+        t = _mm256_fmadd_pd(d2, shift2, t);
+        t = _mm256_fmadd_pd(dk, c, t);
+        _mm256_storeu_pd(out + i, t);
+        c = _mm256_permute4x64_pd(t, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    scanScalar(in + i, out + i, n - i, scale, decay, _mm256_cvtsd_f64(c));
+}
+
+AVX2_TARGET void anchorAvx2(const double* x, size_t n, double x0, double* d, double* d2) {
+    const __m256d base = _mm256_set1_pd(x0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d v = _mm256_sub_pd(_mm256_loadu_pd(x + i), base);
+        _mm256_storeu_pd(d + i, v);
+        if (d2)
+            _mm256_storeu_pd(d2 + i, _mm256_mul_pd(v, v));
+    }
+    anchorScalar(x + i, n - i, x0, d + i, d2 ? d2 + i : nullptr);
+}
+
+AVX2_TARGET void windowMeanAvx2(const double* sum, double* out, size_t n, size_t period, double offset) {
+    const __m256d inv = _mm256_set1_pd(1.0 / static_cast<double>(period));
+    const __m256d off = _mm256_set1_pd(offset);
+    size_t i = period;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d diff = _mm256_sub_pd(_mm256_loadu_pd(sum + i), _mm256_loadu_pd(sum + i - period));
+        _mm256_storeu_pd(out + i, _mm256_fmadd_pd(diff, inv, off));
+    }
+    for (; i < n; ++i)
+        out[i] = (sum[i] - sum[i - period]) * (1.0 / static_cast<double>(period)) + offset;
+}
+
+AVX2_TARGET void windowStdevAvx2(const double* sum, const double* sumSquares, double* out, size_t n, size_t period) {
+    const __m256d inv = _mm256_set1_pd(1.0 / static_cast<double>(period));
+    const __m256d zero = _mm256_setzero_pd();
+    size_t i = period;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d mean = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(sum + i), _mm256_loadu_pd(sum + i - period)), inv);
+        const __m256d sq = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(sumSquares + i),
+                                                       _mm256_loadu_pd(sumSquares + i - period)), inv);
+        const __m256d var = _mm256_max_pd(_mm256_fnmadd_pd(mean, mean, sq), zero);
+        _mm256_storeu_pd(out + i, _mm256_sqrt_pd(var));
+    }
+    for (; i < n; ++i) {
+        const double mean = (sum[i] - sum[i - period]) * (1.0 / static_cast<double>(period));
+        const double var = (sumSquares[i] - sumSquares[i - period]) * (1.0 / static_cast<double>(period)) - mean * mean;
+        out[i] = std::sqrt(std::max(var, 0.0));
+    }
+}
+
+AVX2_TARGET void windowRatioAvx2(const double* num, const double* den, double* out, size_t n, size_t period) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d nan = _mm256_set1_pd(kNaN);
+    size_t i = period;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(num + i);
+        __m256d d = _mm256_loadu_pd(den + i);
+        if (period) {
+            v = _mm256_sub_pd(v, _mm256_loadu_pd(num + i - period));
+            d = _mm256_sub_pd(d, _mm256_loadu_pd(den + i - period));
+        }
+        const __m256d hasVolume = _mm256_cmp_pd(d, zero, _CMP_GT_OQ);
+        _mm256_storeu_pd(out + i, _mm256_blendv_pd(nan, _mm256_div_pd(v, d), hasVolume));
+    }
+    for (; i < n; ++i) {
+        const double d = period ? den[i] - den[i - period] : den[i];
+        const double v = period ? num[i] - num[i - period] : num[i];
+        out[i] = d > 0.0 ? v / d : kNaN;
+    }
+}
+
+AVX2_TARGET void trueRangeAvx2(const double* high, const double* low, const double* close, double* out, size_t n) {
+    const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    size_t i = 1;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d h = _mm256_loadu_pd(high + i);
+        const __m256d l = _mm256_loadu_pd(low + i);
+        const __m256d pc = _mm256_loadu_pd(close + i - 1);
+        const __m256d hl = _mm256_sub_pd(h, l);
+        const __m256d hc = _mm256_and_pd(_mm256_sub_pd(h, pc), absMask);
+        const __m256d lc = _mm256_and_pd(_mm256_sub_pd(l, pc), absMask);
+        _mm256_storeu_pd(out + i, _mm256_max_pd(hl, _mm256_max_pd(hc, lc)));
+    }
+    if (i < n)
+        trueRangeScalar(high + i - 1, low + i - 1, close + i - 1, out + i - 1, n - i + 1);
+}
+
+AVX2_TARGET void priceVolumeAvx2(const double* high, const double* low, const double* close, const double* volume,
+                                 double* out, size_t n) {
+    const __m256d third = _mm256_set1_pd(1.0 / 3.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d sum = _mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(high + i), _mm256_loadu_pd(low + i)),
+                                          _mm256_loadu_pd(close + i));
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_mul_pd(sum, third), _mm256_loadu_pd(volume + i)));
+    }
+    priceVolumeScalar(high + i, low + i, close + i, volume + i, out + i, n - i);
+}
+
+constexpr Kernels kAvx2Kernels{scanAvx2, anchorAvx2, windowMeanAvx2, windowStdevAvx2,
+                               windowRatioAvx2, trueRangeAvx2, priceVolumeAvx2};
+
+#endif // INDICATORS_HAVE_AVX2
+
+std::atomic<SimdLevel> g_level{detectSimdLevel()};
+
+const Kernels& kernels() {
+#ifdef INDICATORS_HAVE_AVX2
+    if (g_level.load(std::memory_order_relaxed) == SimdLevel::Avx2)
+        return kAvx2Kernels;
+#endif
+    return kScalarKernels;
+}
+
+// out[i] = NaN for the warm-up, mean of x[0, period) at period - 1, then the recurrence
+// y = alpha * x + (1 - alpha) * y for the rest.
+void smoothed(const double* x, size_t n, size_t period, double alpha, double* out) {
+    std::fill(out, out + std::min(n, period - 1), kNaN);
+    if (n < period)
+        return;
+    const double seed = std::accumulate(x, x + period, 0.0) / static_cast<double>(period);
+    out[period - 1] = seed;
+    kernels().scan(x + period, out + period, n - period, alpha, 1.0 - alpha, seed);
+}
+
+std::vector<double> closes(const BarView& bars, size_t period,
+                           void (*fn)(const double*, size_t, size_t, double*)) {
+    std::vector<double> out(bars.size());
+    fn(bars.close, bars.size(), period, out.data());
+    return out;
+}
+
+} // namespace
+
+SimdLevel detectSimdLevel() {
+#ifdef INDICATORS_HAVE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SimdLevel::Avx2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+SimdLevel indicatorSimdLevel() {
+    return g_level.load(std::memory_order_relaxed);
+}
+
+void setIndicatorSimdLevel(SimdLevel level) {
+    if (level == SimdLevel::Avx2 && detectSimdLevel() != SimdLevel::Avx2)
+        level = SimdLevel::Scalar;
+    g_level.store(level, std::memory_order_relaxed);
+}
+
+const char* simdLevelName(SimdLevel level) {
+    return level == SimdLevel::Avx2 ? "AVX2" : "Scalar";
+}
+
+// Window sums come from prefix sums: sum(x[i-p+1..i]) = P[i] - P[i-p]. The outputs are
+// produced in blocks, and each block rebuilds its prefix (including the p - 1 inputs before
+// it) relative to its own first value, so the sums stay small and the differences keep their
+// precision however long the series is.
+template <typename Block>
+static void forEachWindowBlock(size_t n, size_t period, Block block) {
+    const size_t blockSize = std::max<size_t>(4096, 16 * period);
+    for (size_t first = period - 1; first < n; first += blockSize)
+        block(first + 1 - period, first, std::min(n, first + blockSize));
+}
+
+void sma(const double* x, size_t n, size_t period, double* out) {
+    if (period == 0) {
+        std::fill(out, out + n, kNaN);
+        return;
+    }
+    std::fill(out, out + std::min(n, period - 1), kNaN);
+    const Kernels& k = kernels();
+    std::vector<double> prefix;
+    forEachWindowBlock(n, period, [&](size_t from, size_t first, size_t end) {
+        // Local index j = i - from; the first window ends at j = period - 1.
+        const size_t len = end - from;
+        const double anchor = x[first];
+        prefix.resize(len);
+        k.anchor(x + from, len, anchor, prefix.data(), nullptr);
+        k.scan(prefix.data(), prefix.data(), len, 1.0, 1.0, 0.0);
+        out[first] = prefix[period - 1] / static_cast<double>(period) + anchor;
+        k.windowMean(prefix.data(), out + from, len, period, anchor);
+    });
+}
+
+void ema(const double* x, size_t n, size_t period, double* out) {
+    if (period == 0) {
+        std::fill(out, out + n, kNaN);
+        return;
+    }
+    smoothed(x, n, period, 2.0 / (static_cast<double>(period) + 1.0), out);
+}
+
+void rollingStdev(const double* x, size_t n, size_t period, double* out) {
+    if (period == 0) {
+        std::fill(out, out + n, kNaN);
+        return;
+    }
+    std::fill(out, out + std::min(n, period - 1), kNaN);
+    const Kernels& k = kernels();
+    std::vector<double> sum, sumSquares;
+    forEachWindowBlock(n, period, [&](size_t from, size_t first, size_t end) {
+        const size_t len = end - from;
+        sum.resize(len);
+        sumSquares.resize(len);
+        k.anchor(x + from, len, x[first], sum.data(), sumSquares.data());
+        k.scan(sum.data(), sum.data(), len, 1.0, 1.0, 0.0);
+        k.scan(sumSquares.data(), sumSquares.data(), len, 1.0, 1.0, 0.0);
+        const double inv = 1.0 / static_cast<double>(period);
+        const double mean = sum[period - 1] * inv;
+        out[first] = std::sqrt(std::max(sumSquares[period - 1] * inv - mean * mean, 0.0));
+        k.windowStdev(sum.data(), sumSquares.data(), out + from, len, period);
+    });
+}
+
+void vwap(const double* high, const double* low, const double* close, const int64_t* volume,
+          size_t n, size_t period, double* out) {
+    if (n == 0)
+        return;
+    const Kernels& k = kernels();
+    std::vector<double> pv(n), vol(n);
+    for (size_t i = 0; i < n; ++i)
+        vol[i] = static_cast<double>(volume[i]);
+    k.priceVolume(high, low, close, vol.data(), pv.data(), n);
+    k.scan(pv.data(), pv.data(), n, 1.0, 1.0, 0.0);
+    k.scan(vol.data(), vol.data(), n, 1.0, 1.0, 0.0);
+    if (period == 0) {
+        k.windowRatio(pv.data(), vol.data(), out, n, 0);
+        return;
+    }
+    std::fill(out, out + std::min(n, period - 1), kNaN);
+    if (n < period)
+        return;
+    out[period - 1] = vol[period - 1] > 0.0 ? pv[period - 1] / vol[period - 1] : kNaN;
+    k.windowRatio(pv.data(), vol.data(), out, n, period);
+}
+
+void atr(const double* high, const double* low, const double* close, size_t n, size_t period, double* out) {
+    if (period == 0 || n == 0) {
+        std::fill(out, out + n, kNaN);
+        return;
+    }
+    std::vector<double> tr(n);
+    tr[0] = high[0] - low[0];
+    kernels().trueRange(high, low, close, tr.data(), n);
+    smoothed(tr.data(), n, period, 1.0 / static_cast<double>(period), out);
+}
+
+std::vector<double> sma(const BarView& bars, size_t period) {
+    return closes(bars, period, sma);
+}
+
+std::vector<double> ema(const BarView& bars, size_t period) {
+    return closes(bars, period, ema);
+}
+
+std::vector<double> rollingStdev(const BarView& bars, size_t period) {
+    return closes(bars, period, rollingStdev);
+}
+
+std::vector<double> vwap(const BarView& bars, size_t period) {
+    std::vector<double> out(bars.size());
+    vwap(bars.high, bars.low, bars.close, bars.volume, bars.size(), period, out.data());
+    return out;
+}
+
+std::vector<double> atr(const BarView& bars, size_t period) {
+    std::vector<double> out(bars.size());
+    atr(bars.high, bars.low, bars.close, bars.size(), period, out.data());
+    return out;
+}
+
+// --- Incremental indicators ---
+
+RollingSum::RollingSum(size_t period) : m_values(std::max<size_t>(period, 1), 0.0) {}
+
+void RollingSum::push(double x) {
+    if (full())
+        m_sum -= m_values[m_head];
+    else
+        ++m_count;
+    m_values[m_head] = x;
+    m_sum += x;
+    m_last = m_head;
+    m_head = (m_head + 1) % m_values.size();
+    if (m_head == 0)
+        m_sum = std::accumulate(m_values.begin(), m_values.end(), 0.0);
+}
+
+void RollingSum::replaceLast(double x) {
+    if (m_count == 0) {
+        push(x);
+        return;
+    }
+    m_sum += x - m_values[m_last];
+    m_values[m_last] = x;
+}
+
+SmaIndicator::SmaIndicator(size_t period) : m_window(period) {}
+
+double SmaIndicator::push(double x) {
+    m_window.push(x);
+    ++m_pushed;
+    return value();
+}
+
+double SmaIndicator::replaceLast(double x) {
+    if (m_pushed == 0)
+        return push(x);
+    m_window.replaceLast(x);
+    return value();
+}
+
+double SmaIndicator::value() const {
+    return ready() ? m_window.sum() / static_cast<double>(m_window.count()) : kNaN;
+}
+
+EmaIndicator::EmaIndicator(size_t period)
+    : EmaIndicator(period, 2.0 / (static_cast<double>(std::max<size_t>(period, 1)) + 1.0)) {}
+
+EmaIndicator::EmaIndicator(size_t period, double alpha)
+    : m_period(std::max<size_t>(period, 1)), m_alpha(alpha), m_value(kNaN), m_previous(kNaN) {}
+
+EmaIndicator EmaIndicator::wilder(size_t period) {
+    return EmaIndicator(period, 1.0 / static_cast<double>(std::max<size_t>(period, 1)));
+}
+
+double EmaIndicator::push(double x) {
+    ++m_count;
+    m_previous = m_value;
+    m_lastInput = x;
+    if (m_count <= m_period) {
+        m_seedSum += x;
+        if (m_count == m_period)
+            m_value = m_seedSum / static_cast<double>(m_period);
+    } else {
+        m_value = m_alpha * x + (1.0 - m_alpha) * m_previous;
+    }
+    return m_value;
+}
+
+double EmaIndicator::replaceLast(double x) {
+    if (m_count == 0)
+        return push(x);
+    if (m_count <= m_period) {
+        m_seedSum += x - m_lastInput;
+        if (m_count == m_period)
+            m_value = m_seedSum / static_cast<double>(m_period);
+    } else {
+        m_value = m_alpha * x + (1.0 - m_alpha) * m_previous;
+    }
+    m_lastInput = x;
+    return m_value;
+}
+
+StdevIndicator::StdevIndicator(size_t period) : m_sum(period), m_sumSquares(period) {}
+
+double StdevIndicator::push(double x) {
+    if (m_pushed++ == 0)
+        m_anchor = x;
+    const double d = x - m_anchor;
+    m_sum.push(d);
+    m_sumSquares.push(d * d);
+    return value();
+}
+
+double StdevIndicator::replaceLast(double x) {
+    if (m_pushed == 0)
+        return push(x);
+    const double d = x - m_anchor;
+    m_sum.replaceLast(d);
+    m_sumSquares.replaceLast(d * d);
+    return value();
+}
+
+double StdevIndicator::value() const {
+    if (!ready())
+        return kNaN;
+    const double inv = 1.0 / static_cast<double>(m_sum.count());
+    const double mean = m_sum.sum() * inv;
+    return std::sqrt(std::max(m_sumSquares.sum() * inv - mean * mean, 0.0));
+}
+
+VwapIndicator::VwapIndicator(size_t period) : m_period(period), m_priceVolume(period), m_volume(period) {}
+
+double VwapIndicator::push(double high, double low, double close, int64_t volume) {
+    const double v = static_cast<double>(volume);
+    const double pv = (high + low + close) * (1.0 / 3.0) * v;
+    ++m_pushed;
+    if (m_period == 0) {
+        m_totalPv += pv;
+        m_totalVolume += v;
+        m_lastPv = pv;
+        m_lastVolume = v;
+    } else {
+        m_priceVolume.push(pv);
+        m_volume.push(v);
+    }
+    return value();
+}
+
+double VwapIndicator::replaceLast(double high, double low, double close, int64_t volume) {
+    if (m_pushed == 0)
+        return push(high, low, close, volume);
+    const double v = static_cast<double>(volume);
+    const double pv = (high + low + close) * (1.0 / 3.0) * v;
+    if (m_period == 0) {
+        m_totalPv += pv - m_lastPv;
+        m_totalVolume += v - m_lastVolume;
+        m_lastPv = pv;
+        m_lastVolume = v;
+    } else {
+        m_priceVolume.replaceLast(pv);
+        m_volume.replaceLast(v);
+    }
+    return value();
+}
+
+double VwapIndicator::value() const {
+    if (m_period == 0)
+        return m_totalVolume > 0.0 ? m_totalPv / m_totalVolume : kNaN;
+    if (!m_volume.full() || m_volume.sum() <= 0.0)
+        return kNaN;
+    return m_priceVolume.sum() / m_volume.sum();
+}
+
+static double trueRange(double high, double low, double previousClose) {
+    if (std::isnan(previousClose))
+        return high - low;
+    return std::max(high - low, std::max(std::fabs(high - previousClose), std::fabs(low - previousClose)));
+}
+
+AtrIndicator::AtrIndicator(size_t period)
+    : m_smooth(EmaIndicator::wilder(period)), m_previousClose(kNaN), m_lastClose(kNaN) {}
+
+double AtrIndicator::push(double high, double low, double close) {
+    m_previousClose = m_lastClose;
+    m_lastClose = close;
+    return m_smooth.push(trueRange(high, low, m_previousClose));
+}
+
+double AtrIndicator::replaceLast(double high, double low, double close) {
+    if (m_smooth.count() == 0)
+        return push(high, low, close);
+    m_lastClose = close;
+    return m_smooth.replaceLast(trueRange(high, low, m_previousClose));
+}
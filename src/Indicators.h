@@ -0,0 +1,159 @@
+#ifndef INDICATORS_H
+#define INDICATORS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BarSeries.h"
+
+// Technical indicators over bar columns, in two forms:
+//  - batch functions that fill a whole output column from a history (entries before the first
+//    complete window are NaN), and
+//  - incremental classes updated in O(1) per bar, for live series. replaceLast() revises the
+//    newest input, which is what a keepUpToDate update of the forming bar needs.
+// Batch functions use AVX2/FMA kernels when the CPU has them and a scalar path otherwise;
+// the choice is made once at startup and can be overridden with setIndicatorSimdLevel().
+
+enum class SimdLevel : uint8_t { Scalar, Avx2 };
+
+SimdLevel detectSimdLevel();                 // best level this CPU supports
+SimdLevel indicatorSimdLevel();              // level the batch functions currently use
+void setIndicatorSimdLevel(SimdLevel level); // clamped to detectSimdLevel()
+const char* simdLevelName(SimdLevel level);
+
+// Simple moving average.
+void sma(const double* x, size_t n, size_t period, double* out);
+// Exponential moving average, alpha = 2 / (period + 1), seeded with the SMA of the first period.
+void ema(const double* x, size_t n, size_t period, double* out);
+// Population standard deviation over the window.
+void rollingStdev(const double* x, size_t n, size_t period, double* out);
+// Volume-weighted average of the typical price (h + l + c) / 3 over the window;
+// period 0 accumulates from the first bar. NaN where the window has no volume.
+void vwap(const double* high, const double* low, const double* close, const int64_t* volume,
+          size_t n, size_t period, double* out);
+// Average true range with Wilder smoothing (alpha = 1 / period).
+void atr(const double* high, const double* low, const double* close, size_t n, size_t period, double* out);
+
+// Same, over bars (closes for the single-column indicators).
+std::vector<double> sma(const BarView& bars, size_t period);
+std::vector<double> ema(const BarView& bars, size_t period);
+std::vector<double> rollingStdev(const BarView& bars, size_t period);
+std::vector<double> vwap(const BarView& bars, size_t period);
+std::vector<double> atr(const BarView& bars, size_t period);
+
+// Sum of the last `period` values. The sum is rebuilt from the window every time the ring
+// wraps, so rounding error does not build up over a long live session.
+class RollingSum {
+public:
+    explicit RollingSum(size_t period);
+
+    void push(double x);
+    void replaceLast(double x);
+    double sum() const { return m_sum; }
+    size_t count() const { return m_count; }
+    bool full() const { return m_count == m_values.size(); }
+
+private:
+    std::vector<double> m_values;
+    size_t m_head = 0;
+    size_t m_last = 0;
+    size_t m_count = 0;
+    double m_sum = 0.0;
+};
+
+class SmaIndicator {
+public:
+    explicit SmaIndicator(size_t period);
+
+    double push(double x);
+    double replaceLast(double x);
+    double value() const;
+    bool ready() const { return m_window.full(); }
+    size_t count() const { return m_pushed; }
+
+private:
+    RollingSum m_window;
+    size_t m_pushed = 0;
+};
+
+class EmaIndicator {
+public:
+    explicit EmaIndicator(size_t period);
+    // Wilder smoothing (alpha = 1 / period), as used by ATR and RSI.
+    static EmaIndicator wilder(size_t period);
+
+    double push(double x);
+    double replaceLast(double x);
+    double value() const { return m_value; }
+    bool ready() const { return m_count >= m_period; }
+    size_t count() const { return m_count; }
+
+private:
+    EmaIndicator(size_t period, double alpha);
+
+    size_t m_period;
+    double m_alpha;
+    size_t m_count = 0;
+    double m_seedSum = 0.0;
+    double m_lastInput = 0.0;
+    double m_value;
+    double m_previous;  // value before the newest input
+};
+
+class StdevIndicator {
+public:
+    explicit StdevIndicator(size_t period);
+
+    double push(double x);
+    double replaceLast(double x);
+    double value() const;
+    bool ready() const { return m_sum.full(); }
+    size_t count() const { return m_pushed; }
+
+private:
+    // Values are taken relative to the first input to keep sum - sum^2 cancellation small.
+    double m_anchor = 0.0;
+    RollingSum m_sum;
+    RollingSum m_sumSquares;
+    size_t m_pushed = 0;
+};
+
+class VwapIndicator {
+public:
+    explicit VwapIndicator(size_t period);  // 0 = cumulative
+
+    double push(double high, double low, double close, int64_t volume);
+    double replaceLast(double high, double low, double close, int64_t volume);
+    double value() const;
+    size_t count() const { return m_pushed; }
+
+private:
+    size_t m_period;
+    RollingSum m_priceVolume;
+    RollingSum m_volume;
+    // Cumulative mode only.
+    double m_totalPv = 0.0;
+    double m_totalVolume = 0.0;
+    double m_lastPv = 0.0;
+    double m_lastVolume = 0.0;
+    size_t m_pushed = 0;
+};
+
+class AtrIndicator {
+public:
+    explicit AtrIndicator(size_t period);
+
+    double push(double high, double low, double close);
+    double replaceLast(double high, double low, double close);
+    double value() const { return m_smooth.value(); }
+    bool ready() const { return m_smooth.ready(); }
+    size_t count() const { return m_smooth.count(); }
+
+private:
+    EmaIndicator m_smooth;
+    double m_previousClose;  // close of the bar before the newest one
+    double m_lastClose;
+};
+
+#endif // INDICATORS_H
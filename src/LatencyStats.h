@@ -0,0 +1,43 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Percentile summary of a set of latency samples (all values in microseconds).
+struct LatencySummary {
+    size_t count = 0;
+    double min = 0.0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double p999 = 0.0;
+    double max = 0.0;
+};
+
+// Sorts the samples in place.
+inline LatencySummary summarizeLatencies(std::vector<double>& samples) {
+    LatencySummary s;
+    s.count = samples.size();
+    if (samples.empty())
+        return s;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        size_t idx = static_cast<size_t>(q * static_cast<double>(samples.size() - 1) + 0.5);
+        return samples[std::min(idx, samples.size() - 1)];
+    };
+    double sum = 0.0;
+    for (double v : samples) sum += v;
+    s.min = samples.front();
+    s.max = samples.back();
+    s.mean = sum / static_cast<double>(samples.size());
+    s.p50 = at(0.50);
+    s.p90 = at(0.90);
+    s.p99 = at(0.99);
+    s.p999 = at(0.999);
+    return s;
+}
+
+#endif // LATENCY_STATS_H
@@ -0,0 +1,139 @@
+#include "LinkMonitor.h"
+
+#include <algorithm>
+#include <iostream>
+
+LinkMonitor::LinkMonitor(std::function<void()> sendProbe) : m_sendProbe(std::move(sendProbe)) {}
+
+LinkMonitor::~LinkMonitor() {
+    stop();
+}
+
+void LinkMonitor::start(const LinkMonitorConfig& config) {
+    stop();
+    if (!config.enabled)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_config = config;
+        if (m_config.window == 0)
+            m_config.window = 1;
+        m_samples.clear();
+        m_samples.reserve(m_config.window);
+        m_nextSample = 0;
+        m_counters = LinkStats{};
+        m_probeInFlight = false;
+        m_running = true;
+    }
+    m_lastRttUs.store(0.0, std::memory_order_relaxed);
+    noteReaderActivity();
+    m_thread = std::thread([this]() { run(); });
+}
+
+void LinkMonitor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void LinkMonitor::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto nextProbe = std::chrono::steady_clock::now();
+    while (m_running) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= nextProbe) {
+            if (m_probeInFlight)
+                ++m_counters.probesLost; // the reply would be mismatched; start over with a new probe
+            m_probeInFlight = true;
+            m_probeSent = now;
+            m_probeSentWall = std::chrono::system_clock::now();
+            ++m_counters.probesSent;
+            nextProbe = now + m_config.probeInterval;
+            lock.unlock();
+            m_sendProbe();
+            lock.lock();
+        }
+        checkStalls();
+        // Wake at least a few times per stall threshold so stalls are reported promptly.
+        auto wake = std::min(nextProbe, std::chrono::steady_clock::now() + m_config.stallThreshold / 4);
+        m_cond.wait_until(lock, wake, [this]() { return !m_running; });
+    }
+}
+
+// Called with m_mutex held.
+void LinkMonitor::checkStalls() {
+    const int64_t thresholdMs = m_config.stallThreshold.count();
+    const int64_t idleMs = (nowNs() - m_readerActivityNs.load(std::memory_order_relaxed)) / 1000000;
+    const bool readerStalled = idleMs > thresholdMs;
+    if (readerStalled && !m_counters.readerStalled) {
+        ++m_counters.readerStalls;
+        std::cerr << "warning at LinkMonitor: reader loop idle for " << idleMs << " ms" << std::endl;
+    }
+    m_counters.readerStalled = readerStalled;
+
+    int64_t outstandingMs = 0;
+    if (m_probeInFlight)
+        outstandingMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - m_probeSent).count();
+    const bool linkStalled = outstandingMs > thresholdMs;
+    if (linkStalled && !m_counters.linkStalled) {
+        ++m_counters.linkStalls;
+        std::cerr << "warning at LinkMonitor: no heartbeat reply for " << outstandingMs << " ms" << std::endl;
+    }
+    m_counters.linkStalled = linkStalled;
+}
+
+void LinkMonitor::onServerTime(int64_t serverMillis) {
+    const auto received = std::chrono::steady_clock::now();
+    const auto receivedWall = std::chrono::system_clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_probeInFlight)
+        return; // unsolicited or already written off as lost
+    m_probeInFlight = false;
+
+    const double rttUs = std::chrono::duration<double, std::micro>(received - m_probeSent).count();
+    // Assume the server stamped the reply halfway through the round trip.
+    const double sentMs = std::chrono::duration<double, std::milli>(m_probeSentWall.time_since_epoch()).count();
+    const double receivedMs = std::chrono::duration<double, std::milli>(receivedWall.time_since_epoch()).count();
+    const double offsetMs = static_cast<double>(serverMillis) - (sentMs + receivedMs) / 2.0;
+
+    Sample sample{rttUs, offsetMs};
+    if (m_samples.size() < m_config.window)
+        m_samples.push_back(sample);
+    else
+        m_samples[m_nextSample] = sample;
+    m_nextSample = (m_nextSample + 1) % m_config.window;
+
+    ++m_counters.probesAnswered;
+    m_counters.lastRttUs = rttUs;
+    m_counters.lastOffsetMs = offsetMs;
+    m_lastRttUs.store(rttUs, std::memory_order_relaxed);
+}
+
+LinkStats LinkMonitor::stats() const {
+    std::vector<double> rtts;
+    LinkStats out;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out = m_counters;
+        rtts.reserve(m_samples.size());
+        double bestRtt = 0.0;
+        for (const auto& s : m_samples) {
+            rtts.push_back(s.rttUs);
+            if (rtts.size() == 1 || s.rttUs < bestRtt) {
+                bestRtt = s.rttUs;
+                out.bestOffsetMs = s.offsetMs;
+            }
+        }
+        if (m_probeInFlight)
+            out.probeOutstandingMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - m_probeSent).count();
+    }
+    out.readerIdleMs = (nowNs() - m_readerActivityNs.load(std::memory_order_relaxed)) / 1000000;
+    out.rtt = summarizeLatencies(rtts);
+    return out;
+}
@@ -0,0 +1,99 @@
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "LatencyStats.h"
+
+struct LinkMonitorConfig {
+    bool enabled = true;
+    std::chrono::milliseconds probeInterval{1000};  // how often reqCurrentTimeInMillis is sent
+    std::chrono::milliseconds stallThreshold{3000}; // reader idle / probe unanswered longer than this = stall
+    size_t window = 256;                            // samples kept for the rolling statistics
+};
+
+// Snapshot of the link health. RTT values are in microseconds, offsets in milliseconds
+// (TWS reports its clock with millisecond resolution). Offset is TWS clock minus local clock.
+struct LinkStats {
+    LatencySummary rtt;            // over the rolling window
+    double lastRttUs = 0.0;
+    double lastOffsetMs = 0.0;
+    double bestOffsetMs = 0.0;     // offset of the lowest-RTT sample in the window (least skewed)
+    uint64_t probesSent = 0;
+    uint64_t probesAnswered = 0;
+    uint64_t probesLost = 0;       // still unanswered when the next probe was due
+    uint64_t readerStalls = 0;
+    uint64_t linkStalls = 0;
+    int64_t readerIdleMs = 0;      // since the reader loop last completed an iteration
+    int64_t probeOutstandingMs = 0;
+    bool readerStalled = false;
+    bool linkStalled = false;
+};
+
+// Heartbeat over the TWS connection. A background thread sends a probe every probeInterval
+// and the currentTimeInMillis reply is matched to it (only one probe is in flight at a time,
+// since the reply carries no request id). The same thread watches the reader loop's
+// activity timestamp and reports a stall when either side goes quiet for too long.
+class LinkMonitor {
+public:
+    explicit LinkMonitor(std::function<void()> sendProbe);
+    ~LinkMonitor();
+
+    LinkMonitor(const LinkMonitor&) = delete;
+    LinkMonitor& operator=(const LinkMonitor&) = delete;
+
+    void start(const LinkMonitorConfig& config);
+    void stop();
+
+    // Called from the reader thread.
+    void onServerTime(int64_t serverMillis);
+    void noteReaderActivity() {
+        m_readerActivityNs.store(nowNs(), std::memory_order_relaxed);
+    }
+
+    LinkStats stats() const;
+    // Cheap read for hot paths (e.g. stamping order updates).
+    double lastRttUs() const { return m_lastRttUs.load(std::memory_order_relaxed); }
+
+private:
+    struct Sample {
+        double rttUs;
+        double offsetMs;
+    };
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    void run();
+    void checkStalls();
+
+    std::function<void()> m_sendProbe;
+    LinkMonitorConfig m_config;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_running = false;
+    std::thread m_thread;
+
+    // Outstanding probe, guarded by m_mutex.
+    bool m_probeInFlight = false;
+    std::chrono::steady_clock::time_point m_probeSent;
+    std::chrono::system_clock::time_point m_probeSentWall;
+
+    std::vector<Sample> m_samples;  // ring buffer of m_config.window entries
+    size_t m_nextSample = 0;
+    LinkStats m_counters;           // counters and last values; rtt summary is built on demand
+
+    std::atomic<int64_t> m_readerActivityNs{0};
+    std::atomic<double> m_lastRttUs{0.0};
+};
+
+#endif // LINK_MONITOR_H
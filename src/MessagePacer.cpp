@@ -0,0 +1,37 @@
+#include "MessagePacer.h"
+
+#include <algorithm>
+#include <thread>
+
+MessagePacer::MessagePacer(int maxPerSecond) : m_maxPerSecond(std::max(1, maxPerSecond)) {}
+
+// Called with m_mutex held.
+void MessagePacer::prune(Clock::time_point now) {
+    while (!m_sent.empty() && now - m_sent.front() >= std::chrono::seconds(1))
+        m_sent.pop_front();
+}
+
+void MessagePacer::acquire(int messages) {
+    messages = std::clamp(messages, 1, m_maxPerSecond);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        const auto now = Clock::now();
+        prune(now);
+        if (static_cast<int>(m_sent.size()) + messages <= m_maxPerSecond) {
+            m_sent.insert(m_sent.end(), static_cast<size_t>(messages), now);
+            return;
+        }
+        // Sleep without the lock until enough of the oldest entries have left the window.
+        const auto until = m_sent[m_sent.size() + messages - m_maxPerSecond - 1] + std::chrono::seconds(1);
+        lock.unlock();
+        std::this_thread::sleep_until(until);
+        lock.lock();
+    }
+}
+
+void MessagePacer::record() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto now = Clock::now();
+    prune(now);
+    m_sent.push_back(now);
+}
@@ -0,0 +1,33 @@
+#ifndef MESSAGE_PACER_H
+#define MESSAGE_PACER_H
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+// Sliding one-second budget for every message the client sends to TWS, which disconnects
+// clients above 50 messages per second. All threads that send draw from one instance, so
+// concurrent quote, order, contract and P&L requests are counted together.
+class MessagePacer {
+public:
+    explicit MessagePacer(int maxPerSecond);
+
+    MessagePacer(const MessagePacer&) = delete;
+    MessagePacer& operator=(const MessagePacer&) = delete;
+
+    // Blocks until `messages` more fit into the last second, then counts them as sent now.
+    void acquire(int messages = 1);
+    // Counts a message that goes out immediately whatever the budget (the link probe, whose
+    // round trip a wait would distort). Later acquire() calls wait for it.
+    void record();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    void prune(Clock::time_point now);
+
+    const int m_maxPerSecond;
+    std::mutex m_mutex;  // guards m_sent
+    std::deque<Clock::time_point> m_sent;  // one entry per message of the last second
+};
+
+#endif // MESSAGE_PACER_H
@@ -0,0 +1,271 @@
+#include "OptionChain.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+constexpr const char* kFileTag = "OPTIONCHAIN 1";
+constexpr double kSecondsPerYear = 365.0 * 86400.0;
+
+double blackScholesDelta(OptionRight right, double spot, double strike, double volatility,
+                         double years, double rate) {
+    const double sd = volatility * std::sqrt(years);
+    const double d1 = (std::log(spot / strike) + (rate + 0.5 * volatility * volatility) * years) / sd;
+    const double callDelta = 0.5 * std::erfc(-d1 / std::sqrt(2.0));
+    return right == OptionRight::Call ? callDelta : callDelta - 1.0;
+}
+
+} // namespace
+
+bool parseOccSymbol(std::string_view symbol, OccSymbol& out) {
+    // The last 15 characters are fixed width: yyMMdd, C/P, 8-digit strike.
+    constexpr size_t kTail = 6 + 1 + 8;
+    if (symbol.size() <= kTail)
+        return false;
+    const size_t tail = symbol.size() - kTail;
+    size_t rootEnd = tail;
+    while (rootEnd > 0 && symbol[rootEnd - 1] == ' ')
+        --rootEnd;
+    if (rootEnd == 0 || rootEnd > 6)
+        return false;
+    for (size_t i = 0; i < rootEnd; ++i) {
+        const char c = symbol[i];
+        if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')))
+            return false;
+    }
+
+    auto digits = [&](size_t from, size_t count, int64_t& value) {
+        value = 0;
+        for (size_t i = from; i < from + count; ++i) {
+            const char c = symbol[i];
+            if (c < '0' || c > '9')
+                return false;
+            value = value * 10 + (c - '0');
+        }
+        return true;
+    };
+    int64_t date = 0, strike = 0;
+    if (!digits(tail, 6, date) || !digits(tail + 7, 8, strike))
+        return false;
+    const int64_t month = date / 100 % 100, day = date % 100;
+    if (month < 1 || month > 12 || day < 1 || day > 31)
+        return false;
+    const char right = symbol[tail + 6];
+    if (right != 'C' && right != 'P')
+        return false;
+
+    out.root = symbol.substr(0, rootEnd);
+    out.expiry = static_cast<int32_t>(20000000 + date);
+    out.right = right == 'C' ? OptionRight::Call : OptionRight::Put;
+    out.strikeMillis = strike;
+    return true;
+}
+
+int32_t utcDateYmd(time_t t) {
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    return (tm.tm_year + 1900) * 10000 + (tm.tm_mon + 1) * 100 + tm.tm_mday;
+}
+
+time_t OptionChain::expiryTime(int32_t date) {
+    std::tm tm{};
+    tm.tm_year = date / 10000 - 1900;
+    tm.tm_mon = date / 100 % 100 - 1;
+    tm.tm_mday = date % 100;
+    tm.tm_hour = 21;
+    return timegm(&tm);
+}
+
+OptionChain OptionChain::build(const std::string& symbol, int underlyingConId,
+                               const std::vector<OptionChainParams>& rows, int32_t today) {
+    const bool haveSmart = std::any_of(rows.begin(), rows.end(),
+                                       [](const OptionChainParams& r) { return r.exchange == "SMART"; });
+    // Keyed by (date, trading class): the same date can be listed by two classes (SPX and SPXW).
+    std::map<std::pair<int32_t, std::string>, Expiry> merged;
+    for (const auto& row : rows) {
+        if (haveSmart && row.exchange != "SMART")
+            continue;
+        for (const auto& e : row.expirations) {
+            const int32_t date = static_cast<int32_t>(std::atol(e.c_str()));
+            if (date < today)
+                continue;
+            Expiry& expiry = merged[{date, row.tradingClass}];
+            expiry.date = date;
+            expiry.tradingClass = row.tradingClass;
+            expiry.multiplier = row.multiplier;
+            expiry.strikes.insert(expiry.strikes.end(), row.strikes.begin(), row.strikes.end());
+        }
+    }
+
+    OptionChain chain;
+    chain.m_symbol = symbol;
+    chain.m_underlyingConId = underlyingConId;
+    chain.m_fetchedDate = today;
+    chain.m_expiries.reserve(merged.size());
+    for (auto& [key, expiry] : merged) {
+        std::sort(expiry.strikes.begin(), expiry.strikes.end());
+        expiry.strikes.erase(std::unique(expiry.strikes.begin(), expiry.strikes.end()), expiry.strikes.end());
+        if (!expiry.strikes.empty())
+            chain.m_expiries.push_back(std::move(expiry));
+    }
+    chain.assignSlots();
+    return chain;
+}
+
+void OptionChain::assignSlots() {
+    m_slotCount = 0;
+    for (auto& e : m_expiries) {
+        e.firstSlot = m_slotCount;
+        m_slotCount += 2 * e.strikes.size();
+    }
+}
+
+long OptionChain::findExpiry(int32_t date) const {
+    const size_t i = firstExpiryFrom(date);
+    return i < m_expiries.size() && m_expiries[i].date == date ? static_cast<long>(i) : -1;
+}
+
+size_t OptionChain::firstExpiryFrom(int32_t date) const {
+    auto it = std::lower_bound(m_expiries.begin(), m_expiries.end(), date,
+                               [](const Expiry& e, int32_t d) { return e.date < d; });
+    return static_cast<size_t>(it - m_expiries.begin());
+}
+
+size_t OptionChain::nearestStrike(size_t expiry, double price) const {
+    const std::vector<double>& strikes = m_expiries[expiry].strikes;
+    const size_t i = static_cast<size_t>(std::lower_bound(strikes.begin(), strikes.end(), price) - strikes.begin());
+    if (i == 0)
+        return 0;
+    if (i == strikes.size())
+        return i - 1;
+    return price - strikes[i - 1] <= strikes[i] - price ? i - 1 : i;
+}
+
+size_t OptionChain::strikeForDelta(size_t expiry, OptionRight right, double delta, double underlyingPrice,
+                                   double volatility, time_t now, double rate) const {
+    const std::vector<double>& strikes = m_expiries[expiry].strikes;
+    // At or past expiry the delta is a step at the spot; an hour keeps the search well defined.
+    const double years = std::max(3600.0, static_cast<double>(expiryTime(m_expiries[expiry].date) - now)) / kSecondsPerYear;
+    auto deltaAt = [&](size_t i) {
+        return blackScholesDelta(right, underlyingPrice, strikes[i], std::max(volatility, 1e-4), years, rate);
+    };
+
+    // First strike whose delta is at or below the target.
+    size_t lo = 0, hi = strikes.size();
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (deltaAt(mid) > delta)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == strikes.size())
+        return lo - 1;
+    if (lo > 0 && std::abs(deltaAt(lo - 1) - delta) < std::abs(deltaAt(lo) - delta))
+        return lo - 1;
+    return lo;
+}
+
+std::vector<size_t> OptionChain::deltaBuckets(size_t expiry, OptionRight right, const std::vector<double>& deltas,
+                                              double underlyingPrice, double volatility, time_t now,
+                                              double rate) const {
+    std::vector<size_t> out;
+    out.reserve(deltas.size());
+    for (double d : deltas)
+        out.push_back(strikeForDelta(expiry, right, d, underlyingPrice, volatility, now, rate));
+    return out;
+}
+
+OptionKey OptionChain::key(size_t slot) const {
+    auto it = std::upper_bound(m_expiries.begin(), m_expiries.end(), slot,
+                               [](size_t s, const Expiry& e) { return s < e.firstSlot; });
+    OptionKey k;
+    k.expiry = static_cast<size_t>(it - m_expiries.begin()) - 1;
+    const size_t offset = slot - m_expiries[k.expiry].firstSlot;
+    k.strike = offset / 2;
+    k.right = offset % 2 ? OptionRight::Put : OptionRight::Call;
+    return k;
+}
+
+std::string OptionChain::occSymbol(size_t expiry, size_t strike, OptionRight right) const {
+    const Expiry& e = m_expiries[expiry];
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%06d%c%08lld", e.date % 1000000, right == OptionRight::Call ? 'C' : 'P',
+                  std::llround(e.strikes[strike] * 1000.0));
+    // The OCC root is the trading class (SPXW for the SPX weeklies), not the underlying.
+    return (e.tradingClass.empty() ? m_symbol : e.tradingClass) + buf;
+}
+
+bool OptionChain::save(const std::string& path) const {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << kFileTag << '\n'
+            << m_symbol << '\t' << m_underlyingConId << '\t' << m_fetchedDate << '\n'
+            << std::setprecision(std::numeric_limits<double>::max_digits10);
+        for (const auto& e : m_expiries) {
+            out << e.date << '\t' << e.tradingClass << '\t' << e.multiplier << '\t';
+            for (size_t i = 0; i < e.strikes.size(); ++i)
+                out << (i ? " " : "") << e.strikes[i];
+            out << '\n';
+        }
+        if (!out) {
+            std::cerr << "error at OptionChain::save: cannot write " << tmp << std::endl;
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "error at OptionChain::save: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+OptionChain OptionChain::load(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line) || line != kFileTag)
+        return {};
+
+    OptionChain chain;
+    {
+        if (!std::getline(in, line))
+            return {};
+        std::istringstream header(line);
+        std::string conId, fetched;
+        if (!std::getline(header, chain.m_symbol, '\t') || !std::getline(header, conId, '\t') ||
+            !std::getline(header, fetched))
+            return {};
+        chain.m_underlyingConId = std::atoi(conId.c_str());
+        chain.m_fetchedDate = static_cast<int32_t>(std::atol(fetched.c_str()));
+    }
+    while (std::getline(in, line)) {
+        std::istringstream row(line);
+        Expiry e;
+        std::string date, strikes;
+        if (!std::getline(row, date, '\t') || !std::getline(row, e.tradingClass, '\t') ||
+            !std::getline(row, e.multiplier, '\t') || !std::getline(row, strikes))
+            return {};
+        e.date = static_cast<int32_t>(std::atol(date.c_str()));
+        std::istringstream values(strikes);
+        for (double k; values >> k;)
+            e.strikes.push_back(k);
+        if (e.strikes.empty() || !std::is_sorted(e.strikes.begin(), e.strikes.end()))
+            return {};
+        chain.m_expiries.push_back(std::move(e));
+    }
+    chain.assignSlots();
+    return chain;
+}
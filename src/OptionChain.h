@@ -0,0 +1,121 @@
+#ifndef OPTION_CHAIN_H
+#define OPTION_CHAIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class OptionRight : uint8_t { Call, Put };
+
+// One securityDefinitionOptionalParameter row: the expirations and strikes an underlying
+// has on one exchange for one trading class (e.g. SPX and SPXW are separate rows).
+struct OptionChainParams {
+    std::string exchange;
+    int underlyingConId = 0;
+    std::string tradingClass;
+    std::string multiplier;
+    std::set<std::string> expirations;  // YYYYMMDD
+    std::set<double> strikes;
+};
+
+// Fields of an OCC option symbol: the root, then fixed-width yyMMdd, C or P and the strike in
+// thousandths ("AAPL250321C00170000"; the root may also be space-padded to six characters).
+struct OccSymbol {
+    std::string_view root;     // points into the parsed string
+    int32_t expiry = 0;        // YYYYMMDD
+    OptionRight right = OptionRight::Call;
+    int64_t strikeMillis = 0;  // strike x 1000
+    double strike() const { return static_cast<double>(strikeMillis) / 1000.0; }
+};
+
+// Decodes an OCC symbol without allocating or throwing; false if it is malformed.
+bool parseOccSymbol(std::string_view symbol, OccSymbol& out);
+
+// Position of one contract in the chain.
+struct OptionKey {
+    size_t expiry = 0;
+    size_t strike = 0;
+    OptionRight right = OptionRight::Call;
+};
+
+// Expirations and strikes of one underlying, indexed for lookups by expiry date, strike and
+// delta. Expiries are sorted by date and each holds its sorted strikes. Every contract
+// (expiry, strike, right) owns a dense slot number, calls and puts of a strike side by side,
+// so per-contract data such as quotes can live in flat arrays indexed by slot.
+// TWS reports strikes per trading class, not per expiry, so an expiry lists every strike
+// of its class; a few of those contracts may not actually be listed.
+class OptionChain {
+public:
+    struct Expiry {
+        int32_t date = 0;        // YYYYMMDD
+        std::string tradingClass;
+        std::string multiplier;
+        size_t firstSlot = 0;
+        std::vector<double> strikes;
+    };
+
+    OptionChain() = default;
+    // Merges the rows of one reqSecDefOptParams answer. Rows from SMART are used when there
+    // are any, otherwise all exchanges are merged. Expiries before `today` (YYYYMMDD) are dropped.
+    static OptionChain build(const std::string& symbol, int underlyingConId,
+                             const std::vector<OptionChainParams>& rows, int32_t today);
+
+    const std::string& symbol() const { return m_symbol; }
+    int underlyingConId() const { return m_underlyingConId; }
+    int32_t fetchedDate() const { return m_fetchedDate; }
+    bool empty() const { return m_expiries.empty(); }
+
+    const std::vector<Expiry>& expiries() const { return m_expiries; }
+    const Expiry& expiry(size_t i) const { return m_expiries[i]; }
+    size_t slotCount() const { return m_slotCount; }
+
+    // Index of the expiry on `date`, or -1.
+    long findExpiry(int32_t date) const;
+    // Index of the first expiry on or after `date`, or expiries().size() if none.
+    size_t firstExpiryFrom(int32_t date) const;
+    // Index of the strike closest to `price` (the lower one on a tie). The expiry must have strikes.
+    size_t nearestStrike(size_t expiry, double price) const;
+    size_t atmStrike(size_t expiry, double underlyingPrice) const { return nearestStrike(expiry, underlyingPrice); }
+    // Index of the strike whose Black-Scholes delta is closest to `delta` (e.g. 0.25 for a
+    // 25-delta call, -0.25 for a put), for a flat volatility. Delta falls monotonically with
+    // the strike, so this is a binary search.
+    size_t strikeForDelta(size_t expiry, OptionRight right, double delta, double underlyingPrice,
+                          double volatility, time_t now, double rate = 0.0) const;
+    // Strike indices for several target deltas at once, e.g. {0.10, 0.25, 0.50, 0.75, 0.90}.
+    std::vector<size_t> deltaBuckets(size_t expiry, OptionRight right, const std::vector<double>& deltas,
+                                     double underlyingPrice, double volatility, time_t now,
+                                     double rate = 0.0) const;
+
+    size_t slot(size_t expiry, size_t strike, OptionRight right) const {
+        return m_expiries[expiry].firstSlot + 2 * strike + (right == OptionRight::Put ? 1 : 0);
+    }
+    OptionKey key(size_t slot) const;
+    // OCC-style symbol ("AAPL250321C00170000", rooted at the expiry's trading class) as
+    // accepted by TwsApi::createOptionContract.
+    std::string occSymbol(size_t expiry, size_t strike, OptionRight right) const;
+    // Expiry time used for time to expiry: 21:00 UTC on the expiry date (the US close in winter).
+    static time_t expiryTime(int32_t date);
+
+    // Plain text, one line per expiry. load() returns an empty chain if the file is missing
+    // or malformed.
+    bool save(const std::string& path) const;
+    static OptionChain load(const std::string& path);
+
+private:
+    void assignSlots();
+
+    std::string m_symbol;
+    int m_underlyingConId = 0;
+    int32_t m_fetchedDate = 0;
+    std::vector<Expiry> m_expiries;
+    size_t m_slotCount = 0;
+};
+
+// UTC date of `t` as YYYYMMDD.
+int32_t utcDateYmd(time_t t);
+
+#endif // OPTION_CHAIN_H
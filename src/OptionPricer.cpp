@@ -0,0 +1,434 @@
+#include "OptionPricer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define PRICER_HAVE_AVX2 1
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr double kInvSqrt2Pi = 0.39894228040143267794;
+constexpr double kSecondsPerYear = 365.0 * 86400.0;
+constexpr double kDaysPerYear = 365.0;
+
+// Implied volatility search.
+constexpr double kMaxVol = 10.0;
+constexpr double kPriceTolerance = 1e-12;  // relative to 1 + price
+constexpr double kVolTolerance = 1e-11;
+constexpr int kMaxIterations = 100;
+
+// Standard normal CDF after Hart (1968) as given by West (2005): a rational approximation
+// times exp(-x^2/2) below |x| = 7.07, a continued fraction above it. About 1e-14 absolute
+// accuracy, and made of plain arithmetic plus one exp, so it vectorises.
+constexpr double kHartP[7] = {3.52624965998911e-02, 0.700383064443688, 6.37396220353165, 33.912866078383,
+                              112.079291497871, 221.213596169931, 220.206867912376};
+constexpr double kHartQ[8] = {8.83883476483184e-02, 1.75566716318264, 16.064177579207, 86.7807322029461,
+                              296.564248779674, 637.333633378831, 793.826512519948, 440.413735824752};
+constexpr double kHartSplit = 7.07106781186547;
+constexpr double kHartCutoff = 37.0;
+constexpr double kSqrt2Pi = 2.506628274631;
+
+double normCdf(double x) {
+    const double a = std::fabs(x);
+    double c = 0.0;
+    if (a <= kHartCutoff) {
+        const double e = std::exp(-0.5 * a * a);
+        if (a < kHartSplit) {
+            double num = kHartP[0], den = kHartQ[0];
+            for (int i = 1; i < 7; ++i)
+                num = num * a + kHartP[i];
+            for (int i = 1; i < 8; ++i)
+                den = den * a + kHartQ[i];
+            c = e * num / den;
+        } else {
+            double b = a + 0.65;
+            b = a + 4.0 / b;
+            b = a + 3.0 / b;
+            b = a + 2.0 / b;
+            b = a + 1.0 / b;
+            c = e / b / kSqrt2Pi;
+        }
+    }
+    return x > 0.0 ? 1.0 - c : c;
+}
+
+// Values shared by every option of one expiry.
+struct ExpiryTerms {
+    double spot, sqrtT, years, rate, dividendYield, carry, spotDf, strikeDf;
+
+    explicit ExpiryTerms(const PricingParams& p)
+        : spot(p.spot), sqrtT(std::sqrt(p.years)), years(p.years), rate(p.rate), dividendYield(p.dividendYield),
+          carry((p.rate - p.dividendYield) * p.years), spotDf(p.spot * std::exp(-p.dividendYield * p.years)),
+          strikeDf(std::exp(-p.rate * p.years)) {}
+};
+
+struct Kernels {
+    void (*price)(const ExpiryTerms& t, const double* strike, const double* vol, const uint8_t* put, size_t n,
+                  double* price, double* delta, double* gamma, double* vega, double* theta);
+    void (*impliedVol)(const ExpiryTerms& t, const double* strike, const double* price, const uint8_t* put,
+                       size_t n, double* vol);
+};
+
+// --- Scalar kernels ---
+
+void priceScalar(const ExpiryTerms& t, const double* strike, const double* vol, const uint8_t* put, size_t n,
+                 double* price, double* delta, double* gamma, double* vega, double* theta) {
+    for (size_t i = 0; i < n; ++i) {
+        const double s = put[i] ? -1.0 : 1.0;
+        const double k = strike[i];
+        const double sd = vol[i] * t.sqrtT;
+        const double d1 = (std::log(t.spot / k) + t.carry + 0.5 * sd * sd) / sd;
+        const double d2 = d1 - sd;
+        const double n1 = normCdf(s * d1);
+        const double n2 = normCdf(s * d2);
+        const double kDf = k * t.strikeDf;
+        price[i] = s * (t.spotDf * n1 - kDf * n2);
+        if (!delta && !gamma && !vega && !theta)
+            continue;
+        const double pdf = kInvSqrt2Pi * std::exp(-0.5 * d1 * d1);
+        if (delta)
+            delta[i] = s * (t.spotDf / t.spot) * n1;
+        if (gamma)
+            gamma[i] = t.spotDf * pdf / (t.spot * t.spot * sd);
+        if (vega)
+            vega[i] = t.spotDf * pdf * t.sqrtT / 100.0;
+        if (theta)
+            theta[i] = (-t.spotDf * pdf * vol[i] / (2.0 * t.sqrtT) - s * t.rate * kDf * n2
+                        + s * t.dividendYield * t.spotDf * n1) / kDaysPerYear;
+    }
+}
+
+void impliedVolScalar(const ExpiryTerms& t, const double* strike, const double* price, const uint8_t* put,
+                      size_t n, double* vol) {
+    for (size_t i = 0; i < n; ++i) {
+        const double s = put[i] ? -1.0 : 1.0;
+        const double k = strike[i];
+        const double target = price[i];
+        const double kDf = k * t.strikeDf;
+        const double lower = std::max(s * (t.spotDf - kDf), 0.0);
+        const double upper = put[i] ? kDf : t.spotDf;
+        if (!(target > lower && target < upper)) {
+            vol[i] = kNaN;
+            continue;
+        }
+        const double logMoneyness = std::log(t.spot / k) + t.carry;
+        // Start at the inflection point of price(vol) (Manaster-Koehler), clamped to a sane range.
+        double sigma = std::clamp(std::sqrt(2.0 * std::fabs(logMoneyness) / t.years), 0.05, 3.0);
+        double lo = 0.0, hi = kMaxVol;
+        for (int it = 0; it < kMaxIterations; ++it) {
+            const double sd = sigma * t.sqrtT;
+            const double d1 = (logMoneyness + 0.5 * sd * sd) / sd;
+            const double value = s * (t.spotDf * normCdf(s * d1) - kDf * normCdf(s * (d1 - sd)));
+            const double vegaRaw = t.spotDf * kInvSqrt2Pi * std::exp(-0.5 * d1 * d1) * t.sqrtT;
+            const double diff = value - target;
+            if (std::fabs(diff) <= kPriceTolerance * (1.0 + target))
+                break;
+            if (diff > 0.0)
+                hi = sigma;
+            else
+                lo = sigma;
+            double next = sigma - diff / vegaRaw;
+            if (!(next > lo && next < hi))
+                next = 0.5 * (lo + hi);
+            const bool small = std::fabs(next - sigma) <= kVolTolerance;
+            sigma = next;
+            if (small)
+                break;
+        }
+        vol[i] = sigma;
+    }
+}
+
+constexpr Kernels kScalarKernels{priceScalar, impliedVolScalar};
+
+// --- AVX2 kernels: four options per step, same formulas as the scalar path ---
+
+#ifdef PRICER_HAVE_AVX2
+
+// exp(x) = 2^k * exp(r), |r| <= ln2 / 2, with a degree-12 Taylor polynomial (error < 2e-16).
+AVX2_TARGET inline __m256d expAvx2(__m256d x) {
+    x = _mm256_max_pd(_mm256_min_pd(x, _mm256_set1_pd(709.0)), _mm256_set1_pd(-708.0));
+    const __m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634)),
+                                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(6.93147180369123816490e-01), x);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(1.90821492927058770002e-10), r);
+    static constexpr double kInvFactorial[13] = {1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720,
+        1.0 / 5040, 1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600};
+    __m256d p = _mm256_set1_pd(kInvFactorial[12]);
+    for (int i = 11; i >= 0; --i)
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(kInvFactorial[i]));
+    __m256i e = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k));
+    e = _mm256_slli_epi64(_mm256_add_epi64(e, _mm256_set1_epi64x(1023)), 52);
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(e));
+}
+
+// log(x) for positive normal x: x = 2^e * m with m in [sqrt(1/2), sqrt(2)), and
+// log(m) = 2 atanh(f), f = (m - 1) / (m + 1), summed to f^21.
+AVX2_TARGET inline __m256d logAvx2(__m256d x) {
+    const __m256i bits = _mm256_castpd_si256(x);
+    const __m256i exponent = _mm256_srli_epi64(bits, 52);
+    const __m256i low = _mm256_permutevar8x32_epi32(exponent, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+    __m256d e = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(low)), _mm256_set1_pd(1023.0));
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+                                                    _mm256_set1_epi64x(0x3FF0000000000000LL)));
+    const __m256d big = _mm256_cmp_pd(m, _mm256_set1_pd(1.4142135623730951), _CMP_GT_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+    e = _mm256_add_pd(e, _mm256_and_pd(big, _mm256_set1_pd(1.0)));
+
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d f = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+    const __m256d f2 = _mm256_mul_pd(f, f);
+    __m256d c = _mm256_set1_pd(1.0 / 21);
+    for (int d = 19; d >= 3; d -= 2)
+        c = _mm256_fmadd_pd(c, f2, _mm256_set1_pd(1.0 / d));
+    c = _mm256_fmadd_pd(c, f2, one);
+    const __m256d logM = _mm256_mul_pd(_mm256_add_pd(f, f), c);
+    return _mm256_fmadd_pd(e, _mm256_set1_pd(6.93147180369123816490e-01),
+                           _mm256_fmadd_pd(e, _mm256_set1_pd(1.90821492927058770002e-10), logM));
+}
+
+AVX2_TARGET inline __m256d normCdfAvx2(__m256d x) {
+    const __m256d a = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+    const __m256d e = expAvx2(_mm256_mul_pd(_mm256_set1_pd(-0.5), _mm256_mul_pd(a, a)));
+    __m256d num = _mm256_set1_pd(kHartP[0]);
+    for (int i = 1; i < 7; ++i)
+        num = _mm256_fmadd_pd(num, a, _mm256_set1_pd(kHartP[i]));
+    __m256d den = _mm256_set1_pd(kHartQ[0]);
+    for (int i = 1; i < 8; ++i)
+        den = _mm256_fmadd_pd(den, a, _mm256_set1_pd(kHartQ[i]));
+    const __m256d near = _mm256_div_pd(_mm256_mul_pd(e, num), den);
+
+    __m256d b = _mm256_add_pd(a, _mm256_set1_pd(0.65));
+    for (double k : {4.0, 3.0, 2.0, 1.0})
+        b = _mm256_add_pd(a, _mm256_div_pd(_mm256_set1_pd(k), b));
+    const __m256d far = _mm256_div_pd(e, _mm256_mul_pd(b, _mm256_set1_pd(kSqrt2Pi)));
+
+    __m256d c = _mm256_blendv_pd(far, near, _mm256_cmp_pd(a, _mm256_set1_pd(kHartSplit), _CMP_LT_OQ));
+    c = _mm256_andnot_pd(_mm256_cmp_pd(a, _mm256_set1_pd(kHartCutoff), _CMP_GT_OQ), c);
+    return _mm256_blendv_pd(c, _mm256_sub_pd(_mm256_set1_pd(1.0), c),
+                            _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_GT_OQ));
+}
+
+// +1 for calls, -1 for puts.
+AVX2_TARGET inline __m256d signAvx2(const uint8_t* put) {
+    int32_t packed;
+    std::memcpy(&packed, put, sizeof(packed));
+    const __m256d isPut = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+    return _mm256_fnmadd_pd(_mm256_set1_pd(2.0), isPut, _mm256_set1_pd(1.0));
+}
+
+AVX2_TARGET void priceAvx2(const ExpiryTerms& t, const double* strike, const double* vol, const uint8_t* put,
+                           size_t n, double* price, double* delta, double* gamma, double* vega, double* theta) {
+    const __m256d spot = _mm256_set1_pd(t.spot);
+    const __m256d sqrtT = _mm256_set1_pd(t.sqrtT);
+    const __m256d carry = _mm256_set1_pd(t.carry);
+    const __m256d spotDf = _mm256_set1_pd(t.spotDf);
+    const __m256d strikeDf = _mm256_set1_pd(t.strikeDf);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const bool greeks = delta || gamma || vega || theta;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d s = signAvx2(put + i);
+        const __m256d k = _mm256_loadu_pd(strike + i);
+        const __m256d v = _mm256_loadu_pd(vol + i);
+        const __m256d sd = _mm256_mul_pd(v, sqrtT);
+        const __m256d d1 = _mm256_div_pd(
+            _mm256_fmadd_pd(_mm256_mul_pd(half, sd), sd, _mm256_add_pd(logAvx2(_mm256_div_pd(spot, k)), carry)), sd);
+        const __m256d d2 = _mm256_sub_pd(d1, sd);
+        const __m256d n1 = normCdfAvx2(_mm256_mul_pd(s, d1));
+        const __m256d n2 = normCdfAvx2(_mm256_mul_pd(s, d2));
+        const __m256d kDf = _mm256_mul_pd(k, strikeDf);
+        _mm256_storeu_pd(price + i, _mm256_mul_pd(s, _mm256_fmsub_pd(spotDf, n1, _mm256_mul_pd(kDf, n2))));
+        if (!greeks)
+            continue;
+        const __m256d pdf = _mm256_mul_pd(_mm256_set1_pd(kInvSqrt2Pi),
+                                          expAvx2(_mm256_mul_pd(_mm256_set1_pd(-0.5), _mm256_mul_pd(d1, d1))));
+        const __m256d spotPdf = _mm256_mul_pd(spotDf, pdf);
+        if (delta)
+            _mm256_storeu_pd(delta + i, _mm256_mul_pd(_mm256_mul_pd(s, _mm256_set1_pd(t.spotDf / t.spot)), n1));
+        if (gamma)
+            _mm256_storeu_pd(gamma + i, _mm256_div_pd(spotPdf, _mm256_mul_pd(_mm256_set1_pd(t.spot * t.spot), sd)));
+        if (vega)
+            _mm256_storeu_pd(vega + i, _mm256_mul_pd(spotPdf, _mm256_set1_pd(t.sqrtT / 100.0)));
+        if (theta) {
+            // (-spotDf pdf v / (2 sqrtT) + s (q spotDf n1 - r kDf n2)) / 365
+            const __m256d decay = _mm256_div_pd(_mm256_mul_pd(spotPdf, v), _mm256_set1_pd(2.0 * t.sqrtT));
+            const __m256d flows = _mm256_fmsub_pd(_mm256_set1_pd(t.dividendYield), _mm256_mul_pd(spotDf, n1),
+                                                  _mm256_mul_pd(_mm256_set1_pd(t.rate), _mm256_mul_pd(kDf, n2)));
+            _mm256_storeu_pd(theta + i, _mm256_mul_pd(_mm256_fmsub_pd(s, flows, decay), _mm256_set1_pd(1.0 / kDaysPerYear)));
+        }
+    }
+    priceScalar(t, strike + i, vol + i, put + i, n - i, price + i, delta ? delta + i : nullptr,
+                gamma ? gamma + i : nullptr, vega ? vega + i : nullptr, theta ? theta + i : nullptr);
+}
+
+// Lanes that have converged keep their volatility while the others iterate.
+AVX2_TARGET void impliedVolAvx2(const ExpiryTerms& t, const double* strike, const double* price, const uint8_t* put,
+                                size_t n, double* vol) {
+    const __m256d spot = _mm256_set1_pd(t.spot);
+    const __m256d sqrtT = _mm256_set1_pd(t.sqrtT);
+    const __m256d spotDf = _mm256_set1_pd(t.spotDf);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d absMask = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d s = signAvx2(put + i);
+        const __m256d k = _mm256_loadu_pd(strike + i);
+        const __m256d target = _mm256_loadu_pd(price + i);
+        const __m256d kDf = _mm256_mul_pd(k, _mm256_set1_pd(t.strikeDf));
+        const __m256d lower = _mm256_max_pd(_mm256_mul_pd(s, _mm256_sub_pd(spotDf, kDf)), _mm256_setzero_pd());
+        const __m256d upper = _mm256_blendv_pd(spotDf, kDf, _mm256_cmp_pd(s, _mm256_setzero_pd(), _CMP_LT_OQ));
+        const __m256d valid = _mm256_and_pd(_mm256_cmp_pd(target, lower, _CMP_GT_OQ),
+                                            _mm256_cmp_pd(target, upper, _CMP_LT_OQ));
+        const __m256d logMoneyness = _mm256_add_pd(logAvx2(_mm256_div_pd(spot, k)), _mm256_set1_pd(t.carry));
+        __m256d sigma = _mm256_sqrt_pd(_mm256_div_pd(_mm256_mul_pd(_mm256_set1_pd(2.0), _mm256_andnot_pd(absMask, logMoneyness)),
+                                                     _mm256_set1_pd(t.years)));
+        sigma = _mm256_max_pd(_mm256_min_pd(sigma, _mm256_set1_pd(3.0)), _mm256_set1_pd(0.05));
+        __m256d lo = _mm256_setzero_pd();
+        __m256d hi = _mm256_set1_pd(kMaxVol);
+        __m256d done = _mm256_xor_pd(valid, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)));
+        const __m256d tolerance = _mm256_mul_pd(_mm256_set1_pd(kPriceTolerance), _mm256_add_pd(one, target));
+
+        for (int it = 0; it < kMaxIterations && _mm256_movemask_pd(done) != 0xF; ++it) {
+            const __m256d sd = _mm256_mul_pd(sigma, sqrtT);
+            const __m256d d1 = _mm256_div_pd(_mm256_fmadd_pd(_mm256_mul_pd(half, sd), sd, logMoneyness), sd);
+            const __m256d n1 = normCdfAvx2(_mm256_mul_pd(s, d1));
+            const __m256d n2 = normCdfAvx2(_mm256_mul_pd(s, _mm256_sub_pd(d1, sd)));
+            const __m256d value = _mm256_mul_pd(s, _mm256_fmsub_pd(spotDf, n1, _mm256_mul_pd(kDf, n2)));
+            const __m256d vegaRaw = _mm256_mul_pd(_mm256_mul_pd(spotDf, sqrtT),
+                _mm256_mul_pd(_mm256_set1_pd(kInvSqrt2Pi), expAvx2(_mm256_mul_pd(_mm256_set1_pd(-0.5), _mm256_mul_pd(d1, d1)))));
+            const __m256d diff = _mm256_sub_pd(value, target);
+            const __m256d converged = _mm256_cmp_pd(_mm256_andnot_pd(absMask, diff), tolerance, _CMP_LE_OQ);
+            const __m256d above = _mm256_cmp_pd(diff, _mm256_setzero_pd(), _CMP_GT_OQ);
+            hi = _mm256_blendv_pd(hi, sigma, above);
+            lo = _mm256_blendv_pd(sigma, lo, above);
+            __m256d next = _mm256_sub_pd(sigma, _mm256_div_pd(diff, vegaRaw));
+            const __m256d inside = _mm256_and_pd(_mm256_cmp_pd(next, lo, _CMP_GT_OQ), _mm256_cmp_pd(next, hi, _CMP_LT_OQ));
+            next = _mm256_blendv_pd(_mm256_mul_pd(half, _mm256_add_pd(lo, hi)), next, inside);
+            const __m256d small = _mm256_cmp_pd(_mm256_andnot_pd(absMask, _mm256_sub_pd(next, sigma)),
+                                                _mm256_set1_pd(kVolTolerance), _CMP_LE_OQ);
+            const __m256d stop = _mm256_or_pd(done, converged);
+            sigma = _mm256_blendv_pd(next, sigma, stop);
+            done = _mm256_or_pd(stop, small);
+        }
+        _mm256_storeu_pd(vol + i, _mm256_blendv_pd(_mm256_set1_pd(kNaN), sigma, valid));
+    }
+    impliedVolScalar(t, strike + i, price + i, put + i, n - i, vol + i);
+}
+
+constexpr Kernels kAvx2Kernels{priceAvx2, impliedVolAvx2};
+
+#endif // PRICER_HAVE_AVX2
+
+std::atomic<SimdLevel> g_level{detectSimdLevel()};
+
+const Kernels& kernels() {
+#ifdef PRICER_HAVE_AVX2
+    if (g_level.load(std::memory_order_relaxed) == SimdLevel::Avx2)
+        return kAvx2Kernels;
+#endif
+    return kScalarKernels;
+}
+
+} // namespace
+
+SimdLevel pricingSimdLevel() {
+    return g_level.load(std::memory_order_relaxed);
+}
+
+void setPricingSimdLevel(SimdLevel level) {
+    if (level == SimdLevel::Avx2 && detectSimdLevel() != SimdLevel::Avx2)
+        level = SimdLevel::Scalar;
+    g_level.store(level, std::memory_order_relaxed);
+}
+
+void priceOptions(const PricingParams& p, const double* strike, const double* vol, const uint8_t* put, size_t n,
+                  double* price, double* delta, double* gamma, double* vega, double* theta) {
+    kernels().price(ExpiryTerms(p), strike, vol, put, n, price, delta, gamma, vega, theta);
+}
+
+void impliedVols(const PricingParams& p, const double* strike, const double* price, const uint8_t* put, size_t n,
+                 double* vol) {
+    kernels().impliedVol(ExpiryTerms(p), strike, price, put, n, vol);
+}
+
+ChainGreeks priceChain(const OptionChain& chain, const std::vector<double>& mids, double spot, double rate,
+                       double dividendYield, time_t now, size_t firstExpiry, size_t lastExpiry, unsigned threads) {
+    const auto started = std::chrono::steady_clock::now();
+    ChainGreeks out;
+    const size_t slots = chain.slotCount();
+    for (auto* column : {&out.iv, &out.price, &out.delta, &out.gamma, &out.vega, &out.theta})
+        column->assign(slots, kNaN);
+    if (mids.size() < slots || !(spot > 0.0)) {
+        std::cerr << "error at priceChain: " << chain.symbol() << ": need one mid per slot and a spot price" << std::endl;
+        return out;
+    }
+    lastExpiry = std::min(lastExpiry, chain.expiries().size());
+    if (firstExpiry >= lastExpiry)
+        return out;
+
+    std::atomic<size_t> next{firstExpiry};
+    std::atomic<size_t> priced{0}, failed{0};
+    auto worker = [&]() {
+        std::vector<double> strikes;
+        std::vector<uint8_t> puts;
+        for (size_t e = next++; e < lastExpiry; e = next++) {
+            const OptionChain::Expiry& expiry = chain.expiry(e);
+            const double years = static_cast<double>(OptionChain::expiryTime(expiry.date) - now) / kSecondsPerYear;
+            if (years <= 0.0)
+                continue;
+            // Slots of an expiry alternate call, put per strike.
+            const size_t m = 2 * expiry.strikes.size();
+            strikes.resize(m);
+            puts.resize(m);
+            for (size_t k = 0; k < expiry.strikes.size(); ++k) {
+                strikes[2 * k] = strikes[2 * k + 1] = expiry.strikes[k];
+                puts[2 * k] = 0;
+                puts[2 * k + 1] = 1;
+            }
+            const size_t first = expiry.firstSlot;
+            const PricingParams p{spot, years, rate, dividendYield};
+            impliedVols(p, strikes.data(), mids.data() + first, puts.data(), m, out.iv.data() + first);
+            priceOptions(p, strikes.data(), out.iv.data() + first, puts.data(), m, out.price.data() + first,
+                         out.delta.data() + first, out.gamma.data() + first, out.vega.data() + first,
+                         out.theta.data() + first);
+            size_t ok = 0, bad = 0;
+            for (size_t j = first; j < first + m; ++j) {
+                if (std::isfinite(out.iv[j]))
+                    ++ok;
+                else if (std::isfinite(mids[j]))
+                    ++bad;
+            }
+            priced += ok;
+            failed += bad;
+        }
+    };
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, lastExpiry - firstExpiry));
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool)
+        t.join();
+
+    out.priced = priced;
+    out.failed = failed;
+    out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (out.seconds > 0.0)
+        out.optionsPerSecond = static_cast<double>(out.priced + out.failed) / out.seconds;
+    return out;
+}
@@ -0,0 +1,58 @@
+#ifndef OPTION_PRICER_H
+#define OPTION_PRICER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <vector>
+
+#include "Indicators.h"  // SimdLevel
+#include "OptionChain.h"
+
+// Black-Scholes-Merton prices, greeks and implied volatilities computed in-process, so every
+// strike of a chain gets an IV even where TWS sends no (or a stale) option computation.
+// The batch functions work on the options of one expiry (shared spot, time and rates) and
+// process four strikes per instruction with AVX2/FMA when the CPU has it, with a scalar
+// fallback chosen the same way as for the indicators. priceChain() additionally spreads the
+// expiries of a chain over several threads.
+
+SimdLevel pricingSimdLevel();
+void setPricingSimdLevel(SimdLevel level);  // clamped to detectSimdLevel()
+
+struct PricingParams {
+    double spot = 0.0;
+    double years = 0.0;          // time to expiry
+    double rate = 0.0;           // continuously compounded
+    double dividendYield = 0.0;  // continuous
+};
+
+// Prices and greeks of n options; put[i] != 0 marks a put. Vega is per volatility point and
+// theta per calendar day, as TWS reports them. Any output pointer except price may be null.
+void priceOptions(const PricingParams& p, const double* strike, const double* vol, const uint8_t* put, size_t n,
+                  double* price, double* delta = nullptr, double* gamma = nullptr, double* vega = nullptr,
+                  double* theta = nullptr);
+
+// Implied volatility of n option prices. Each option is solved by Newton steps kept inside a
+// bracket that shrinks every iteration, falling back to bisection when a step would leave it
+// (flat vega far from the money), to within 1e-10 of the price. NaN where the price is
+// missing or outside the no-arbitrage bounds.
+void impliedVols(const PricingParams& p, const double* strike, const double* price, const uint8_t* put, size_t n,
+                 double* vol);
+
+// Per chain slot (see OptionChain::slot), NaN where nothing was priced.
+struct ChainGreeks {
+    std::vector<double> iv, price, delta, gamma, vega, theta;
+    size_t priced = 0;
+    size_t failed = 0;           // had a price but no implied volatility fits it
+    double seconds = 0.0;
+    double optionsPerSecond = 0.0;
+};
+
+// Implied volatility from mids[slot] (NaN = no quote), then greeks at that volatility, for
+// expiries [firstExpiry, lastExpiry). threads = 0 uses one per hardware thread.
+ChainGreeks priceChain(const OptionChain& chain, const std::vector<double>& mids, double spot, double rate,
+                       double dividendYield, time_t now, size_t firstExpiry = 0,
+                       size_t lastExpiry = std::numeric_limits<size_t>::max(), unsigned threads = 0);
+
+#endif // OPTION_PRICER_H
@@ -0,0 +1,145 @@
+#include "PnlTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double field(const PnlValues& pnl, PnlField f) {
+    switch (f) {
+        case PnlField::Unrealized: return pnl.unrealizedPnl;
+        case PnlField::Realized:   return pnl.realizedPnl;
+        default:                   return pnl.dailyPnl;
+    }
+}
+
+const auto bySymbol = [](const PositionPnl& p, const std::string& s) { return p.symbol < s; };
+
+} // namespace
+
+const PositionPnl* PnlSnapshot::find(const std::string& symbol) const {
+    if (!positions)
+        return nullptr;
+    auto it = std::lower_bound(positions->begin(), positions->end(), symbol, bySymbol);
+    return it != positions->end() && it->symbol == symbol ? &*it : nullptr;
+}
+
+PnlTable::PnlTable() {
+    clear();
+}
+
+void PnlTable::clear() {
+    auto next = std::make_shared<PnlSnapshot>();
+    next->positions = std::make_shared<const std::vector<PositionPnl>>();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_generation;
+    for (auto& watch : m_watches)
+        watch.armed = true;
+    m_snapshot.store(std::move(next), std::memory_order_release);
+}
+
+uint64_t PnlTable::generation() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_generation;
+}
+
+void PnlTable::setAccount(uint64_t generation, const PnlValues& pnl) {
+    std::vector<Fired> fired;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (generation != m_generation)
+            return;
+        auto next = std::make_shared<PnlSnapshot>(*m_snapshot.load(std::memory_order_relaxed));
+        next->account = pnl;
+        m_snapshot.store(std::move(next), std::memory_order_release);
+        evaluate("", pnl, fired);
+    }
+    notify(fired);
+}
+
+void PnlTable::setPosition(uint64_t generation, const std::string& symbol, long conId, double position,
+                           double value, const PnlValues& pnl) {
+    std::vector<Fired> fired;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (generation != m_generation)
+            return;
+        const auto current = m_snapshot.load(std::memory_order_relaxed);
+        auto rows = std::make_shared<std::vector<PositionPnl>>(*current->positions);
+        auto it = std::lower_bound(rows->begin(), rows->end(), symbol, bySymbol);
+        if (it == rows->end() || it->symbol != symbol) {
+            it = rows->insert(it, PositionPnl());
+            it->symbol = symbol;
+        }
+        it->conId = conId;
+        it->position = position;
+        it->value = value;
+        it->pnl = pnl;
+
+        auto next = std::make_shared<PnlSnapshot>(*current);
+        next->positions = std::move(rows);
+        m_snapshot.store(std::move(next), std::memory_order_release);
+        evaluate(symbol, pnl, fired);
+    }
+    notify(fired);
+}
+
+void PnlTable::removePosition(const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto current = m_snapshot.load(std::memory_order_relaxed);
+    auto it = std::lower_bound(current->positions->begin(), current->positions->end(), symbol, bySymbol);
+    if (it == current->positions->end() || it->symbol != symbol)
+        return;
+    auto rows = std::make_shared<std::vector<PositionPnl>>(*current->positions);
+    rows->erase(rows->begin() + (it - current->positions->begin()));
+    auto next = std::make_shared<PnlSnapshot>(*current);
+    next->positions = std::move(rows);
+    m_snapshot.store(std::move(next), std::memory_order_release);
+    for (auto& watch : m_watches) {
+        if (watch.alert.symbol == symbol)
+            watch.armed = true;
+    }
+}
+
+int PnlTable::addAlert(const PnlAlert& alert, PnlAlertHandler handler) {
+    Watch watch;
+    watch.alert = alert;
+    watch.handler = std::move(handler);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    watch.id = m_nextAlertId++;
+    m_watches.push_back(std::move(watch));
+    return m_watches.back().id;
+}
+
+void PnlTable::removeAlert(int alertId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_watches.erase(std::remove_if(m_watches.begin(), m_watches.end(),
+                                   [alertId](const Watch& w) { return w.id == alertId; }),
+                    m_watches.end());
+}
+
+// Called with m_mutex held.
+void PnlTable::evaluate(const std::string& symbol, const PnlValues& pnl, std::vector<Fired>& fired) {
+    for (auto& watch : m_watches) {
+        const PnlAlert& alert = watch.alert;
+        if (alert.symbol != symbol)
+            continue;
+        const double v = field(pnl, alert.field);
+        if (std::isnan(v))
+            continue;
+        const bool reached = alert.direction == PnlAlert::Below ? v <= alert.threshold : v >= alert.threshold;
+        if (!reached) {
+            watch.armed = true;
+        } else if (watch.armed) {
+            watch.armed = false;
+            fired.push_back(Fired{alert, watch.handler, v});
+        }
+    }
+}
+
+void PnlTable::notify(const std::vector<Fired>& fired) {
+    for (const Fired& f : fired) {
+        if (f.handler)
+            f.handler(f.alert, f.value);
+    }
+}
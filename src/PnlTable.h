@@ -0,0 +1,97 @@
+#ifndef PNL_TABLE_H
+#define PNL_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// P&L of the account (reqPnL) or of one position (reqPnLSingle). Values TWS has not
+// reported yet (it sends DBL_MAX) are NaN.
+struct PnlValues {
+    double dailyPnl = 0.0;
+    double unrealizedPnl = 0.0;
+    double realizedPnl = 0.0;
+};
+
+struct PositionPnl {
+    std::string symbol;   // stock ticker or OCC symbol, as in Position
+    long conId = 0;
+    double position = 0.0;
+    double value = 0.0;   // market value
+    PnlValues pnl;
+};
+
+// Immutable state of the table. Once a reader holds it through a shared_ptr it reads it without
+// any synchronization while PnlTable publishes newer versions.
+struct PnlSnapshot {
+    PnlValues account;
+    std::shared_ptr<const std::vector<PositionPnl>> positions;  // sorted by symbol
+
+    const PositionPnl* find(const std::string& symbol) const;
+};
+
+enum class PnlField : uint8_t { Daily, Unrealized, Realized };
+
+// Fires once when `field` of `symbol` (the account if empty) reaches `threshold` from the
+// armed side: at or below it for Below, at or above it for Above. It re-arms once the value
+// is back on the other side, so a P&L hovering around the threshold does not fire each tick.
+struct PnlAlert {
+    std::string symbol;
+    PnlField field = PnlField::Daily;
+    enum Direction : uint8_t { Below, Above } direction = Below;
+    double threshold = 0.0;
+};
+
+// Called on the account dispatch thread, outside the table's lock, with the alert and the
+// value that triggered it. It must not block.
+using PnlAlertHandler = std::function<void(const PnlAlert& alert, double value)>;
+
+// Account and per-position P&L as the pnl / pnlSingle subscriptions stream it. Every update
+// publishes a new snapshot (the position array is copied only when a position changes) and
+// then evaluates the alerts on the updated row. Writers serialize on a mutex; snapshot() takes
+// no mutex, only the short internal spinlock of std::atomic<std::shared_ptr> (see AccountState).
+class PnlTable {
+public:
+    PnlTable();
+
+    std::shared_ptr<const PnlSnapshot> snapshot() const { return m_snapshot.load(std::memory_order_acquire); }
+
+    // Bumped by clear(). Updates carry the generation their caller read together with its
+    // subscription state, and are dropped if the table was cleared since.
+    uint64_t generation() const;
+    void setAccount(uint64_t generation, const PnlValues& pnl);
+    void setPosition(uint64_t generation, const std::string& symbol, long conId, double position, double value,
+                     const PnlValues& pnl);
+    void removePosition(const std::string& symbol);
+    void clear();
+
+    int addAlert(const PnlAlert& alert, PnlAlertHandler handler);  // returns the alert id
+    void removeAlert(int alertId);
+
+private:
+    struct Watch {
+        int id = 0;
+        PnlAlert alert;
+        PnlAlertHandler handler;
+        bool armed = true;
+    };
+    struct Fired {
+        PnlAlert alert;
+        PnlAlertHandler handler;
+        double value = 0.0;
+    };
+    void evaluate(const std::string& symbol, const PnlValues& pnl, std::vector<Fired>& fired);
+    static void notify(const std::vector<Fired>& fired);
+
+    mutable std::mutex m_mutex;  // guards the members below
+    uint64_t m_generation = 0;
+    std::vector<Watch> m_watches;
+    int m_nextAlertId = 1;
+    std::atomic<std::shared_ptr<const PnlSnapshot>> m_snapshot;
+};
+
+#endif // PNL_TABLE_H
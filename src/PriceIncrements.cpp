@@ -0,0 +1,86 @@
+#include "PriceIncrements.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kOnGrid = 1e-9;  // in ticks
+constexpr int kMaxDecimals = 10;
+
+} // namespace
+
+double PriceLadder::roundOnRung(double price, const Rung& r, PriceRounding mode) {
+    const double ticks = price * r.scale / r.units;
+    double n;
+    switch (mode) {
+        case PriceRounding::Down: n = std::floor(ticks + kOnGrid); break;
+        case PriceRounding::Up:   n = std::ceil(ticks - kOnGrid); break;
+        default:                  n = std::nearbyint(ticks); break;
+    }
+    // n x units is an exact integer, so the division yields the double closest to the decimal.
+    return n * r.units / r.scale;
+}
+
+PriceLadder::Rung PriceLadder::makeRung(double lowEdge, double increment) {
+    Rung r;
+    r.lowEdge = lowEdge;
+    r.increment = increment;
+    for (int d = 0; d < kMaxDecimals; ++d) {
+        const double scaled = increment * r.scale;
+        if (std::fabs(scaled - std::round(scaled)) < 1e-9 * r.scale)
+            break;
+        r.scale *= 10.0;
+    }
+    r.units = std::round(increment * r.scale);
+    return r;
+}
+
+PriceLadder::PriceLadder(const std::vector<std::pair<double, double>>& rungs) {
+    for (const auto& [lowEdge, increment] : rungs) {
+        if (increment > 0.0)
+            m_rungs.push_back(makeRung(lowEdge, increment));
+    }
+    std::sort(m_rungs.begin(), m_rungs.end(), [](const Rung& a, const Rung& b) { return a.lowEdge < b.lowEdge; });
+}
+
+double PriceLadder::round(double price, PriceRounding mode) const {
+    if (m_rungs.empty())
+        return price;
+    return roundOnRung(price, m_rungs[rung(price)], mode);
+}
+
+double roundToIncrement(double price, double increment, PriceRounding mode) {
+    if (!(increment > 0.0))
+        return price;
+    return PriceLadder::roundOnRung(price, PriceLadder::makeRung(0.0, increment), mode);
+}
+
+std::shared_ptr<const PriceLadder> MarketRuleCache::find(int marketRuleId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_ladders.find(marketRuleId);
+    return it == m_ladders.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const PriceLadder> MarketRuleCache::wait(int marketRuleId, std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stored.wait_for(lock, timeout, [&]() { return m_ladders.count(marketRuleId) > 0; });
+    auto it = m_ladders.find(marketRuleId);
+    return it == m_ladders.end() ? nullptr : it->second;
+}
+
+void MarketRuleCache::store(int marketRuleId, PriceLadder ladder) {
+    auto entry = std::make_shared<const PriceLadder>(std::move(ladder));
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ladders[marketRuleId] = std::move(entry);
+    }
+    m_stored.notify_all();
+}
+
+bool MarketRuleCache::markRequested(int marketRuleId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_ladders.count(marketRuleId))
+        return false;
+    return m_requested.insert(marketRuleId).second;
+}
@@ -0,0 +1,75 @@
+#ifndef PRICE_INCREMENTS_H
+#define PRICE_INCREMENTS_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+enum class PriceRounding : uint8_t {
+    Nearest,
+    Down,  // e.g. a buy limit: never pay more than asked
+    Up,    // e.g. a sell limit: never receive less than asked
+};
+
+// Rounds `price` to a multiple of `increment`. The arithmetic is done on the increment's
+// decimal digits, so 0.05 x 2469 comes out as 123.45 and not 123.45000000000002, and prices
+// already on the grid (within 1e-9 of a tick) are returned as they are.
+double roundToIncrement(double price, double increment, PriceRounding mode);
+
+// Price increments of one market rule (reqMarketRule): the increment of a price is that of
+// the highest rung whose low edge it reaches, e.g. 0.0001 below 1.00 and 0.01 from there on.
+class PriceLadder {
+public:
+    PriceLadder() = default;
+    explicit PriceLadder(const std::vector<std::pair<double, double>>& rungs);  // (lowEdge, increment)
+
+    bool empty() const { return m_rungs.empty(); }
+    double increment(double price) const { return m_rungs[rung(price)].increment; }
+    double round(double price, PriceRounding mode) const;
+
+private:
+    struct Rung {
+        double lowEdge = 0.0;
+        double increment = 0.0;
+        double scale = 1.0;   // 10^decimals of the increment
+        double units = 0.0;   // increment x scale, an integer
+    };
+    // Ladders have one to a few rungs: count the edges at or below the price, without branches.
+    size_t rung(double price) const {
+        size_t i = 0;
+        for (size_t j = 1; j < m_rungs.size(); ++j)
+            i += price >= m_rungs[j].lowEdge;
+        return i;
+    }
+    static Rung makeRung(double lowEdge, double increment);
+    static double roundOnRung(double price, const Rung& r, PriceRounding mode);
+
+    std::vector<Rung> m_rungs;  // sorted by low edge
+    friend double roundToIncrement(double, double, PriceRounding);
+};
+
+// Ladders by market rule id, as marketRule() delivers them. Thread-safe.
+class MarketRuleCache {
+public:
+    std::shared_ptr<const PriceLadder> find(int marketRuleId) const;
+    // Like find(), but waits up to `timeout` for a requested ladder to arrive.
+    std::shared_ptr<const PriceLadder> wait(int marketRuleId, std::chrono::milliseconds timeout) const;
+    void store(int marketRuleId, PriceLadder ladder);
+    // True the first time for an id that is not cached yet: the caller should request it.
+    bool markRequested(int marketRuleId);
+
+private:
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_stored;
+    std::unordered_map<int, std::shared_ptr<const PriceLadder>> m_ladders;
+    std::unordered_set<int> m_requested;
+};
+
+#endif // PRICE_INCREMENTS_H
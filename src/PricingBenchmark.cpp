@@ -0,0 +1,236 @@
+#include "PricingBenchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <thread>
+
+#include "OptionPricer.h"
+
+namespace {
+
+constexpr double kSpot = 100.0;
+constexpr double kRate = 0.04;
+constexpr double kDividendYield = 0.01;
+
+// One expiry of the synthetic chain, laid out like a chain's slots: call and put per strike.
+struct SyntheticExpiry {
+    PricingParams params;
+    std::vector<double> strike, vol, price;
+    std::vector<uint8_t> put;
+};
+
+std::vector<SyntheticExpiry> syntheticChain(size_t expiries, size_t strikes) {
+    std::vector<SyntheticExpiry> chain(expiries);
+    for (size_t e = 0; e < expiries; ++e) {
+        SyntheticExpiry& x = chain[e];
+        x.params = {kSpot, 7.0 * static_cast<double>(e + 1) / 365.0, kRate, kDividendYield};
+        for (size_t k = 0; k < strikes; ++k) {
+            // Strikes from 50% to 150% of spot, with a skewed smile.
+            const double strike = kSpot * (0.5 + static_cast<double>(k) / static_cast<double>(std::max<size_t>(strikes - 1, 1)));
+            const double m = std::log(strike / kSpot);
+            const double vol = 0.2 - 0.1 * m + 0.4 * m * m;
+            for (uint8_t put : {0, 1}) {
+                x.strike.push_back(strike);
+                x.vol.push_back(vol);
+                x.put.push_back(put);
+            }
+        }
+        x.price.resize(x.strike.size());
+    }
+    return chain;
+}
+
+// --- Naive baseline: the textbook formulas, one option and one greek at a time ---
+
+double naiveCdf(double x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }
+
+double naiveD1(const PricingParams& p, double k, double v) {
+    return (std::log(p.spot / k) + (p.rate - p.dividendYield + 0.5 * v * v) * p.years) / (v * std::sqrt(p.years));
+}
+
+double naivePrice(const PricingParams& p, double k, double v, bool put) {
+    const double d1 = naiveD1(p, k, v);
+    const double d2 = d1 - v * std::sqrt(p.years);
+    const double s = p.spot * std::exp(-p.dividendYield * p.years);
+    const double x = k * std::exp(-p.rate * p.years);
+    return put ? x * naiveCdf(-d2) - s * naiveCdf(-d1) : s * naiveCdf(d1) - x * naiveCdf(d2);
+}
+
+double naiveDelta(const PricingParams& p, double k, double v, bool put) {
+    const double df = std::exp(-p.dividendYield * p.years);
+    return put ? df * (naiveCdf(naiveD1(p, k, v)) - 1.0) : df * naiveCdf(naiveD1(p, k, v));
+}
+
+double naivePdf(double x) { return std::exp(-0.5 * x * x) / std::sqrt(2.0 * M_PI); }
+
+double naiveGamma(const PricingParams& p, double k, double v) {
+    return std::exp(-p.dividendYield * p.years) * naivePdf(naiveD1(p, k, v)) / (p.spot * v * std::sqrt(p.years));
+}
+
+double naiveVega(const PricingParams& p, double k, double v) {
+    return p.spot * std::exp(-p.dividendYield * p.years) * naivePdf(naiveD1(p, k, v)) * std::sqrt(p.years) / 100.0;
+}
+
+double naiveTheta(const PricingParams& p, double k, double v, bool put) {
+    const double d1 = naiveD1(p, k, v);
+    const double d2 = d1 - v * std::sqrt(p.years);
+    const double s = p.spot * std::exp(-p.dividendYield * p.years);
+    const double x = k * std::exp(-p.rate * p.years);
+    const double decay = -s * naivePdf(d1) * v / (2.0 * std::sqrt(p.years));
+    const double flows = put ? p.rate * x * naiveCdf(-d2) - p.dividendYield * s * naiveCdf(-d1)
+                             : -p.rate * x * naiveCdf(d2) + p.dividendYield * s * naiveCdf(d1);
+    return (decay + flows) / 365.0;
+}
+
+// Plain bisection on [0, 10] to 1e-12.
+double naiveImpliedVol(const PricingParams& p, double k, double price, bool put) {
+    double lo = 0.0, hi = 10.0;
+    while (hi - lo > 1e-12) {
+        const double mid = 0.5 * (lo + hi);
+        if (naivePrice(p, k, mid, put) > price)
+            hi = mid;
+        else
+            lo = mid;
+    }
+    return 0.5 * (lo + hi);
+}
+
+template <typename Fn>
+double bestOfThreeSeconds(Fn&& fn) {
+    double best = std::numeric_limits<double>::max();
+    for (int run = 0; run < 3; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, std::chrono::duration<double>(elapsed).count());
+    }
+    return best;
+}
+
+// Runs fn(expiry index) for every expiry, spread over the hardware threads.
+void forEachExpiryThreaded(size_t expiries, const std::function<void(size_t)>& fn) {
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t e = next++; e < expiries; e = next++)
+            fn(e);
+    };
+    const unsigned threads = static_cast<unsigned>(
+        std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), expiries));
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool)
+        t.join();
+}
+
+} // namespace
+
+std::vector<PricingTiming> benchmarkPricing(size_t expiries, size_t strikes) {
+    expiries = std::max<size_t>(expiries, 1);
+    strikes = std::max<size_t>(strikes, 1);
+    std::vector<SyntheticExpiry> chain = syntheticChain(expiries, strikes);
+    const double options = static_cast<double>(2 * expiries * strikes);
+    const size_t m = 2 * strikes;
+
+    // Per expiry outputs: price, delta, gamma, vega, theta, iv.
+    std::vector<std::vector<double>> reference(expiries, std::vector<double>(5 * m));
+    std::vector<std::vector<double>> result(expiries, std::vector<double>(6 * m));
+
+    auto naivePricing = [&](size_t e) {
+        const SyntheticExpiry& x = chain[e];
+        double* out = reference[e].data();
+        for (size_t i = 0; i < m; ++i) {
+            out[i] = naivePrice(x.params, x.strike[i], x.vol[i], x.put[i]);
+            out[m + i] = naiveDelta(x.params, x.strike[i], x.vol[i], x.put[i]);
+            out[2 * m + i] = naiveGamma(x.params, x.strike[i], x.vol[i]);
+            out[3 * m + i] = naiveVega(x.params, x.strike[i], x.vol[i]);
+            out[4 * m + i] = naiveTheta(x.params, x.strike[i], x.vol[i], x.put[i]);
+        }
+    };
+    auto batchPricing = [&](size_t e) {
+        const SyntheticExpiry& x = chain[e];
+        double* out = result[e].data();
+        priceOptions(x.params, x.strike.data(), x.vol.data(), x.put.data(), m, out, out + m, out + 2 * m,
+                     out + 3 * m, out + 4 * m);
+    };
+    auto naiveIv = [&](size_t e) {
+        const SyntheticExpiry& x = chain[e];
+        for (size_t i = 0; i < m; ++i)
+            result[e][5 * m + i] = naiveImpliedVol(x.params, x.strike[i], x.price[i], x.put[i]);
+    };
+    auto batchIv = [&](size_t e) {
+        const SyntheticExpiry& x = chain[e];
+        impliedVols(x.params, x.strike.data(), x.price.data(), x.put.data(), m, result[e].data() + 5 * m);
+    };
+    auto sequential = [&](const std::function<void(size_t)>& fn) {
+        return [&, fn]() {
+            for (size_t e = 0; e < expiries; ++e)
+                fn(e);
+        };
+    };
+    auto priceError = [&]() {
+        double worst = 0.0;
+        for (size_t e = 0; e < expiries; ++e) {
+            for (size_t j = 0; j < 5 * m; ++j)
+                worst = std::max(worst, std::fabs(result[e][j] - reference[e][j]));
+        }
+        return worst;
+    };
+    // Far from the money the price hardly moves with volatility (vega ~ 0) and the volatility
+    // cannot be recovered from a rounded price by any method, so those options are skipped.
+    auto ivError = [&]() {
+        double worst = 0.0;
+        for (size_t e = 0; e < expiries; ++e) {
+            for (size_t i = 0; i < m; ++i) {
+                if (reference[e][3 * m + i] > 1e-4)
+                    worst = std::max(worst, std::fabs(result[e][5 * m + i] - chain[e].vol[i]));
+            }
+        }
+        return worst;
+    };
+
+    const SimdLevel saved = pricingSimdLevel();
+    std::vector<PricingTiming> timings;
+
+    PricingTiming pricing;
+    pricing.name = "Precio+griegas";
+    pricing.naivePerSecond = options / bestOfThreeSeconds(sequential(naivePricing));
+    for (size_t e = 0; e < expiries; ++e)
+        std::copy(reference[e].begin(), reference[e].begin() + m, chain[e].price.begin());
+    setPricingSimdLevel(SimdLevel::Scalar);
+    pricing.scalarPerSecond = options / bestOfThreeSeconds(sequential(batchPricing));
+    pricing.maxError = priceError();
+    if (detectSimdLevel() == SimdLevel::Avx2) {
+        setPricingSimdLevel(SimdLevel::Avx2);
+        pricing.simdPerSecond = options / bestOfThreeSeconds(sequential(batchPricing));
+        pricing.maxError = std::max(pricing.maxError, priceError());
+    }
+    pricing.threadedPerSecond = options / bestOfThreeSeconds([&] { forEachExpiryThreaded(expiries, batchPricing); });
+    pricing.maxError = std::max(pricing.maxError, priceError());
+    timings.push_back(pricing);
+
+    PricingTiming iv;
+    iv.name = "Vol. implicita";
+    iv.naivePerSecond = options / bestOfThreeSeconds(sequential(naiveIv));
+    iv.maxError = ivError();
+    setPricingSimdLevel(SimdLevel::Scalar);
+    iv.scalarPerSecond = options / bestOfThreeSeconds(sequential(batchIv));
+    iv.maxError = std::max(iv.maxError, ivError());
+    if (detectSimdLevel() == SimdLevel::Avx2) {
+        setPricingSimdLevel(SimdLevel::Avx2);
+        iv.simdPerSecond = options / bestOfThreeSeconds(sequential(batchIv));
+        iv.maxError = std::max(iv.maxError, ivError());
+    }
+    iv.threadedPerSecond = options / bestOfThreeSeconds([&] { forEachExpiryThreaded(expiries, batchIv); });
+    iv.maxError = std::max(iv.maxError, ivError());
+    timings.push_back(iv);
+
+    setPricingSimdLevel(saved);
+    return timings;
+}
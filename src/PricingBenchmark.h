@@ -0,0 +1,22 @@
+#ifndef PRICING_BENCHMARK_H
+#define PRICING_BENCHMARK_H
+
+#include <cstddef>
+#include <vector>
+
+// Throughputs in options per second.
+struct PricingTiming {
+    const char* name = "";
+    double naivePerSecond = 0.0;     // one option at a time, std::erfc, each greek recomputing d1/d2 (bisection for IV)
+    double scalarPerSecond = 0.0;    // batch kernels per expiry, scalar path
+    double simdPerSecond = -1.0;     // batch kernels per expiry, AVX2 path (-1 if this CPU lacks AVX2)
+    double threadedPerSecond = 0.0;  // batch kernels, expiries spread over every hardware thread
+    double maxError = 0.0;           // prices: largest |batch - naive|; IV: largest |solved - true vol|
+};
+
+// Prices a synthetic chain of `expiries` x `strikes` calls and puts (volatility smile, weekly
+// expiries) with each implementation, then solves the implied volatilities back from those
+// prices, and reports the best of three runs.
+std::vector<PricingTiming> benchmarkPricing(size_t expiries, size_t strikes);
+
+#endif // PRICING_BENCHMARK_H
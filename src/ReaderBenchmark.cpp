@@ -0,0 +1,100 @@
+#include "ReaderBenchmark.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include "StandInServer.h"
+#include "TwsApi.h"
+
+static constexpr int kHistoricalDataUpdate = 90;  // IB message id of historicalDataUpdate
+
+static int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+LatencySummary benchmarkReaderLatency(const ReaderConfig& config, int samples) {
+    if (samples <= 0)
+        return LatencySummary{};
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<int64_t> sent;  // send times of the updates not delivered yet, oldest first
+    std::vector<double> latencies;
+    latencies.reserve(samples);
+
+    // Updates travel one TCP stream and one historical queue, so they arrive in send order
+    // whichever subscription they belong to.
+    StandInConfig serverConfig;
+    serverConfig.port = 0;
+    serverConfig.quoteRate = 0.0;
+    serverConfig.tickByTickRate = 0.0;
+    serverConfig.barUpdateInterval = std::chrono::milliseconds(1);
+    serverConfig.maxHistoricalBars = 10;
+    serverConfig.onSend = [&](int msgId) {
+        if (msgId != kHistoricalDataUpdate)
+            return;
+        const int64_t stamp = nowNanos();
+        std::lock_guard<std::mutex> lock(mutex);
+        sent.push_back(stamp);
+    };
+    TwsStandInServer server(serverConfig);
+    if (!server.start())
+        return LatencySummary{};
+
+    // The first call of each subscription reports the loaded history, not an update.
+    LiveBarHandler onUpdate = [&, loaded = false](const BarSeries&, size_t) mutable {
+        if (!loaded) {
+            loaded = true;
+            return;
+        }
+        const int64_t now = nowNanos();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (sent.empty())
+            return;
+        const int64_t stamp = sent.front();
+        sent.pop_front();
+        if (latencies.size() < static_cast<size_t>(samples)) {
+            latencies.push_back(static_cast<double>(now - stamp) / 1000.0);
+            if (latencies.size() == static_cast<size_t>(samples))
+                cond.notify_all();
+        }
+    };
+
+    TwsApi api;
+    api.setReaderConfig(config);
+    LinkMonitorConfig link;
+    link.enabled = false;  // probes would share the reader with the measured updates
+    api.setLinkMonitorConfig(link);
+    if (!api.connect("127.0.0.1", server.port(), 0)) {
+        std::cerr << "error at benchmarkReaderLatency: cannot connect to the stand-in" << std::endl;
+        return LatencySummary{};
+    }
+    const int first = api.subscribeLiveBars("BENCHA", "60 S", "5 secs", "TRADES", false, onUpdate);
+    const int second = api.subscribeLiveBars("BENCHB", "60 S", "5 secs", "TRADES", false, onUpdate);
+    if (first < 0 || second < 0) {
+        std::cerr << "error at benchmarkReaderLatency: live bar subscription failed" << std::endl;
+        api.disconnect();
+        return LatencySummary{};
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // Two updates per millisecond; allow generous slack for slow wake-ups.
+        const auto timeout = std::chrono::seconds(10) + std::chrono::milliseconds(samples);
+        if (!cond.wait_for(lock, timeout, [&]() { return latencies.size() >= static_cast<size_t>(samples); }))
+            std::cerr << "error at benchmarkReaderLatency: only " << latencies.size() << " of " << samples
+                      << " samples arrived" << std::endl;
+    }
+
+    api.cancelLiveBars(first);
+    api.cancelLiveBars(second);
+    api.disconnect();  // joins the dispatch threads, so the handler no longer runs
+    server.stop();
+    return summarizeLatencies(latencies);
+}
@@ -0,0 +1,16 @@
+#ifndef READER_BENCHMARK_H
+#define READER_BENCHMARK_H
+
+#include "LatencyStats.h"
+#include "WaitStrategy.h"
+
+// Measures socket-to-callback latency of the real receive path for one wait strategy without
+// TWS. An in-process TwsStandInServer streams keepUpToDate bar updates for two live bar
+// subscriptions of a TwsApi connected with `config`; both updates of a period leave in one
+// send(), so every period is a two-message burst. Each sample is the time from that send()
+// returning to the LiveBarHandler call, i.e. EReader, the reader loop, decoding, the
+// historical SPSC queue and its dispatch thread. Returns an empty summary if the stand-in or
+// the connection cannot be set up.
+LatencySummary benchmarkReaderLatency(const ReaderConfig& config, int samples);
+
+#endif // READER_BENCHMARK_H
@@ -0,0 +1,42 @@
+#ifndef READER_SIGNAL_H
+#define READER_SIGNAL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "EReaderSignal.h"
+
+// Counting replacement for EReaderOSSignal. EReader raises the signal once per message it
+// queues and processMsgs() handles one message per call, but EReaderOSSignal is a flag: a
+// burst that arrives before the reader thread wakes collapses into one wake, and the rest of
+// the burst waits for the next message or the timeout. Here every issueSignal() releases
+// exactly one waitForSignal(), so a Block reader calls processMsgs() once per queued message.
+class ReaderSignal : public EReaderSignal {
+public:
+    explicit ReaderSignal(unsigned long timeoutMs) : m_timeout(timeoutMs) {}
+
+    void issueSignal() override {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_pending;
+        }
+        m_cond.notify_one();
+    }
+
+    // Returns after one pending signal was taken or the timeout passed.
+    void waitForSignal() override {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_cond.wait_for(lock, m_timeout, [this]() { return m_pending > 0; }))
+            --m_pending;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    uint64_t m_pending = 0;  // signals not yet consumed; grows harmlessly when nobody waits
+    std::chrono::milliseconds m_timeout;
+};
+
+#endif // READER_SIGNAL_H
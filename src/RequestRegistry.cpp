@@ -0,0 +1,119 @@
+#include "RequestRegistry.h"
+
+#include <memory>
+#include <vector>
+
+RequestRegistry::RequestRegistry(int firstId) : m_nextId(firstId) {
+    m_sweeper = std::thread([this]() { sweepLoop(); });
+}
+
+RequestRegistry::~RequestRegistry() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    if (m_sweeper.joinable())
+        m_sweeper.join();
+}
+
+int RequestRegistry::nextId() {
+    return m_nextId.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RequestRegistry::add(int reqId, std::chrono::milliseconds timeout, Handler handler) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending[reqId] = Entry{std::chrono::steady_clock::now() + timeout, std::move(handler)};
+    }
+    m_cond.notify_all(); // the sweeper may need to wake earlier for this deadline
+}
+
+std::future<RequestResult> RequestRegistry::track(int reqId, std::chrono::milliseconds timeout) {
+    auto promise = std::make_shared<std::promise<RequestResult>>();
+    std::future<RequestResult> future = promise->get_future();
+    add(reqId, timeout, [promise](const RequestResult& result) { promise->set_value(result); });
+    return future;
+}
+
+bool RequestRegistry::complete(int reqId) {
+    return finish(reqId, RequestResult{RequestStatus::Completed, ""});
+}
+
+bool RequestRegistry::fail(int reqId, const std::string& message) {
+    return finish(reqId, RequestResult{RequestStatus::Failed, message});
+}
+
+bool RequestRegistry::cancel(int reqId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending.erase(reqId) > 0;
+}
+
+bool RequestRegistry::resetDeadline(int reqId, std::chrono::milliseconds timeout) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pending.find(reqId);
+        if (it == m_pending.end())
+            return false;
+        it->second.deadline = std::chrono::steady_clock::now() + timeout;
+    }
+    m_cond.notify_all();
+    return true;
+}
+
+bool RequestRegistry::isPending(int reqId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending.find(reqId) != m_pending.end();
+}
+
+size_t RequestRegistry::pendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending.size();
+}
+
+bool RequestRegistry::finish(int reqId, RequestResult result) {
+    Handler handler;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pending.find(reqId);
+        if (it == m_pending.end())
+            return false;
+        handler = std::move(it->second.handler);
+        m_pending.erase(it);
+    }
+    if (handler)
+        handler(result);
+    return true;
+}
+
+void RequestRegistry::sweepLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        auto now = std::chrono::steady_clock::now();
+        auto nextDeadline = std::chrono::steady_clock::time_point::max();
+        std::vector<Handler> expired;
+        for (auto it = m_pending.begin(); it != m_pending.end();) {
+            if (it->second.deadline <= now) {
+                expired.push_back(std::move(it->second.handler));
+                it = m_pending.erase(it);
+            } else {
+                nextDeadline = std::min(nextDeadline, it->second.deadline);
+                ++it;
+            }
+        }
+        if (!expired.empty()) {
+            lock.unlock();
+            RequestResult timedOut{RequestStatus::TimedOut, "request timed out"};
+            for (auto& handler : expired) {
+                if (handler)
+                    handler(timedOut);
+            }
+            lock.lock();
+            continue;
+        }
+        if (nextDeadline == std::chrono::steady_clock::time_point::max())
+            m_cond.wait(lock);
+        else
+            m_cond.wait_until(lock, nextDeadline);
+    }
+}
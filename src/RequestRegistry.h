@@ -0,0 +1,70 @@
+#ifndef REQUEST_REGISTRY_H
+#define REQUEST_REGISTRY_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+enum class RequestStatus { Completed, Failed, TimedOut };
+
+struct RequestResult {
+    RequestStatus status = RequestStatus::Completed;
+    std::string message;
+    bool ok() const { return status == RequestStatus::Completed; }
+};
+
+// Central allocator for TWS request/ticker ids plus the table of requests waiting for their
+// End callback. Every entry has a deadline; a sweeper thread fires TimedOut for overdue ones.
+// Handlers are always invoked outside the registry lock, exactly once per request.
+class RequestRegistry {
+public:
+    using Handler = std::function<void(const RequestResult& result)>;
+
+    explicit RequestRegistry(int firstId = 10000);
+    ~RequestRegistry();
+
+    RequestRegistry(const RequestRegistry&) = delete;
+    RequestRegistry& operator=(const RequestRegistry&) = delete;
+
+    // Thread-safe, never reuses an id within a session.
+    int nextId();
+
+    // Register before sending the request so a fast End callback cannot be missed.
+    void add(int reqId, std::chrono::milliseconds timeout, Handler handler);
+    // Same, but resolves a future instead of calling a handler.
+    std::future<RequestResult> track(int reqId, std::chrono::milliseconds timeout);
+
+    bool complete(int reqId);
+    bool fail(int reqId, const std::string& message);
+    // Drops the entry without invoking its handler.
+    bool cancel(int reqId);
+    // Restarts the deadline, e.g. when a request that was queued locally is actually sent.
+    bool resetDeadline(int reqId, std::chrono::milliseconds timeout);
+
+    bool isPending(int reqId) const;
+    size_t pendingCount() const;
+
+private:
+    struct Entry {
+        std::chrono::steady_clock::time_point deadline;
+        Handler handler;
+    };
+
+    bool finish(int reqId, RequestResult result);
+    void sweepLoop();
+
+    std::atomic<int> m_nextId;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::unordered_map<int, Entry> m_pending;
+    bool m_stop = false;
+    std::thread m_sweeper;
+};
+
+#endif // REQUEST_REGISTRY_H
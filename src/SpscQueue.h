@@ -0,0 +1,102 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Bounded single-producer / single-consumer ring buffer.
+// The producer only writes m_tail and the consumer only writes m_head, so push and pop
+// never take a lock. Each side keeps a cached copy of the other side's index to avoid
+// touching the shared cache line on every call.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : m_capacity(roundUpPowerOfTwo(capacity)),
+          m_mask(m_capacity - 1),
+          m_slots(new T[m_capacity]) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side. Returns false when the queue is full; the value is left untouched so
+    // the caller can either retry or record a drop.
+    bool tryPush(T&& value) {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead >= m_capacity) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead >= m_capacity)
+                return false;
+        }
+        m_slots[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        m_pushed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer side. Returns false when the queue is empty.
+    bool tryPop(T& out) {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail)
+                return false;
+        }
+        out = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called concurrently with push/pop.
+    size_t size() const {
+        const uint64_t tail = m_tail.load(std::memory_order_acquire);
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        return static_cast<size_t>(tail - head);
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return m_capacity; }
+    uint64_t pushed() const { return m_pushed.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    void countDrop() { m_dropped.fetch_add(1, std::memory_order_relaxed); }
+    // The producer retried a full queue instead of dropping (used by lossless domains).
+    void countFullWait() { m_fullWaits.fetch_add(1, std::memory_order_relaxed); }
+    uint64_t fullWaits() const { return m_fullWaits.load(std::memory_order_relaxed); }
+
+    // Optional parking for a blocking consumer. The consumer reads doorbell(), re-checks
+    // empty() and then waitForRing(seen); the producer calls ring() after pushing.
+    uint32_t doorbell() const { return m_doorbell.load(std::memory_order_acquire); }
+    void ring() {
+        m_doorbell.fetch_add(1, std::memory_order_release);
+        m_doorbell.notify_one();
+    }
+    void waitForRing(uint32_t seen) const { m_doorbell.wait(seen, std::memory_order_acquire); }
+
+private:
+    static size_t roundUpPowerOfTwo(size_t n) {
+        size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+
+    alignas(64) std::atomic<uint64_t> m_head{0};   // written by consumer
+    uint64_t m_cachedTail = 0;                     // consumer's view of m_tail
+
+    alignas(64) std::atomic<uint64_t> m_tail{0};   // written by producer
+    uint64_t m_cachedHead = 0;                     // producer's view of m_head
+
+    alignas(64) std::atomic<uint64_t> m_pushed{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_fullWaits{0};
+    std::atomic<uint32_t> m_doorbell{0};
+};
+
+#endif // SPSC_QUEUE_H
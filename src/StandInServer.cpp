@@ -0,0 +1,1030 @@
+#include "StandInServer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// Message ids as used by the IB API (EClient for requests, EDecoder for responses).
+namespace req {
+constexpr int MKT_DATA = 1;
+constexpr int CANCEL_MKT_DATA = 2;
+constexpr int PLACE_ORDER = 3;
+constexpr int CANCEL_ORDER = 4;
+constexpr int OPEN_ORDERS = 5;
+constexpr int ACCT_DATA = 6;
+constexpr int EXECUTIONS = 7;
+constexpr int IDS = 8;
+constexpr int CONTRACT_DATA = 9;
+constexpr int AUTO_OPEN_ORDERS = 15;
+constexpr int ALL_OPEN_ORDERS = 16;
+constexpr int MANAGED_ACCTS = 17;
+constexpr int HISTORICAL_DATA = 20;
+constexpr int CANCEL_HISTORICAL_DATA = 25;
+constexpr int CURRENT_TIME = 49;
+constexpr int POSITIONS = 61;
+constexpr int ACCOUNT_SUMMARY = 62;
+constexpr int CANCEL_ACCOUNT_SUMMARY = 63;
+constexpr int CANCEL_POSITIONS = 64;
+constexpr int START_API = 71;
+constexpr int REQ_PNL = 92;
+constexpr int CANCEL_PNL = 93;
+constexpr int REQ_PNL_SINGLE = 94;
+constexpr int CANCEL_PNL_SINGLE = 95;
+constexpr int TICK_BY_TICK_DATA = 97;
+constexpr int CANCEL_TICK_BY_TICK_DATA = 98;
+constexpr int CURRENT_TIME_IN_MILLIS = 105;
+} // namespace req
+
+namespace msg {
+constexpr int TICK_PRICE = 1;
+constexpr int TICK_SIZE = 2;
+constexpr int ORDER_STATUS = 3;
+constexpr int ACCT_VALUE = 6;
+constexpr int PORTFOLIO_VALUE = 7;
+constexpr int ACCT_UPDATE_TIME = 8;
+constexpr int NEXT_VALID_ID = 9;
+constexpr int MANAGED_ACCTS = 15;
+constexpr int HISTORICAL_DATA = 17;
+constexpr int TICK_OPTION_COMPUTATION = 21;
+constexpr int CURRENT_TIME = 49;
+constexpr int CONTRACT_DATA_END = 52;
+constexpr int OPEN_ORDER_END = 53;
+constexpr int ACCT_DOWNLOAD_END = 54;
+constexpr int EXECUTION_DATA_END = 55;
+constexpr int TICK_SNAPSHOT_END = 57;
+constexpr int POSITION_DATA = 61;
+constexpr int POSITION_END = 62;
+constexpr int ACCOUNT_SUMMARY = 63;
+constexpr int ACCOUNT_SUMMARY_END = 64;
+constexpr int HISTORICAL_DATA_UPDATE = 90;
+constexpr int PNL = 94;
+constexpr int PNL_SINGLE = 95;
+constexpr int TICK_BY_TICK = 99;
+constexpr int HISTORICAL_DATA_END = 108;
+constexpr int CURRENT_TIME_IN_MILLIS = 109;
+} // namespace msg
+
+// Tick types (TickType enum in the IB API).
+constexpr int BID = 1, ASK = 2, LAST = 4, VOLUME = 8, CLOSE = 9;
+constexpr int MODEL_OPTION_COMPUTATION = 13;
+
+// Server versions at which the encodings used here change. Everything from
+// PRICE_BASED_VOLATILITY up to (not including) PROTOBUF is supported.
+constexpr int MIN_SERVER_VER_PRICE_BASED_VOLATILITY = 156;
+constexpr int MIN_SERVER_VER_CME_TAGGING_FIELDS = 189;
+constexpr int MIN_SERVER_VER_HISTORICAL_DATA_END = 196;
+constexpr int MIN_SERVER_VER_PROTOBUF = 201;
+constexpr int kMinClientVersion = 100;  // length-prefixed framing
+
+// Upper bound of messages produced per stream per wakeup; a stream that falls further behind
+// skips ahead instead of building an unbounded backlog.
+constexpr uint64_t kMaxBurst = 4096;
+
+using Fields = std::vector<std::string>;
+
+const std::string& field(const Fields& f, size_t i) {
+    static const std::string empty;
+    return i < f.size() ? f[i] : empty;
+}
+int intField(const Fields& f, size_t i) { return std::atoi(field(f, i).c_str()); }
+double doubleField(const Fields& f, size_t i) { return std::atof(field(f, i).c_str()); }
+
+// One outgoing message: NUL-terminated text fields behind a 4-byte big-endian length.
+class Message {
+public:
+    explicit Message(int msgId) : m_id(msgId) { add(msgId); }
+
+    int id() const { return m_id; }
+
+    Message& add(const std::string& v) {
+        m_body.append(v);
+        m_body.push_back('\0');
+        return *this;
+    }
+    Message& add(const char* v) { return add(std::string(v)); }
+    Message& add(int v) { return add(std::to_string(v)); }
+    Message& add(long long v) { return add(std::to_string(v)); }
+    Message& add(double v) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.10g", v);
+        return add(std::string(buf));
+    }
+
+    void appendTo(std::string& out) const {
+        uint32_t len = htonl(static_cast<uint32_t>(m_body.size()));
+        out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+        out.append(m_body);
+    }
+
+private:
+    int m_id;
+    std::string m_body;
+};
+
+// Batch of framed messages written with a single send().
+struct Outbox {
+    std::string bytes;
+    uint64_t count = 0;
+    std::vector<int> ids;
+    void push(const Message& m) {
+        m.appendTo(bytes);
+        ids.push_back(m.id());
+        ++count;
+    }
+};
+
+std::string formatTime(time_t t, bool dateOnly) {
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), dateOnly ? "%Y%m%d" : "%Y%m%d %H:%M:%S", &tm);
+    return buf;
+}
+
+// "YYYYMMDD HH:MM:SS" or "YYYYMMDD-HH:MM:SS", optionally followed by a time zone which is
+// ignored (all stand-in times are UTC). Empty means now.
+time_t parseEndDateTime(const std::string& s) {
+    if (s.size() < 8)
+        return std::time(nullptr);
+    std::tm tm{};
+    tm.tm_year = std::atoi(s.substr(0, 4).c_str()) - 1900;
+    tm.tm_mon = std::atoi(s.substr(4, 2).c_str()) - 1;
+    tm.tm_mday = std::atoi(s.substr(6, 2).c_str());
+    if (s.size() >= 17) {
+        tm.tm_hour = std::atoi(s.substr(9, 2).c_str());
+        tm.tm_min = std::atoi(s.substr(12, 2).c_str());
+        tm.tm_sec = std::atoi(s.substr(15, 2).c_str());
+    }
+    return timegm(&tm);
+}
+
+// "<n> <unit>" with unit secs/mins/hours/day(s)/week/month, e.g. "5 mins" or "1 day".
+long long parseBarSeconds(const std::string& s) {
+    long long n = std::max(1, std::atoi(s.c_str()));
+    if (s.find("sec") != std::string::npos) return n;
+    if (s.find("min") != std::string::npos) return n * 60;
+    if (s.find("hour") != std::string::npos) return n * 3600;
+    if (s.find("week") != std::string::npos) return n * 7 * 86400;
+    if (s.find("month") != std::string::npos) return n * 30 * 86400;
+    return n * 86400;
+}
+
+// "<n> S|D|W|M|Y".
+long long parseDurationSeconds(const std::string& s) {
+    long long n = std::max(1, std::atoi(s.c_str()));
+    char unit = s.empty() ? 'D' : s.back();
+    switch (unit) {
+        case 'S': return n;
+        case 'W': return n * 7 * 86400;
+        case 'M': return n * 30 * 86400;
+        case 'Y': return n * 365 * 86400;
+        default: return n * 86400;
+    }
+}
+
+double roundToCent(double v) { return std::round(v * 100.0) / 100.0; }
+
+// Stable fake conId per symbol (FNV-1a), the same in every session and run, so clients can key
+// positions and P&L lines by conId as they do against TWS.
+int conIdOf(const std::string& symbol) {
+    uint32_t h = 2166136261u;
+    for (unsigned char c : symbol)
+        h = (h ^ c) * 16777619u;
+    return 100000000 + static_cast<int>(h % 900000000u);
+}
+
+} // namespace
+
+// One connected client. The read thread answers requests; the stream thread produces
+// subscriptions at their configured rates, scheduled fills and keepUpToDate bar updates.
+class StandInSession {
+public:
+    StandInSession(TwsStandInServer& server, int fd, uint32_t seed)
+        : m_server(server), m_config(server.m_config), m_fd(fd), m_rng(seed) {}
+
+    ~StandInSession() {
+        stop();
+        ::close(m_fd);
+    }
+
+    void start() {
+        m_readThread = std::thread([this]() { readLoop(); });
+        m_streamThread = std::thread([this]() { streamLoop(); });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            m_active = false;
+        }
+        m_cond.notify_all();
+        ::shutdown(m_fd, SHUT_RDWR);
+        if (m_readThread.joinable())
+            m_readThread.join();
+        if (m_streamThread.joinable())
+            m_streamThread.join();
+    }
+
+    bool finished() const { return m_finished.load(std::memory_order_acquire); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct QuoteStream {
+        std::string symbol;
+        bool option = false;
+        Clock::time_point start;
+        uint64_t sent = 0;
+    };
+    struct TickByTickStream {
+        std::string symbol;
+        int tickType = 1;  // 1 Last, 2 AllLast, 3 BidAsk, 4 MidPoint
+        Clock::time_point start;
+        uint64_t sent = 0;
+    };
+    struct BarStream {
+        std::string symbol;
+        long long barSeconds = 60;
+        int formatDate = 1;
+        time_t barStart = 0;
+        double open = 0.0, high = 0.0, low = 0.0, close = 0.0, volume = 0.0;
+        Clock::time_point nextUpdate;
+    };
+    struct WorkingOrder {
+        std::string symbol;
+        bool buy = true;
+        double qty = 0.0;
+        std::string type;
+        double lmtPrice = 0.0;
+        double auxPrice = 0.0;
+        bool fillScheduled = false;
+        Clock::time_point fillAt;
+    };
+    struct Holding {
+        double qty = 0.0;
+        double avgCost = 0.0;
+    };
+    struct PnlStream {
+        int conId = 0;  // 0 for the account (reqPnL)
+        Clock::time_point nextUpdate;
+    };
+
+    // --- I/O ---
+
+    bool readExact(char* buf, size_t n) {
+        while (n > 0) {
+            ssize_t r = ::recv(m_fd, buf, n, 0);
+            if (r <= 0) {
+                if (r < 0 && errno == EINTR)
+                    continue;
+                return false;
+            }
+            buf += r;
+            n -= static_cast<size_t>(r);
+        }
+        return true;
+    }
+
+    bool readFrame(std::string& body) {
+        uint32_t len = 0;
+        if (!readExact(reinterpret_cast<char*>(&len), sizeof(len)))
+            return false;
+        len = ntohl(len);
+        if (len > (1u << 24))
+            return false;
+        body.resize(len);
+        return len == 0 || readExact(body.data(), len);
+    }
+
+    void write(const Outbox& out) {
+        if (out.count == 0)
+            return;
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        if (m_config.onSend) {
+            for (int id : out.ids)
+                m_config.onSend(id);
+        }
+        const char* p = out.bytes.data();
+        size_t n = out.bytes.size();
+        while (n > 0) {
+            ssize_t w = ::send(m_fd, p, n, MSG_NOSIGNAL);
+            if (w <= 0) {
+                if (w < 0 && errno == EINTR)
+                    continue;
+                return; // the read thread notices the broken socket and ends the session
+            }
+            p += w;
+            n -= static_cast<size_t>(w);
+        }
+        m_server.m_messagesOut.fetch_add(out.count, std::memory_order_relaxed);
+        m_server.m_bytesOut.fetch_add(out.bytes.size(), std::memory_order_relaxed);
+    }
+
+    static Fields split(const std::string& body) {
+        Fields fields;
+        size_t start = 0;
+        while (start < body.size()) {
+            size_t end = body.find('\0', start);
+            if (end == std::string::npos)
+                end = body.size();
+            fields.emplace_back(body, start, end - start);
+            start = end + 1;
+        }
+        return fields;
+    }
+
+    // Client sends "API\0" then a framed "v<min>..<max>[ options]"; we answer with the
+    // negotiated server version and the connection time.
+    bool handshake() {
+        char prefix[4];
+        if (!readExact(prefix, sizeof(prefix)) || std::memcmp(prefix, "API\0", 4) != 0) {
+            std::cerr << "error at StandInSession::handshake: missing API prefix" << std::endl;
+            return false;
+        }
+        std::string versions;
+        if (!readFrame(versions) || versions.empty() || versions[0] != 'v') {
+            std::cerr << "error at StandInSession::handshake: bad version range" << std::endl;
+            return false;
+        }
+        int clientMin = std::atoi(versions.c_str() + 1);
+        size_t dots = versions.find("..");
+        int clientMax = dots == std::string::npos ? clientMin : std::atoi(versions.c_str() + dots + 2);
+        int configured = std::clamp(m_config.serverVersion, MIN_SERVER_VER_PRICE_BASED_VOLATILITY,
+                                    MIN_SERVER_VER_PROTOBUF - 1);
+        m_serverVersion = std::min(configured, clientMax);
+        if (clientMin < kMinClientVersion || m_serverVersion < MIN_SERVER_VER_PRICE_BASED_VOLATILITY ||
+            m_serverVersion < clientMin) {
+            std::cerr << "error at StandInSession::handshake: unsupported client versions " << versions << std::endl;
+            return false;
+        }
+
+        Outbox out;
+        Message ack(m_serverVersion);  // the connect ack has no message id, just version and time
+        ack.add(formatTime(std::time(nullptr), false) + " UTC");
+        out.push(ack);
+        write(out);
+        return true;
+    }
+
+    void readLoop() {
+        if (handshake()) {
+            std::string body;
+            while (readFrame(body)) {
+                m_server.m_messagesIn.fetch_add(1, std::memory_order_relaxed);
+                Fields f = split(body);
+                if (!f.empty())
+                    handle(f);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            m_active = false;
+        }
+        m_cond.notify_all();
+        m_finished.store(true, std::memory_order_release);
+    }
+
+    // --- Requests ---
+
+    void handle(const Fields& f) {
+        Outbox out;
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            switch (intField(f, 0)) {
+                case req::START_API:
+                    m_clientId = intField(f, 2);
+                    out.push(Message(msg::NEXT_VALID_ID).add(1).add(m_nextValidId));
+                    out.push(Message(msg::MANAGED_ACCTS).add(1).add(m_config.account));
+                    break;
+                case req::IDS:
+                    out.push(Message(msg::NEXT_VALID_ID).add(1).add(m_nextValidId));
+                    break;
+                case req::MANAGED_ACCTS:
+                    out.push(Message(msg::MANAGED_ACCTS).add(1).add(m_config.account));
+                    break;
+                case req::CURRENT_TIME:
+                    out.push(Message(msg::CURRENT_TIME).add(1).add(static_cast<long long>(std::time(nullptr))));
+                    break;
+                case req::CURRENT_TIME_IN_MILLIS:
+                    out.push(Message(msg::CURRENT_TIME_IN_MILLIS).add(static_cast<long long>(
+                        std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count())));
+                    break;
+                case req::MKT_DATA:
+                    onMarketData(f, out);
+                    break;
+                case req::CANCEL_MKT_DATA:
+                    m_quotes.erase(intField(f, 2));
+                    break;
+                case req::TICK_BY_TICK_DATA:
+                    onTickByTick(f, out);
+                    break;
+                case req::CANCEL_TICK_BY_TICK_DATA:
+                    m_tickByTick.erase(intField(f, 1));
+                    break;
+                case req::HISTORICAL_DATA:
+                    onHistoricalData(f, out);
+                    break;
+                case req::CANCEL_HISTORICAL_DATA:
+                    m_bars.erase(intField(f, 2));
+                    break;
+                case req::PLACE_ORDER:
+                    onPlaceOrder(f, out);
+                    break;
+                case req::CANCEL_ORDER:
+                    onCancelOrder(f, out);
+                    break;
+                case req::OPEN_ORDERS:
+                case req::AUTO_OPEN_ORDERS:
+                case req::ALL_OPEN_ORDERS:
+                    out.push(Message(msg::OPEN_ORDER_END).add(1));
+                    break;
+                case req::EXECUTIONS:
+                    out.push(Message(msg::EXECUTION_DATA_END).add(1).add(intField(f, 2)));
+                    break;
+                case req::CONTRACT_DATA:
+                    out.push(Message(msg::CONTRACT_DATA_END).add(1).add(intField(f, 2)));
+                    break;
+                case req::POSITIONS:
+                    onPositions(out);
+                    break;
+                case req::ACCOUNT_SUMMARY:
+                    onAccountSummary(f, out);
+                    break;
+                case req::ACCT_DATA:
+                    if (intField(f, 2) != 0)
+                        onAccountUpdates(out);
+                    break;
+                case req::REQ_PNL:
+                    onPnl(intField(f, 1), 0, out);
+                    break;
+                case req::REQ_PNL_SINGLE:
+                    onPnl(intField(f, 1), intField(f, 4), out);
+                    break;
+                case req::CANCEL_PNL:
+                case req::CANCEL_PNL_SINGLE:
+                    m_pnl.erase(intField(f, 1));
+                    break;
+                case req::CANCEL_ACCOUNT_SUMMARY:
+                case req::CANCEL_POSITIONS:
+                default:
+                    break;
+            }
+            m_wakeup = true; // new subscriptions or orders for the stream thread
+        }
+        m_cond.notify_all();
+        write(out);
+    }
+
+    // Contract fields start at `base`: conId, symbol, secType, lastTradeDate, strike, right,
+    // multiplier, exchange, primaryExchange, currency, localSymbol, tradingClass.
+    static std::string contractKey(const Fields& f, size_t base) {
+        const std::string& secType = field(f, base + 2);
+        const std::string& localSymbol = field(f, base + 10);
+        if (secType == "OPT" && !localSymbol.empty())
+            return localSymbol;
+        return field(f, base + 1);
+    }
+
+    void onMarketData(const Fields& f, Outbox& out) {
+        const int tickerId = intField(f, 2);
+        QuoteStream stream;
+        stream.symbol = contractKey(f, 3);
+        stream.option = field(f, 5) == "OPT";
+        const bool snapshot = intField(f, 17) != 0;
+
+        double px = price(stream.symbol);
+        out.push(tickPrice(tickerId, BID, px - 0.01, 100));
+        out.push(tickPrice(tickerId, ASK, px + 0.01, 100));
+        out.push(tickPrice(tickerId, LAST, px, 100));
+        out.push(tickPrice(tickerId, CLOSE, px, 0));
+        if (stream.option)
+            out.push(optionComputation(tickerId, px));
+
+        if (snapshot) {
+            out.push(Message(msg::TICK_SNAPSHOT_END).add(1).add(tickerId));
+            return;
+        }
+        stream.start = Clock::now();
+        m_quotes[tickerId] = stream;
+    }
+
+    void onTickByTick(const Fields& f, Outbox& out) {
+        const int reqId = intField(f, 1);
+        TickByTickStream stream;
+        stream.symbol = contractKey(f, 2);
+        const std::string& type = field(f, 14);
+        stream.tickType = type == "AllLast" ? 2 : type == "BidAsk" ? 3 : type == "MidPoint" ? 4 : 1;
+        stream.start = Clock::now();
+        out.push(tickByTick(reqId, stream));
+        m_tickByTick[reqId] = stream;
+    }
+
+    void onHistoricalData(const Fields& f, Outbox& out) {
+        const int reqId = intField(f, 1);
+        const std::string symbol = contractKey(f, 2);
+        const time_t end = parseEndDateTime(field(f, 15));
+        const long long barSeconds = parseBarSeconds(field(f, 16));
+        const long long duration = parseDurationSeconds(field(f, 17));
+        const int formatDate = intField(f, 20);
+        const bool keepUpToDate = intField(f, 21) != 0;
+
+        long long count = std::max(1LL, duration / barSeconds);
+        count = std::min<long long>(count, std::max(1, m_config.maxHistoricalBars));
+        const time_t first = end - static_cast<time_t>((count - 1) * barSeconds);
+        auto stamp = [&](time_t t) {
+            return formatDate == 2 ? std::to_string(static_cast<long long>(t)) : formatTime(t, barSeconds >= 86400);
+        };
+        const std::string startStr = formatTime(first - barSeconds, false);
+        const std::string endStr = formatTime(end, false);
+
+        Message m(msg::HISTORICAL_DATA);
+        m.add(reqId);
+        if (m_serverVersion < MIN_SERVER_VER_HISTORICAL_DATA_END)
+            m.add(startStr).add(endStr);
+        m.add(static_cast<int>(count));
+
+        // Deterministic per symbol, independent of the live price path.
+        std::mt19937 rng(m_config.seed ^ static_cast<uint32_t>(std::hash<std::string>{}(symbol)));
+        std::normal_distribution<double> step(0.0, 0.01);
+        double close = basePrice(symbol);
+        BarStream last;
+        for (long long i = 0; i < count; ++i) {
+            const double open = close;
+            close = roundToCent(open * std::exp(step(rng)));
+            const double high = roundToCent(std::max(open, close) * (1.0 + std::abs(step(rng)) / 2));
+            const double low = roundToCent(std::min(open, close) * (1.0 - std::abs(step(rng)) / 2));
+            const long long volume = 1000 + static_cast<long long>(rng() % 100000);
+            const time_t t = first + static_cast<time_t>(i * barSeconds);
+            m.add(stamp(t)).add(open).add(high).add(low).add(close)
+             .add(volume).add(roundToCent((open + high + low + close) / 4)).add(static_cast<int>(volume / 100));
+            last = BarStream{symbol, barSeconds, formatDate, t, open, high, low, close, static_cast<double>(volume), {}};
+        }
+        out.push(m);
+        if (m_serverVersion >= MIN_SERVER_VER_HISTORICAL_DATA_END)
+            out.push(Message(msg::HISTORICAL_DATA_END).add(reqId).add(startStr).add(endStr));
+
+        if (keepUpToDate) {
+            m_prices[symbol] = last.close; // continue the live path from the last bar
+            last.nextUpdate = Clock::now() + m_config.barUpdateInterval;
+            m_bars[reqId] = last;
+        }
+    }
+
+    void onPlaceOrder(const Fields& f, Outbox& out) {
+        // orderId, 15 contract fields (incl. secIdType/secId), action, totalQuantity,
+        // orderType, lmtPrice, auxPrice, ...
+        const int orderId = intField(f, 1);
+        WorkingOrder order;
+        order.symbol = contractKey(f, 2);
+        order.buy = field(f, 16) == "BUY";
+        order.qty = doubleField(f, 17);
+        order.type = field(f, 18);
+        order.lmtPrice = doubleField(f, 19);
+        order.auxPrice = doubleField(f, 20);
+        m_nextValidId = std::max(m_nextValidId, orderId + 1);
+
+        out.push(orderStatus(orderId, "Submitted", 0.0, order.qty, 0.0));
+        const double px = price(order.symbol);
+        if (order.type == "MKT" || marketable(order, px)) {
+            order.fillScheduled = true;
+            order.fillAt = Clock::now() + m_config.fillDelay;
+        }
+        m_orders[orderId] = order;
+    }
+
+    void onCancelOrder(const Fields& f, Outbox& out) {
+        const int orderId = intField(f, m_serverVersion < MIN_SERVER_VER_CME_TAGGING_FIELDS ? 2 : 1);
+        auto it = m_orders.find(orderId);
+        if (it == m_orders.end())
+            return;
+        out.push(orderStatus(orderId, "Cancelled", 0.0, it->second.qty, 0.0));
+        m_orders.erase(it);
+    }
+
+    void onPositions(Outbox& out) {
+        for (const auto& [symbol, h] : m_holdings) {
+            Message m(msg::POSITION_DATA);
+            m.add(3).add(m_config.account);
+            addStockContract(m, symbol, true);
+            m.add(h.qty).add(h.avgCost);
+            out.push(m);
+        }
+        out.push(Message(msg::POSITION_END).add(1));
+    }
+
+    void onAccountSummary(const Fields& f, Outbox& out) {
+        const int reqId = intField(f, 2);
+        std::stringstream tags(field(f, 4));
+        for (std::string tag; std::getline(tags, tag, ',');) {
+            double value;
+            if (tag == "TotalCashValue" || tag == "AvailableFunds" || tag == "BuyingPower")
+                value = m_cash;
+            else if (tag == "NetLiquidation")
+                value = m_cash + marketValue();
+            else
+                continue;
+            out.push(Message(msg::ACCOUNT_SUMMARY).add(1).add(reqId).add(m_config.account)
+                     .add(tag).add(value).add("USD"));
+        }
+        out.push(Message(msg::ACCOUNT_SUMMARY_END).add(1).add(reqId));
+    }
+
+    void onAccountUpdates(Outbox& out) {
+        auto value = [&](const char* key, double v) {
+            out.push(Message(msg::ACCT_VALUE).add(2).add(key).add(v).add("USD").add(m_config.account));
+        };
+        value("CashBalance", m_cash);
+        value("TotalCashValue", m_cash);
+        value("NetLiquidation", m_cash + marketValue());
+        for (const auto& [symbol, h] : m_holdings) {
+            const double px = price(symbol);
+            Message m(msg::PORTFOLIO_VALUE);
+            m.add(8);
+            addStockContract(m, symbol, false);
+            m.add(h.qty).add(px).add(h.qty * px).add(h.avgCost)
+             .add(h.qty * (px - h.avgCost)).add(0.0).add(m_config.account);
+            out.push(m);
+        }
+        out.push(Message(msg::ACCT_UPDATE_TIME).add(1).add(formatTime(std::time(nullptr), false).substr(9, 5)));
+        out.push(Message(msg::ACCT_DOWNLOAD_END).add(1).add(m_config.account));
+    }
+
+    // The first update goes out with the request, then one per second as TWS does.
+    void onPnl(int reqId, int conId, Outbox& out) {
+        PnlStream stream;
+        stream.conId = conId;
+        out.push(pnlUpdate(reqId, stream));
+        stream.nextUpdate = Clock::now() + std::chrono::seconds(1);
+        m_pnl[reqId] = stream;
+    }
+
+    // position: ..., multiplier, exchange, currency, localSymbol, tradingClass
+    // portfolio: ..., multiplier, primaryExchange, currency, localSymbol, tradingClass
+    static void addStockContract(Message& m, const std::string& symbol, bool withExchange) {
+        m.add(conIdOf(symbol)).add(symbol).add("STK").add("").add(0.0).add("").add("");
+        if (withExchange)
+            m.add("SMART");
+        else
+            m.add("NASDAQ");
+        m.add("USD").add(symbol).add(symbol);
+    }
+
+    // --- Streaming ---
+
+    void streamLoop() {
+        std::unique_lock<std::mutex> lock(m_stateMutex);
+        while (m_active) {
+            const auto now = Clock::now();
+            Outbox out;
+            auto wake = now + std::chrono::seconds(1);
+
+            if (m_config.quoteRate > 0.0) {
+                for (auto& [tickerId, s] : m_quotes) {
+                    for (uint64_t n = due(s.start, s.sent, m_config.quoteRate, now); n > 0; --n, ++s.sent)
+                        out.push(quoteTick(tickerId, s, out));
+                }
+                if (!m_quotes.empty())
+                    wake = std::min(wake, now + std::chrono::milliseconds(1));
+            }
+            if (m_config.tickByTickRate > 0.0) {
+                for (auto& [reqId, s] : m_tickByTick) {
+                    for (uint64_t n = due(s.start, s.sent, m_config.tickByTickRate, now); n > 0; --n, ++s.sent) {
+                        step(s.symbol, out);
+                        out.push(tickByTick(reqId, s));
+                    }
+                }
+                if (!m_tickByTick.empty())
+                    wake = std::min(wake, now + std::chrono::milliseconds(1));
+            }
+            for (auto& [reqId, b] : m_bars) {
+                if (now >= b.nextUpdate) {
+                    out.push(barUpdate(reqId, b, out));
+                    b.nextUpdate = now + m_config.barUpdateInterval;
+                }
+                wake = std::min(wake, b.nextUpdate);
+            }
+            for (auto& [reqId, p] : m_pnl) {
+                if (now >= p.nextUpdate) {
+                    out.push(pnlUpdate(reqId, p));
+                    p.nextUpdate = now + std::chrono::seconds(1);
+                }
+                wake = std::min(wake, p.nextUpdate);
+            }
+            for (auto it = m_orders.begin(); it != m_orders.end();) {
+                if (it->second.fillScheduled && now >= it->second.fillAt) {
+                    fill(it->first, it->second, out);
+                    it = m_orders.erase(it);
+                    continue;
+                }
+                if (it->second.fillScheduled)
+                    wake = std::min(wake, it->second.fillAt);
+                ++it;
+            }
+
+            lock.unlock();
+            write(out);
+            lock.lock();
+            m_cond.wait_until(lock, wake, [this]() { return !m_active || m_wakeup; });
+            m_wakeup = false;
+        }
+    }
+
+    // Messages owed to a stream at `rate` per second since `start`.
+    static uint64_t due(Clock::time_point start, uint64_t& sent, double rate, Clock::time_point now) {
+        const double elapsed = std::chrono::duration<double>(now - start).count();
+        const uint64_t target = static_cast<uint64_t>(elapsed * rate);
+        if (target > sent + kMaxBurst)
+            sent = target - kMaxBurst; // cannot keep up: drop the backlog rather than grow it
+        return target > sent ? target - sent : 0;
+    }
+
+    Message quoteTick(int tickerId, QuoteStream& s, Outbox& out) {
+        const double px = step(s.symbol, out);
+        switch (s.sent % 4) {
+            case 0: return tickPrice(tickerId, BID, px - 0.01, 100 + static_cast<int>(m_rng() % 900));
+            case 1: return tickPrice(tickerId, ASK, px + 0.01, 100 + static_cast<int>(m_rng() % 900));
+            case 2: return tickPrice(tickerId, LAST, px, 100 * (1 + static_cast<int>(m_rng() % 10)));
+            default:
+                if (s.option)
+                    return optionComputation(tickerId, px);
+                return Message(msg::TICK_SIZE).add(6).add(tickerId).add(VOLUME)
+                    .add(static_cast<long long>(100000 + s.sent * 100));
+        }
+    }
+
+    Message tickPrice(int tickerId, int tickType, double px, int size) {
+        // version 6: size follows the price (and is reported again through tickSize), then attribs
+        Message m(msg::TICK_PRICE);
+        m.add(6).add(tickerId).add(tickType).add(roundToCent(px)).add(size).add(0);
+        return m;
+    }
+
+    Message optionComputation(int tickerId, double px) {
+        const double iv = 0.2 + static_cast<double>(m_rng() % 2000) / 10000.0;
+        const double undPrice = px * 50.0;
+        Message m(msg::TICK_OPTION_COMPUTATION);
+        // tickerId, tickType, tickAttrib, impliedVol, delta, optPrice, pvDividend, gamma, vega, theta, undPrice
+        m.add(tickerId).add(MODEL_OPTION_COMPUTATION).add(0).add(iv).add(0.5).add(roundToCent(px))
+         .add(0.0).add(0.02).add(0.1).add(-0.05).add(roundToCent(undPrice));
+        return m;
+    }
+
+    Message tickByTick(int reqId, const TickByTickStream& s) {
+        const double px = price(s.symbol);
+        Message m(msg::TICK_BY_TICK);
+        m.add(reqId).add(s.tickType).add(static_cast<long long>(std::time(nullptr)));
+        switch (s.tickType) {
+            case 3:
+                m.add(roundToCent(px - 0.01)).add(roundToCent(px + 0.01))
+                 .add(100 + static_cast<int>(m_rng() % 900)).add(100 + static_cast<int>(m_rng() % 900)).add(0);
+                break;
+            case 4:
+                m.add(roundToCent(px));
+                break;
+            default:
+                m.add(roundToCent(px)).add(100 * (1 + static_cast<int>(m_rng() % 10))).add(0).add("ISLAND").add("");
+                break;
+        }
+        return m;
+    }
+
+    Message barUpdate(int reqId, BarStream& b, Outbox& out) {
+        const double px = step(b.symbol, out);
+        const time_t now = std::time(nullptr);
+        if (now >= b.barStart + b.barSeconds) {
+            b.barStart += ((now - b.barStart) / b.barSeconds) * b.barSeconds;
+            b.open = b.high = b.low = px;
+            b.volume = 0.0;
+        }
+        b.close = px;
+        b.high = std::max(b.high, px);
+        b.low = std::min(b.low, px);
+        b.volume += 100.0 * static_cast<double>(1 + m_rng() % 10);
+        const std::string time = b.formatDate == 2 ? std::to_string(static_cast<long long>(b.barStart))
+                                                   : formatTime(b.barStart, b.barSeconds >= 86400);
+        // reqId, barCount, date, open, close, high, low, wap, volume
+        Message m(msg::HISTORICAL_DATA_UPDATE);
+        m.add(reqId).add(-1).add(time).add(b.open).add(b.close).add(b.high).add(b.low)
+         .add(roundToCent((b.open + b.high + b.low + b.close) / 4)).add(b.volume);
+        return m;
+    }
+
+    // Unrealized P&L against the average cost; the stand-in books no realized P&L and treats
+    // the whole unrealized amount as today's. An unknown or closed conId reports zeros.
+    Message pnlUpdate(int reqId, const PnlStream& p) {
+        double position = 0.0, value = 0.0, unrealized = 0.0;
+        for (const auto& [symbol, h] : m_holdings) {
+            if (p.conId != 0 && conIdOf(symbol) != p.conId)
+                continue;
+            const double px = price(symbol);
+            unrealized += h.qty * (px - h.avgCost);
+            if (p.conId != 0) {
+                position = h.qty;
+                value = h.qty * px;
+            }
+        }
+        if (p.conId == 0)
+            return Message(msg::PNL).add(reqId).add(unrealized).add(unrealized).add(0.0);
+        // reqId, pos, dailyPnL, unrealizedPnL, realizedPnL, value
+        return Message(msg::PNL_SINGLE).add(reqId).add(position).add(unrealized).add(unrealized)
+            .add(0.0).add(value);
+    }
+
+    Message orderStatus(int orderId, const char* status, double filled, double remaining, double avgPrice) {
+        // orderId, status, filled, remaining, avgFillPrice, permId, parentId, lastFillPrice,
+        // clientId, whyHeld, mktCapPrice
+        Message m(msg::ORDER_STATUS);
+        m.add(orderId).add(status).add(filled).add(remaining).add(avgPrice).add(1000000LL + orderId)
+         .add(0).add(avgPrice).add(m_clientId).add("").add(0.0);
+        return m;
+    }
+
+    void fill(int orderId, const WorkingOrder& order, Outbox& out) {
+        const double px = order.type == "LMT" ? order.lmtPrice : roundToCent(price(order.symbol));
+        out.push(orderStatus(orderId, "Filled", order.qty, 0.0, px));
+
+        Holding& h = m_holdings[order.symbol];
+        const double signedQty = order.buy ? order.qty : -order.qty;
+        const double newQty = h.qty + signedQty;
+        if (newQty == 0.0) {
+            m_holdings.erase(order.symbol);
+        } else {
+            if ((h.qty >= 0.0) == (signedQty >= 0.0))
+                h.avgCost = (h.avgCost * std::abs(h.qty) + px * order.qty) / std::abs(newQty);
+            else if ((h.qty > 0.0) != (newQty > 0.0))
+                h.avgCost = px; // flipped sides
+            h.qty = newQty;
+        }
+        m_cash -= signedQty * px;
+    }
+
+    static bool marketable(const WorkingOrder& o, double px) {
+        if (o.type == "LMT")
+            return o.buy ? px <= o.lmtPrice : px >= o.lmtPrice;
+        if (o.type == "STP")
+            return o.buy ? px >= o.auxPrice : px <= o.auxPrice;
+        return false;
+    }
+
+    static double basePrice(const std::string& symbol) {
+        return 20.0 + static_cast<double>(std::hash<std::string>{}(symbol) % 48000) / 100.0;
+    }
+
+    double price(const std::string& symbol) {
+        auto it = m_prices.find(symbol);
+        if (it == m_prices.end())
+            it = m_prices.emplace(symbol, basePrice(symbol)).first;
+        return it->second;
+    }
+
+    // Advances the symbol's random walk and triggers resting orders that became marketable.
+    double step(const std::string& symbol, Outbox& out) {
+        double& px = m_prices.try_emplace(symbol, basePrice(symbol)).first->second;
+        px = std::max(0.01, roundToCent(px * std::exp(m_noise(m_rng))));
+        for (auto it = m_orders.begin(); it != m_orders.end();) {
+            WorkingOrder& o = it->second;
+            if (!o.fillScheduled && o.symbol == symbol && marketable(o, px)) {
+                fill(it->first, o, out);
+                it = m_orders.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return px;
+    }
+
+    double marketValue() {
+        double total = 0.0;
+        for (const auto& [symbol, h] : m_holdings)
+            total += h.qty * price(symbol);
+        return total;
+    }
+
+    TwsStandInServer& m_server;
+    const StandInConfig& m_config;
+    const int m_fd;
+    int m_serverVersion = 0;
+
+    std::thread m_readThread;
+    std::thread m_streamThread;
+    std::mutex m_writeMutex;
+    std::atomic<bool> m_finished{false};
+
+    // Everything below is guarded by m_stateMutex.
+    std::mutex m_stateMutex;
+    std::condition_variable m_cond;
+    bool m_active = true;
+    bool m_wakeup = false;
+    int m_clientId = 0;
+    int m_nextValidId = 1;
+    std::mt19937 m_rng;
+    std::normal_distribution<double> m_noise{0.0, 0.0005};
+    std::map<std::string, double> m_prices;
+    std::map<int, QuoteStream> m_quotes;
+    std::map<int, TickByTickStream> m_tickByTick;
+    std::map<int, BarStream> m_bars;
+    std::map<int, WorkingOrder> m_orders;
+    std::map<std::string, Holding> m_holdings;
+    std::map<int, PnlStream> m_pnl;
+    double m_cash = m_config.cashBalance;
+};
+
+TwsStandInServer::TwsStandInServer(const StandInConfig& config) : m_config(config), m_port(config.port) {}
+
+TwsStandInServer::~TwsStandInServer() {
+    stop();
+}
+
+bool TwsStandInServer::start() {
+    if (m_running)
+        return true;
+    m_listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listenFd < 0) {
+        std::cerr << "error at TwsStandInServer::start: socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(m_config.port));
+    if (::bind(m_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(m_listenFd, 16) < 0) {
+        std::cerr << "error at TwsStandInServer::start: port " << m_config.port << ": "
+                  << std::strerror(errno) << std::endl;
+        ::close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    ::getsockname(m_listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+    m_port = ntohs(addr.sin_port);
+
+    m_running = true;
+    m_acceptThread = std::thread([this]() { acceptLoop(); });
+    return true;
+}
+
+void TwsStandInServer::stop() {
+    if (!m_running.exchange(false))
+        return;
+    ::shutdown(m_listenFd, SHUT_RDWR); // unblocks accept()
+    if (m_acceptThread.joinable())
+        m_acceptThread.join();
+    ::close(m_listenFd);
+    m_listenFd = -1;
+
+    std::lock_guard<std::mutex> lock(m_sessionsMutex);
+    m_sessions.clear(); // each session stops and joins its threads
+}
+
+void TwsStandInServer::acceptLoop() {
+    while (m_running) {
+        int fd = ::accept(m_listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        std::lock_guard<std::mutex> lock(m_sessionsMutex);
+        m_sessions.erase(std::remove_if(m_sessions.begin(), m_sessions.end(),
+                                        [](const auto& s) { return s->finished(); }),
+                         m_sessions.end());
+        const uint64_t index = m_sessionCount.fetch_add(1, std::memory_order_relaxed);
+        m_sessions.push_back(std::make_unique<StandInSession>(*this, fd, m_config.seed + static_cast<uint32_t>(index)));
+        m_sessions.back()->start();
+    }
+}
+
+StandInStats TwsStandInServer::stats() const {
+    StandInStats s;
+    s.sessions = m_sessionCount.load(std::memory_order_relaxed);
+    s.messagesIn = m_messagesIn.load(std::memory_order_relaxed);
+    s.messagesOut = m_messagesOut.load(std::memory_order_relaxed);
+    s.bytesOut = m_bytesOut.load(std::memory_order_relaxed);
+    return s;
+}
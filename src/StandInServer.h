@@ -0,0 +1,85 @@
+#ifndef STAND_IN_SERVER_H
+#define STAND_IN_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Settings of the local TWS stand-in. Rates are per subscription; 0 sends only the initial
+// values on subscribe.
+struct StandInConfig {
+    int port = 7497;                                // 0 = pick a free port (see TwsStandInServer::port())
+    int serverVersion = 197;                        // negotiated down to the client's maximum
+    double quoteRate = 10.0;                        // tickPrice/tickSize messages per second per reqMktData
+    double tickByTickRate = 10.0;                   // tickByTick messages per second per reqTickByTickData
+    std::chrono::milliseconds barUpdateInterval{1000}; // historicalDataUpdate period for keepUpToDate
+    std::chrono::milliseconds fillDelay{50};        // placeOrder -> Filled for marketable MKT/LMT orders
+    int maxHistoricalBars = 5000;
+    uint32_t seed = 42;                             // price paths are deterministic per seed and symbol
+    std::string account = "DU0000000";
+    double cashBalance = 100000.0;
+    // Called on the sending thread just before a batch goes to send(), once per message in it
+    // (in order), with the message id. For latency taps such as benchmarkReaderLatency.
+    std::function<void(int msgId)> onSend;
+};
+
+struct StandInStats {
+    uint64_t sessions = 0;
+    uint64_t messagesIn = 0;
+    uint64_t messagesOut = 0;
+    uint64_t bytesOut = 0;
+};
+
+class StandInSession;
+
+// Minimal server side of the TWS socket protocol (handshake, framing and the text-encoded
+// messages below protobuf server versions) so the real EClientSocket/EReader path can be
+// driven end to end without TWS or IB Gateway. Supported requests:
+//   startApi, reqIds, reqMktData (snapshot and streaming, option computations for OPT),
+//   reqTickByTickData (Last/AllLast/BidAsk/MidPoint), reqHistoricalData (incl. keepUpToDate),
+//   placeOrder/cancelOrder (orderStatus acks and fills), reqPositions, reqAccountSummary,
+//   reqAccountUpdates, reqPnL/reqPnLSingle (one update per second), reqCurrentTime,
+//   reqCurrentTimeInMillis. Contracts sent back carry a stable fake conId per symbol.
+// Other requests are answered with their End message where one exists, otherwise ignored.
+class TwsStandInServer {
+public:
+    explicit TwsStandInServer(const StandInConfig& config);
+    ~TwsStandInServer();
+
+    TwsStandInServer(const TwsStandInServer&) = delete;
+    TwsStandInServer& operator=(const TwsStandInServer&) = delete;
+
+    // Binds 127.0.0.1:port and starts accepting clients. Returns false if the port is unavailable.
+    bool start();
+    void stop();
+
+    int port() const { return m_port; }
+    StandInStats stats() const;
+
+private:
+    friend class StandInSession;
+
+    void acceptLoop();
+
+    StandInConfig m_config;
+    int m_port = 0;
+    int m_listenFd = -1;
+    std::atomic<bool> m_running{false};
+    std::thread m_acceptThread;
+
+    std::mutex m_sessionsMutex;
+    std::vector<std::unique_ptr<StandInSession>> m_sessions;
+
+    std::atomic<uint64_t> m_sessionCount{0};
+    std::atomic<uint64_t> m_messagesIn{0};
+    std::atomic<uint64_t> m_messagesOut{0};
+    std::atomic<uint64_t> m_bytesOut{0};
+};
+
+#endif // STAND_IN_SERVER_H
@@ -0,0 +1,219 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Lazily started coroutine returning T. A Task starts running when it is co_awaited (or
+// handed to syncWait/whenAll) and resumes its awaiter by symmetric transfer when it finishes.
+template <typename T = void>
+class Task;
+
+namespace task_detail {
+
+struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+        auto continuation = h.promise().continuation;
+        return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+};
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+    T take() {
+        if (exception)
+            std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void take() {
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+};
+
+// Fire-and-forget coroutine used to drive a Task from non-coroutine code.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+} // namespace task_detail
+
+template <typename T>
+class Task {
+public:
+    using promise_type = task_detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle handle) : m_handle(handle) {}
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (m_handle) m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        m_handle.promise().continuation = awaiter;
+        return m_handle;
+    }
+    T await_resume() { return m_handle.promise().take(); }
+
+private:
+    Handle m_handle;
+};
+
+namespace task_detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+template <typename T>
+Detached driveInto(Task<T> task, std::shared_ptr<std::promise<T>> result) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            result->set_value();
+        } else {
+            T value = co_await task;
+            result->set_value(std::move(value));
+        }
+    } catch (...) {
+        result->set_exception(std::current_exception());
+    }
+}
+
+} // namespace task_detail
+
+// Starts the task and returns a future for its result. The task itself continues on whatever
+// thread resumes it (typically an Executor thread).
+template <typename T>
+std::future<T> startTask(Task<T> task) {
+    auto result = std::make_shared<std::promise<T>>();
+    std::future<T> future = result->get_future();
+    task_detail::driveInto(std::move(task), result);
+    return future;
+}
+
+// Blocks the calling thread until the task finishes. Meant for main() and other
+// non-coroutine callers; coroutine code should co_await instead.
+template <typename T>
+T syncWait(Task<T> task) {
+    return startTask(std::move(task)).get();
+}
+
+namespace task_detail {
+
+template <typename T>
+struct WhenAllState {
+    std::atomic<size_t> remaining{0};
+    std::coroutine_handle<> parent;
+    std::vector<std::optional<T>> results;
+    std::exception_ptr error;
+    std::atomic<bool> errorSet{false};
+};
+
+template <typename T>
+Detached whenAllRunOne(Task<T> task, std::shared_ptr<WhenAllState<T>> state, size_t index) {
+    try {
+        T value = co_await task;
+        state->results[index].emplace(std::move(value));
+    } catch (...) {
+        if (!state->errorSet.exchange(true))
+            state->error = std::current_exception();
+    }
+    if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        state->parent.resume();
+}
+
+template <typename T>
+struct WhenAllAwaiter {
+    std::vector<Task<T>>& tasks;
+    std::shared_ptr<WhenAllState<T>> state;
+
+    bool await_ready() const noexcept { return tasks.empty(); }
+    bool await_suspend(std::coroutine_handle<> parent) {
+        state->parent = parent;
+        // One extra count held by this function so children finishing synchronously
+        // cannot resume the parent before it has actually suspended.
+        state->remaining.store(tasks.size() + 1, std::memory_order_relaxed);
+        std::shared_ptr<WhenAllState<T>> keep = state;
+        for (size_t i = 0; i < tasks.size(); ++i)
+            whenAllRunOne(std::move(tasks[i]), keep, i);
+        return keep->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+    void await_resume() {}
+};
+
+} // namespace task_detail
+
+// Runs all tasks concurrently and resumes the caller once every one of them has finished.
+// Results keep the order of the input; the first exception (if any) is rethrown.
+template <typename T>
+Task<std::vector<T>> whenAll(std::vector<Task<T>> tasks) {
+    auto state = std::make_shared<task_detail::WhenAllState<T>>();
+    state->results.resize(tasks.size());
+    // Named rather than a temporary: GCC 12 destroys aggregate temporaries in a co_await
+    // expression twice, which over-releases the shared state.
+    task_detail::WhenAllAwaiter<T> awaiter{tasks, state};
+    co_await awaiter;
+    if (state->error)
+        std::rethrow_exception(state->error);
+
+    std::vector<T> out;
+    out.reserve(state->results.size());
+    for (auto& r : state->results)
+        out.push_back(std::move(*r));
+    co_return out;
+}
+
+#endif // TASK_H
@@ -0,0 +1,46 @@
+#include "TickColumns.h"
+
+void TickColumns::reserve(size_t n, bool bidAsk, bool trades) {
+    time.reserve(n);
+    price.reserve(n);
+    size.reserve(n);
+    attribs.reserve(n);
+    if (bidAsk) {
+        askPrice.reserve(n);
+        askSize.reserve(n);
+    }
+    if (trades) {
+        exchange.reserve(n);
+        conditions.reserve(n);
+    }
+}
+
+uint16_t TickColumns::internExchange(const std::string& name) {
+    // A handful of venues per symbol, so a linear scan beats hashing.
+    for (size_t i = 0; i < exchanges.size(); ++i) {
+        if (exchanges[i] == name)
+            return static_cast<uint16_t>(i);
+    }
+    exchanges.push_back(name);
+    return static_cast<uint16_t>(exchanges.size() - 1);
+}
+
+uint32_t conditionsMask(const std::string& specialConditions) {
+    uint32_t mask = 0;
+    for (char c : specialConditions) {
+        if (c >= 'A' && c <= 'Z')
+            mask |= 1u << (c - 'A');
+        else if (c >= '4' && c <= '9')
+            mask |= 1u << (26 + (c - '4'));
+    }
+    return mask;
+}
+
+std::string conditionsString(uint32_t mask) {
+    std::string out;
+    for (int bit = 0; bit < 32; ++bit) {
+        if (mask & (1u << bit))
+            out.push_back(bit < 26 ? static_cast<char>('A' + bit) : static_cast<char>('4' + bit - 26));
+    }
+    return out;
+}
@@ -0,0 +1,40 @@
+#ifndef TICK_COLUMNS_H
+#define TICK_COLUMNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Historical ticks as parallel arrays (struct of arrays). Strings from the wire are reduced to
+// small integers as they arrive: exchanges are interned into `exchanges`, and special
+// condition codes become a bitmask (see conditionsMask), so appending a tick never allocates
+// once the columns have been reserved.
+struct TickColumns {
+    enum Attrib : uint8_t {
+        PastLimit = 1,      // TRADES: pastLimit;  BID_ASK: bidPastLow
+        Unreported = 2,     // TRADES: unreported; BID_ASK: askPastHigh
+    };
+
+    std::vector<int64_t> time;         // UTC epoch seconds
+    std::vector<double> price;         // trade price, bid (BID_ASK) or midpoint (MIDPOINT)
+    std::vector<double> size;          // trade size or bid size
+    std::vector<double> askPrice;      // BID_ASK only
+    std::vector<double> askSize;       // BID_ASK only
+    std::vector<uint16_t> exchange;    // TRADES only, index into `exchanges`
+    std::vector<uint32_t> conditions;  // TRADES only
+    std::vector<uint8_t> attribs;      // Attrib bits
+    std::vector<std::string> exchanges;
+
+    size_t count() const { return time.size(); }
+    void reserve(size_t n, bool bidAsk, bool trades);
+    // Returns the id of `name`, adding it on first sight.
+    uint16_t internExchange(const std::string& name);
+};
+
+// Condition codes are single characters: 'A'-'Z' map to bits 0-25 and '4'-'9' to bits 26-31.
+// Spaces and unknown characters are ignored.
+uint32_t conditionsMask(const std::string& specialConditions);
+std::string conditionsString(uint32_t mask);
+
+#endif // TICK_COLUMNS_H
@@ -0,0 +1,244 @@
+#include "TimeZone.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+namespace {
+
+int64_t readBigEndian(const unsigned char* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i)
+        v = (v << 8) | p[i];
+    if (bytes == 4)
+        return static_cast<int32_t>(static_cast<uint32_t>(v));
+    return static_cast<int64_t>(v);
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's days_from_civil).
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+// Local midnight (as days since epoch) of the w-th weekday d (0 = Sunday) of month m;
+// week 5 means the last one.
+int64_t nthWeekday(int64_t year, int month, int week, int weekday) {
+    const int64_t first = daysFromCivil(year, static_cast<unsigned>(month), 1);
+    const int firstWeekday = static_cast<int>(((first % 7) + 11) % 7);  // 1970-01-01 was a Thursday
+    int64_t day = first + (weekday - firstWeekday + 7) % 7 + 7 * (week - 1);
+    const int64_t nextMonth = month == 12 ? daysFromCivil(year + 1, 1, 1)
+                                          : daysFromCivil(year, static_cast<unsigned>(month + 1), 1);
+    while (day >= nextMonth)
+        day -= 7;
+    return day;
+}
+
+// [+-]hh[:mm[:ss]] in seconds.
+bool parseClock(const std::string& s, size_t& pos, int& seconds) {
+    int sign = 1;
+    if (pos < s.size() && (s[pos] == '+' || s[pos] == '-')) {
+        sign = s[pos] == '-' ? -1 : 1;
+        ++pos;
+    }
+    int parts[3] = {0, 0, 0};
+    for (int i = 0; i < 3; ++i) {
+        if (pos >= s.size() || !std::isdigit(static_cast<unsigned char>(s[pos])))
+            return i > 0;
+        int v = 0;
+        while (pos < s.size() && std::isdigit(static_cast<unsigned char>(s[pos])))
+            v = v * 10 + (s[pos++] - '0');
+        parts[i] = v;
+        seconds = sign * (parts[0] * 3600 + parts[1] * 60 + parts[2]);
+        if (pos >= s.size() || s[pos] != ':')
+            return true;
+        ++pos;
+    }
+    return true;
+}
+
+bool skipName(const std::string& s, size_t& pos) {
+    const size_t start = pos;
+    if (pos < s.size() && s[pos] == '<') {
+        pos = s.find('>', pos);
+        if (pos == std::string::npos)
+            return false;
+        ++pos;
+        return true;
+    }
+    while (pos < s.size() && std::isalpha(static_cast<unsigned char>(s[pos])))
+        ++pos;
+    return pos > start;
+}
+
+// ",Mm.w.d[/time]"
+bool parseChange(const std::string& s, size_t& pos, int& month, int& week, int& day, int& time) {
+    if (pos + 1 >= s.size() || s[pos] != ',' || s[pos + 1] != 'M')
+        return false;
+    pos += 2;
+    int* fields[3] = {&month, &week, &day};
+    for (int i = 0; i < 3; ++i) {
+        if (i > 0) {
+            if (pos >= s.size() || s[pos] != '.')
+                return false;
+            ++pos;
+        }
+        int v = 0;
+        if (pos >= s.size() || !std::isdigit(static_cast<unsigned char>(s[pos])))
+            return false;
+        while (pos < s.size() && std::isdigit(static_cast<unsigned char>(s[pos])))
+            v = v * 10 + (s[pos++] - '0');
+        *fields[i] = v;
+    }
+    time = 7200;
+    if (pos < s.size() && s[pos] == '/') {
+        ++pos;
+        return parseClock(s, pos, time);
+    }
+    return true;
+}
+
+} // namespace
+
+std::shared_ptr<const TimeZone> TimeZone::find(const std::string& name) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<const TimeZone>> zones;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = zones.find(name);
+    if (it != zones.end())
+        return it->second;
+
+    std::shared_ptr<const TimeZone> zone;
+    if (!name.empty() && name.find("..") == std::string::npos) {
+        const char* dir = std::getenv("TZDIR");
+        auto tz = std::shared_ptr<TimeZone>(new TimeZone());
+        if (tz->load(std::string(dir ? dir : "/usr/share/zoneinfo") + "/" + name))
+            zone = tz;
+    }
+    zones[name] = zone;  // unknown names are remembered too
+    return zone;
+}
+
+bool TimeZone::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    const std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < 44 || std::string(data.begin(), data.begin() + 4) != "TZif")
+        return false;
+
+    // Header: magic, version, 15 reserved bytes, then isutcnt, isstdcnt, leapcnt, timecnt,
+    // typecnt, charcnt. Version 2+ files repeat the data with 64-bit times after the first block.
+    size_t pos = 0;
+    int timeSize = 4;
+    auto counts = [&](size_t at, int64_t (&c)[6]) {
+        for (int i = 0; i < 6; ++i)
+            c[i] = readBigEndian(&data[at + 20 + 4 * i], 4);
+    };
+    int64_t c[6];
+    counts(pos, c);
+    auto blockSize = [&](int64_t (&c)[6], int ts) {
+        return static_cast<size_t>(c[3] * ts + c[3] + c[4] * 6 + c[5] + c[2] * (ts + 4) + c[1] + c[0]);
+    };
+    if (data[4] >= '2') {
+        pos = 44 + blockSize(c, 4);
+        if (data.size() < pos + 44)
+            return false;
+        counts(pos, c);
+        timeSize = 8;
+    }
+    const int64_t timecnt = c[3], typecnt = c[4];
+    size_t p = pos + 44;
+    if (typecnt <= 0 || data.size() < p + blockSize(c, timeSize))
+        return false;
+
+    const size_t times = p;
+    const size_t indices = times + static_cast<size_t>(timecnt * timeSize);
+    const size_t types = indices + static_cast<size_t>(timecnt);
+    auto typeOffset = [&](size_t type) {
+        return static_cast<int32_t>(readBigEndian(&data[types + 6 * type], 4));
+    };
+    m_initialOffset = typeOffset(0);
+    for (int64_t i = 0; i < timecnt; ++i) {
+        const size_t type = data[indices + static_cast<size_t>(i)];
+        if (type >= static_cast<size_t>(typecnt))
+            return false;
+        m_transitions.push_back(readBigEndian(&data[times + static_cast<size_t>(i * timeSize)], timeSize));
+        m_offsets.push_back(typeOffset(type));
+    }
+
+    if (timeSize == 8) {
+        const size_t footer = pos + 44 + blockSize(c, 8);
+        if (footer < data.size() && data[footer] == '\n') {
+            const auto end = std::find(data.begin() + static_cast<long>(footer) + 1, data.end(), '\n');
+            const std::string text(data.begin() + static_cast<long>(footer) + 1, end);
+            m_hasRule = !text.empty() && parseRule(text, m_rule);
+        }
+    }
+    return true;
+}
+
+bool TimeZone::parseRule(const std::string& s, Rule& rule) {
+    size_t pos = 0;
+    int seconds = 0;
+    if (!skipName(s, pos) || !parseClock(s, pos, seconds))
+        return false;
+    rule.stdOffset = -seconds;  // POSIX offsets are west of Greenwich
+    if (pos >= s.size())
+        return true;
+    if (!skipName(s, pos))
+        return false;
+    rule.hasDst = true;
+    rule.dstOffset = rule.stdOffset + 3600;
+    if (pos < s.size() && s[pos] != ',') {
+        if (!parseClock(s, pos, seconds))
+            return false;
+        rule.dstOffset = -seconds;
+    }
+    return parseChange(s, pos, rule.startMonth, rule.startWeek, rule.startDay, rule.startTime) &&
+           parseChange(s, pos, rule.endMonth, rule.endWeek, rule.endDay, rule.endTime);
+}
+
+int TimeZone::ruleOffsetAt(time_t utc) const {
+    if (!m_rule.hasDst)
+        return m_rule.stdOffset;
+    const int64_t localDays = (static_cast<int64_t>(utc) + m_rule.stdOffset) / 86400;
+    // Year of the local standard time.
+    int64_t year = 1970 + localDays / 365;
+    while (daysFromCivil(year, 1, 1) > localDays) --year;
+    while (daysFromCivil(year + 1, 1, 1) <= localDays) ++year;
+
+    // Start is given in standard time, end in daylight time.
+    const int64_t start = nthWeekday(year, m_rule.startMonth, m_rule.startWeek, m_rule.startDay) * 86400
+                        + m_rule.startTime - m_rule.stdOffset;
+    const int64_t end = nthWeekday(year, m_rule.endMonth, m_rule.endWeek, m_rule.endDay) * 86400
+                      + m_rule.endTime - m_rule.dstOffset;
+    const int64_t t = static_cast<int64_t>(utc);
+    const bool dst = start < end ? (t >= start && t < end) : !(t >= end && t < start);  // southern hemisphere
+    return dst ? m_rule.dstOffset : m_rule.stdOffset;
+}
+
+int TimeZone::offsetAt(time_t utc) const {
+    const int64_t t = static_cast<int64_t>(utc);
+    if (m_transitions.empty() || t < m_transitions.front())
+        return m_transitions.empty() && m_hasRule ? ruleOffsetAt(utc) : m_initialOffset;
+    if (m_hasRule && t >= m_transitions.back())
+        return ruleOffsetAt(utc);
+    const auto it = std::upper_bound(m_transitions.begin(), m_transitions.end(), t);
+    return m_offsets[static_cast<size_t>(it - m_transitions.begin()) - 1];
+}
+
+time_t TimeZone::toUtc(time_t local) const {
+    // Two fixed-point steps settle on the offset in force at the resulting instant.
+    const int first = offsetAt(local - offsetAt(local));
+    const int second = offsetAt(local - first);
+    return local - std::max(first, second);
+}
@@ -0,0 +1,47 @@
+#ifndef TIME_ZONE_H
+#define TIME_ZONE_H
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+// UTC offsets of an IANA time zone ("US/Eastern", "Europe/London"), read from the system's
+// compiled tz database (TZif files under /usr/share/zoneinfo or $TZDIR). TWS reports trading
+// schedules in exchange-local time; this turns them into UTC without touching the
+// process-wide TZ setting.
+class TimeZone {
+public:
+    // Loaded once per name and shared. Returns nullptr if the zone is unknown.
+    static std::shared_ptr<const TimeZone> find(const std::string& name);
+
+    // Seconds east of UTC in effect at `utc`.
+    int offsetAt(time_t utc) const;
+    // `local` is a wall-clock time encoded as if it were UTC (e.g. from timegm). In the hour
+    // skipped or repeated by a DST change the earlier offset is used.
+    time_t toUtc(time_t local) const;
+
+private:
+    // POSIX TZ rule from the TZif footer, e.g. "EST5EDT,M3.2.0,M11.1.0", for times after the
+    // last listed transition. Only the Mm.w.d form of the change dates is understood.
+    struct Rule {
+        int stdOffset = 0;
+        int dstOffset = 0;
+        bool hasDst = false;
+        int startMonth = 0, startWeek = 0, startDay = 0, startTime = 7200;
+        int endMonth = 0, endWeek = 0, endDay = 0, endTime = 7200;
+    };
+
+    bool load(const std::string& path);
+    static bool parseRule(const std::string& text, Rule& rule);
+    int ruleOffsetAt(time_t utc) const;
+
+    std::vector<int64_t> m_transitions;  // ascending UTC times
+    std::vector<int32_t> m_offsets;      // offset from each transition on
+    int32_t m_initialOffset = 0;         // before the first transition
+    Rule m_rule;
+    bool m_hasRule = false;
+};
+
+#endif // TIME_ZONE_H
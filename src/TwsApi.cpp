@@ -7,6 +7,14 @@
 #include <algorithm>  // for std::find
 #include <ctime>  // for time()
 #include <memory>
+#include <deque>
+#include <future>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cfloat>
+#include <limits>
+#include <sys/stat.h>
 
 
 
@@ -38,9 +46,56 @@ static std::string removeSpaces(const std::string& input) {
     return output;
 }
 
+// TWS sends DBL_MAX for values it has not computed (e.g. no realized P&L yet).
+static double pnlValue(double v) {
+    return v == DBL_MAX ? std::numeric_limits<double>::quiet_NaN() : v;
+}
+
+// Body of a dispatch thread: drain everything available, then wait according to the
+// configured strategy. Block parks on the queue doorbell, which the reader rings per push.
+template <typename Event, typename Apply>
+static void drainQueue(SpscQueue<Event>& queue, const std::atomic<bool>& running,
+                       const ReaderConfig& config, int cpu, Apply apply) {
+    pinCurrentThreadToCpu(cpu);
+    Event event;
+    int idleSpins = 0;
+    while (running.load(std::memory_order_acquire)) {
+        bool didWork = false;
+        while (queue.tryPop(event)) {
+            apply(event);
+            didWork = true;
+        }
+        if (didWork) {
+            idleSpins = 0;
+            continue;
+        }
+        switch (config.waitStrategy) {
+            case WaitStrategy::Block: {
+                uint32_t seen = queue.doorbell();
+                if (queue.empty() && running.load(std::memory_order_acquire))
+                    queue.waitForRing(seen);
+                break;
+            }
+            case WaitStrategy::SpinYield:
+                if (++idleSpins < config.spinIterations) {
+                    cpuRelax();
+                } else {
+                    idleSpins = 0;
+                    std::this_thread::yield();
+                }
+                break;
+            case WaitStrategy::BusyPoll:
+                cpuRelax();
+                break;
+        }
+    }
+    while (queue.tryPop(event)) // flush whatever the reader pushed before shutdown
+        apply(event);
+}
+
 // Constructor: create the EClientSocket instance and initialize the order counter.
 TwsApi::TwsApi() : m_client(nullptr), m_signal(nullptr), m_nextOrderId(0) {
-    m_signal = new EReaderOSSignal(1000);  // Create a signal with a 1000 ms timeout
+    m_signal = new ReaderSignal(1000);  // Create a signal with a 1000 ms timeout
     m_client = new EClientSocket(this, m_signal);  // Pass the signal to the client socket
 }
 
@@ -50,25 +105,56 @@ TwsApi::~TwsApi() {
 }
 
 bool TwsApi::connect(const std::string& host, int port, int clientId) {
+    if (m_client->isConnected()) {
+        // The reader thread only exits when the connection drops; joining it here would hang.
+        std::cerr << "error at connect: already connected, disconnect first" << std::endl;
+        return true;
+    }
+    startDispatchThreads();
     bool connected = m_client->eConnect(host.c_str(), port, clientId);
     if (connected) {
         // Create and start the EReader for asynchronous message processing.
+        // EReader owns its socket thread internally, so only our processing thread can be pinned.
         EReader* reader = new EReader(m_client, m_signal);
         reader->start();
 
         // Launch a thread that processes incoming messages.
-        std::thread readerThread([this, reader]() {
+        if (m_readerThread.joinable())
+            m_readerThread.join();
+        m_readerThread = std::thread([this, reader, config = m_activeReaderConfig]() {
+            pinCurrentThreadToCpu(config.readerCpu);
+            const WaitStrategy strategy = config.waitStrategy;
+            const int spinIterations = config.spinIterations;
             while (m_client->isConnected()) {
-                m_signal->waitForSignal();
-                reader->processMsgs();
+                switch (strategy) {
+                    case WaitStrategy::Block:
+                        m_signal->waitForSignal();
+                        reader->processMsgs();
+                        m_linkMonitor.noteReaderActivity();
+                        break;
+                    case WaitStrategy::SpinYield:
+                        for (int i = 0; i < spinIterations; ++i)
+                            reader->processMsgs();
+                        m_linkMonitor.noteReaderActivity();
+                        std::this_thread::yield();
+                        break;
+                    case WaitStrategy::BusyPoll:
+                        reader->processMsgs();
+                        m_linkMonitor.noteReaderActivity();
+                        break;
+                }
             }
             delete reader; // Clean up when disconnected.
         });
-        readerThread.detach();
 
         // Wait for the nextValidId callback to set m_nextOrderId.
         std::unique_lock<std::mutex> lock(m_mutex);
         m_cond.wait_for(lock, std::chrono::seconds(2));
+        lock.unlock();
+
+        m_linkMonitor.start(m_linkMonitorConfig);
+    } else {
+        stopDispatchThreads(); // nothing to dispatch, and setReaderConfig may apply again
     }
     return connected;
 }
@@ -76,8 +162,391 @@ bool TwsApi::connect(const std::string& host, int port, int clientId) {
 
 
 void TwsApi::disconnect() {
+    m_linkMonitor.stop(); // no probes on a closing socket
+    for (int reqId : m_historicalPacer.cancelAll())
+        m_requests.fail(reqId, "disconnected before the request was sent");
     if(m_client)
         m_client->eDisconnect();
+    if (m_readerThread.joinable() && m_readerThread.get_id() != std::this_thread::get_id()) {
+        m_signal->issueSignal(); // wake a blocked reader so it sees the disconnect
+        m_readerThread.join();
+    }
+    stopDispatchThreads();
+
+    // The position subscription ended with the connection; reload on the next request.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_positionsLoaded = false;
+        m_positionsSubscribed = false;
+        m_positions.clear();
+        m_positionsBySymbol.clear();
+        m_accountUpdatesSubscribed = false;
+        m_accountUpdatesLoaded = false;
+        m_pnlSubscribed = false;
+        m_pnlLines.clear();
+        m_pnlLineIds.clear();
+        m_pnl.clear();
+    }
+    m_accountState.setStreaming(false, "");
+    std::lock_guard<std::mutex> lock(m_tickMutex);
+    m_greeks.clearPositions();
+}
+
+// The running threads work from the copy taken when they started, so changing strategies
+// underneath them (e.g. leaving Block while they are parked on a doorbell) is refused.
+void TwsApi::setReaderConfig(const ReaderConfig& config) {
+    if (m_dispatchRunning.load(std::memory_order_acquire)) {
+        std::cerr << "error at setReaderConfig: cannot change while connected, disconnect first" << std::endl;
+        return;
+    }
+    m_readerConfig = config;
+}
+
+void TwsApi::setBarCacheDirectory(const std::string& directory) {
+    m_barCache = directory.empty() ? nullptr : std::make_unique<BarCache>(directory);
+}
+
+void TwsApi::setOptionChainCacheDirectory(const std::string& directory) {
+    if (!directory.empty())
+        ::mkdir(directory.c_str(), 0755);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_optionChainDirectory = directory;
+}
+
+void TwsApi::setLinkMonitorConfig(const LinkMonitorConfig& config) {
+    m_linkMonitorConfig = config;
+}
+
+LinkStats TwsApi::getLinkStats() const {
+    return m_linkMonitor.stats();
+}
+
+// --- Event Dispatch ---
+
+void TwsApi::startDispatchThreads() {
+    if (m_dispatchRunning.exchange(true))
+        return;
+    // Fixed until the threads stop: the reader thread and pushes read this copy only.
+    m_activeReaderConfig = m_readerConfig;
+    auto cpuFor = [this](size_t domain) {
+        const auto& cpus = m_activeReaderConfig.dispatchCpus;
+        return domain < cpus.size() ? cpus[domain] : -1;
+    };
+    m_dispatchThreads.emplace_back([this, config = m_activeReaderConfig, cpu = cpuFor(0)]() {
+        drainQueue(m_marketDataQueue, m_dispatchRunning, config, cpu,
+                   [this](const MarketDataEvent& e) { applyMarketDataEvent(e); });
+    });
+    m_dispatchThreads.emplace_back([this, config = m_activeReaderConfig, cpu = cpuFor(1)]() {
+        drainQueue(m_orderQueue, m_dispatchRunning, config, cpu,
+                   [this](const OrderEvent& e) { applyOrderEvent(e); });
+    });
+    m_dispatchThreads.emplace_back([this, config = m_activeReaderConfig, cpu = cpuFor(2)]() {
+        drainQueue(m_accountQueue, m_dispatchRunning, config, cpu,
+                   [this](const AccountEvent& e) { applyAccountEvent(e); });
+    });
+    m_dispatchThreads.emplace_back([this, config = m_activeReaderConfig, cpu = cpuFor(3)]() {
+        drainQueue(m_historicalQueue, m_dispatchRunning, config, cpu,
+                   [this](const HistoricalEvent& e) { applyHistoricalEvent(e); });
+    });
+}
+
+void TwsApi::stopDispatchThreads() {
+    if (!m_dispatchRunning.exchange(false))
+        return;
+    // Wake consumers parked on their doorbells so they observe the stop flag.
+    m_marketDataQueue.ring();
+    m_orderQueue.ring();
+    m_accountQueue.ring();
+    m_historicalQueue.ring();
+    for (auto& t : m_dispatchThreads) {
+        if (t.joinable())
+            t.join();
+    }
+    m_dispatchThreads.clear();
+}
+
+// Market data is the only lossy domain: a stale tick is better than stalling the reader.
+void TwsApi::pushMarketDataEvent(MarketDataEvent&& event) {
+    if (!m_marketDataQueue.tryPush(std::move(event))) {
+        m_marketDataQueue.countDrop();
+        return;
+    }
+    if (m_activeReaderConfig.waitStrategy == WaitStrategy::Block)
+        m_marketDataQueue.ring();
+}
+
+// Pushes onto a queue whose events must not be lost (orders, account, historical).
+// The reader thread waits for room instead of dropping, unless dispatch has been stopped.
+template <typename Event>
+void TwsApi::pushLossless(SpscQueue<Event>& queue, Event&& event) {
+    while (!queue.tryPush(std::move(event))) {
+        if (!m_dispatchRunning.load(std::memory_order_acquire)) {
+            queue.countDrop();
+            return;
+        }
+        queue.countFullWait();
+        std::this_thread::yield();
+    }
+    if (m_activeReaderConfig.waitStrategy == WaitStrategy::Block)
+        queue.ring();
+}
+
+std::vector<QueueStats> TwsApi::getQueueStats() const {
+    auto stats = [](const std::string& domain, const auto& queue) {
+        QueueStats s;
+        s.domain = domain;
+        s.depth = queue.size();
+        s.capacity = queue.capacity();
+        s.pushed = queue.pushed();
+        s.dropped = queue.dropped();
+        s.fullWaits = queue.fullWaits();
+        return s;
+    };
+    return {
+        stats("market_data", m_marketDataQueue),
+        stats("orders", m_orderQueue),
+        stats("account", m_accountQueue),
+        stats("historical", m_historicalQueue),
+    };
+}
+
+void TwsApi::applyMarketDataEvent(const MarketDataEvent& event) {
+    std::lock_guard<std::mutex> lock(m_tickMutex);
+    switch (event.type) {
+        case MarketDataEventType::Price: {
+            auto symbolIt = m_tickerIdToSymbol.find(event.tickerId);
+            if (symbolIt != m_tickerIdToSymbol.end()) {
+                Quote& quote = m_quotes[event.tickerId];
+                quote.symbol = symbolIt->second;
+                quote.timestamp = event.time;
+
+                if (event.field == BID)
+                    quote.bid_price = event.price;
+                else if (event.field == ASK)
+                    quote.ask_price = event.price;
+                else if (event.field == LAST)
+                    quote.last_price = event.price;
+                else if (event.field == CLOSE)
+                    quote.close_price = event.price;
+            }
+            // Only tickers of an outstanding getOptionQuote have an entry; others are not added.
+            auto optionIt = m_optionQuotes.find(event.tickerId);
+            if (optionIt != m_optionQuotes.end()) {
+                if (event.field == BID) optionIt->second.bidPrice = event.price;
+                else if (event.field == ASK) optionIt->second.ask_price = event.price;
+            }
+            break;
+        }
+        case MarketDataEventType::Size:
+            if (event.field == OPTION_CALL_OPEN_INTEREST || event.field == OPTION_PUT_OPEN_INTEREST ||
+                event.field == 100 || event.field == 101) {
+                auto optionIt = m_optionQuotes.find(event.tickerId);
+                if (optionIt != m_optionQuotes.end())
+                    optionIt->second.volume = event.size;
+            }
+            break;
+        case MarketDataEventType::OptionComputation: {
+            const int source = greekSourceOf(event.field);
+            if (source >= 0) {
+                long row = m_greeks.row(static_cast<int>(event.tickerId));
+                if (row < 0) {
+                    auto symbolIt = m_tickerIdToSymbol.find(event.tickerId);
+                    row = static_cast<long>(m_greeks.addTicker(static_cast<int>(event.tickerId),
+                        symbolIt != m_tickerIdToSymbol.end() ? symbolIt->second : std::string()));
+                }
+                m_greeks.update(static_cast<size_t>(row), static_cast<GreekSource>(source), event.computation, event.time);
+            }
+            if (source == static_cast<int>(GreekSource::Model) && !m_volSurfaceFeeds.empty()) {
+                auto feedIt = m_volSurfaceFeeds.find(static_cast<int>(event.tickerId));
+                if (feedIt != m_volSurfaceFeeds.end()) {
+                    if (event.computation.impliedVol != DBL_MAX)
+                        feedIt->second.surface->update(feedIt->second.slot, event.computation.impliedVol);
+                    if (event.computation.undPrice != DBL_MAX)
+                        feedIt->second.surface->setSpot(event.computation.undPrice);
+                }
+            }
+            auto optionIt = m_optionQuotes.find(event.tickerId);
+            if (optionIt != m_optionQuotes.end())
+                optionIt->second.impliedVolatility = event.computation.impliedVol;
+            break;
+        }
+        case MarketDataEventType::SnapshotEnd:
+            m_requests.complete(static_cast<int>(event.tickerId));
+            break;
+        case MarketDataEventType::TickByTickLast: {
+            Trade trade;
+            auto it = m_tickerIdToSymbol.find(event.tickerId);
+            trade.symbol = (it != m_tickerIdToSymbol.end()) ? it->second : "UNKNOWN";
+            trade.trade_price = event.price;
+            trade.timestamp = event.time;
+            trade.size = static_cast<int>(event.size);
+            trade.tickType = event.field;
+            m_latestTrades.push_back(trade);
+            break;
+        }
+        case MarketDataEventType::TickByTickBidAsk: {
+            Quote quote{};
+            auto it = m_tickerIdToSymbol.find(event.tickerId);
+            quote.symbol = (it != m_tickerIdToSymbol.end()) ? it->second : "UNKNOWN";
+            quote.bid_price = event.price;
+            quote.ask_price = event.askPrice;
+            quote.timestamp = event.time;
+            quote.bidSize = static_cast<int>(event.size);
+            quote.askSize = static_cast<int>(event.askSize);
+            m_latestQuotes.push_back(quote);
+            break;
+        }
+    }
+
+    if (!m_optionSnapshots.empty()) {
+        auto it = m_optionSnapshots.find(static_cast<int>(event.tickerId));
+        if (it != m_optionSnapshots.end()) {
+            applyOptionSnapshotEvent(*it->second.out, event);
+            if ((it->second.out->fields & it->second.required) == it->second.required)
+                m_requests.complete(it->first);
+        }
+    }
+
+    if (!m_pendingOptionQuotes.empty() && m_pendingOptionQuotes.count(static_cast<int>(event.tickerId))) {
+        const OptionQuote& quote = m_optionQuotes[event.tickerId];
+        if (quote.bidPrice > 0 && quote.ask_price > 0 && quote.impliedVolatility > 0) {
+            m_pendingOptionQuotes.erase(static_cast<int>(event.tickerId));
+            m_requests.complete(static_cast<int>(event.tickerId));
+        }
+    }
+}
+
+void TwsApi::applyOrderEvent(const OrderEvent& event) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (event.type == OrderEventType::OpenOrder) {
+        m_orders[event.order.orderId] = event.order;
+    } else {
+        auto it = m_orders.find(event.order.orderId);
+        if (it != m_orders.end()) {
+            it->second.status = event.order.status;
+            it->second.linkRttUs = m_linkMonitor.lastRttUs();
+        }
+    }
+}
+
+void TwsApi::applyAccountEvent(const AccountEvent& event) {
+    switch (event.type) {
+        case AccountEventType::Position: {
+            const Position& p = event.position;
+            int symbolQty = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                const PositionKey key{p.conId, p.account};
+                auto it = m_positions.find(key);
+                if (p.qty == 0) {
+                    if (it != m_positions.end()) {
+                        auto [first, last] = m_positionsBySymbol.equal_range(it->second.symbol);
+                        for (auto s = first; s != last; ++s) {
+                            if (s->second == key) {
+                                m_positionsBySymbol.erase(s);
+                                break;
+                            }
+                        }
+                        m_positions.erase(it);
+                    }
+                } else if (it == m_positions.end()) {
+                    m_positions.emplace(key, p);
+                    m_positionsBySymbol.emplace(p.symbol, key);
+                } else {
+                    it->second = p;
+                }
+                updatePnlLine(p);
+                symbolQty = symbolPositionLocked(p.symbol);
+            }
+            // Exposure is per symbol, summed over the accounts.
+            std::lock_guard<std::mutex> lock(m_tickMutex);
+            m_greeks.setPosition(p.symbol, event.underlying, symbolQty, event.multiplier, event.option);
+            break;
+        }
+        case AccountEventType::Summary: {
+            std::lock_guard<std::mutex> lock(m_accountMutex);
+            m_accountValues[event.tag] = event.value;
+            break;
+        }
+        case AccountEventType::SummaryEnd:
+            m_requests.complete(event.reqId);
+            break;
+        case AccountEventType::PositionEnd: {
+            std::vector<int> waiting;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_positionsLoaded = true;
+                waiting.swap(m_positionRequests);
+            }
+            for (int reqId : waiting)
+                m_requests.complete(reqId);
+            break;
+        }
+        case AccountEventType::Value:
+            m_accountState.setValue(event.tag, event.value, event.currency, event.account);
+            break;
+        case AccountEventType::Portfolio:
+            m_accountState.setPortfolio(event.row, event.account);
+            break;
+        case AccountEventType::Time:
+            m_accountState.setTime(event.tag);
+            break;
+        case AccountEventType::DownloadEnd: {
+            std::vector<int> waiting;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_accountUpdatesSubscribed)
+                    break;  // unsubscribed meanwhile
+                m_accountUpdatesLoaded = true;
+                waiting.swap(m_accountUpdateRequests);
+            }
+            m_accountState.setStreaming(true, event.account);
+            for (int reqId : waiting)
+                m_requests.complete(reqId);
+            break;
+        }
+        // The subscription state and the table generation are read together under m_mutex, and
+        // unsubscribe_pnl clears the table under it, so an update that raced an unsubscribe is
+        // dropped by the table instead of bringing a row back.
+        case AccountEventType::Pnl: {
+            bool current = false;
+            uint64_t generation = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                current = m_pnlSubscribed && event.reqId == m_pnlAccountReqId;
+                generation = m_pnl.generation();
+            }
+            if (current)
+                m_pnl.setAccount(generation, event.pnl);
+            break;
+        }
+        case AccountEventType::PnlSingle: {
+            PnlLine line;
+            uint64_t generation = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_pnlLines.find(event.reqId);
+                if (it != m_pnlLines.end())
+                    line = it->second;
+                generation = m_pnl.generation();
+            }
+            if (line.conId != 0)  // else cancelled meanwhile
+                m_pnl.setPosition(generation, line.symbol, line.conId, event.row.position, event.row.marketValue,
+                                  event.pnl);
+            break;
+        }
+    }
+}
+
+void TwsApi::applyHistoricalEvent(const HistoricalEvent& event) {
+    if (applyLiveBarEvent(event))
+        return;
+    if (event.type == HistoricalEventType::Bar) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_historicalData[event.reqId].push_back(event.bar);
+    } else {
+        m_requests.complete(event.reqId);
+    }
 }
 
 // --- Order Functions ---
@@ -87,7 +556,16 @@ OrderResult TwsApi::submit_order_stock(const std::string& symbol, int qty, const
     double limit_price, double stop_price, const std::string& client_order_id,
     double bracket_take_profit_price, double bracket_stop_loss_price, bool is_bracket)
 {
-    Contract contract = createStockContract(symbol);
+    if (!roundOrderPrices(symbol, side == "buy" || side == "BUY", limit_price, stop_price,
+                          bracket_take_profit_price, bracket_stop_loss_price)) {
+        std::cerr << "error at submit_order_stock: " << symbol << ": price increment unknown, order not sent" << std::endl;
+        OrderResult result;
+        result.status = "UnknownPriceIncrement";
+        result.symbol = symbol;
+        result.assetType = "STK";
+        return result;
+    }
+    Contract contract = *stockContract(symbol);
 
     Order parent;
     parent.action = (side == "buy" || side == "BUY") ? "BUY" : "SELL";
@@ -117,7 +595,7 @@ OrderResult TwsApi::submit_order_stock(const std::string& symbol, int qty, const
     }
     parent.orderId = parentOrderId;
 
-    m_client->placeOrder(parentOrderId, contract, parent);
+    pacedClient()->placeOrder(parentOrderId, contract, parent);
 
     if (is_bracket) {
         Order takeProfit;
@@ -142,8 +620,8 @@ OrderResult TwsApi::submit_order_stock(const std::string& symbol, int qty, const
             slOrderId = m_nextOrderId++;
         }
 
-        m_client->placeOrder(tpOrderId, contract, takeProfit);
-        m_client->placeOrder(slOrderId, contract, stopLoss);
+        pacedClient()->placeOrder(tpOrderId, contract, takeProfit);
+        pacedClient()->placeOrder(slOrderId, contract, stopLoss);
 
         parent.transmit = false;
     }
@@ -170,7 +648,32 @@ OrderResult TwsApi::submit_order_option(const std::string& symbol, int qty, cons
     double limit_price, double stop_price, const std::string& client_order_id,
     double bracket_take_profit_price, double bracket_stop_loss_price, bool is_bracket)
 {
-    Contract contract = createOptionContract(symbol);
+    OccSymbol occ;
+    if (!parseOccSymbol(symbol, occ)) {
+        std::cerr << "error at submit_order_option: invalid OCC symbol " << symbol << std::endl;
+        OrderResult result;
+        result.status = "InvalidSymbol";
+        result.symbol = symbol;
+        result.assetType = "OPT";
+        return result;
+    }
+    if (!roundOrderPrices(symbol, side == "buy" || side == "BUY", limit_price, stop_price,
+                          bracket_take_profit_price, bracket_stop_loss_price)) {
+        std::cerr << "error at submit_order_option: " << symbol << ": price increment unknown, order not sent" << std::endl;
+        OrderResult result;
+        result.status = "UnknownPriceIncrement";
+        result.symbol = symbol;
+        result.assetType = "OPT";
+        return result;
+    }
+    std::shared_ptr<const Contract> contract = optionContract(symbol);
+    if (!contract) {
+        OrderResult result;
+        result.status = "InvalidSymbol";
+        result.symbol = symbol;
+        result.assetType = "OPT";
+        return result;
+    }
 
     Order parent;
     parent.action = (side == "buy" || side == "BUY") ? "BUY" : "SELL";
@@ -200,7 +703,7 @@ OrderResult TwsApi::submit_order_option(const std::string& symbol, int qty, cons
     }
 
     parent.orderId = parentOrderId;
-    m_client->placeOrder(parentOrderId, contract, parent);
+    pacedClient()->placeOrder(parentOrderId, *contract, parent);
 
     if (is_bracket) {
         Order takeProfit;
@@ -225,8 +728,8 @@ OrderResult TwsApi::submit_order_option(const std::string& symbol, int qty, cons
             slOrderId = m_nextOrderId++;
         }
 
-        m_client->placeOrder(tpOrderId, contract, takeProfit);
-        m_client->placeOrder(slOrderId, contract, stopLoss);
+        pacedClient()->placeOrder(tpOrderId, *contract, takeProfit);
+        pacedClient()->placeOrder(slOrderId, *contract, stopLoss);
     }
 
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -312,8 +815,11 @@ std::vector<OrderResult> TwsApi::list_orders(const std::string& /*status*/, int
 void TwsApi::reqAllOpenOrders()
 {
     if (m_client) {
-        m_orders.clear();
-        m_client->reqAllOpenOrders();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_orders.clear();
+        }
+        pacedClient()->reqAllOpenOrders();
     } else {
         std::cerr << "error at reqAllOpenOrders" << std::endl;
     }
@@ -323,30 +829,257 @@ void TwsApi::openOrderEnd(){}
 
 void TwsApi::cancel_order(OrderId order_id) {
     OrderCancel orderCancel;
-    m_client->cancelOrder(order_id, orderCancel);
+    pacedClient()->cancelOrder(order_id, orderCancel);
     std::unique_lock<std::mutex> lock(m_mutex);
 }
 
 // --- Position Functions ---
 
+// reqPositions has no request id, so each caller registers its own id and positionEnd
+// completes all of them at once.
+// Queues reqId for the next positionEnd. False if the positions are loaded already; sets
+// `subscribe` if the caller has to send reqPositions (the first request, or after a failure).
+bool TwsApi::beginPositionsRequest(int reqId, bool& subscribe) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_positionsLoaded)
+        return false;
+    m_positionRequests.push_back(reqId);
+    subscribe = !m_positionsSubscribed;
+    m_positionsSubscribed = true;
+    return true;
+}
+
+std::vector<Position> TwsApi::finishPositionsRequest(const RequestResult& status) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!status.ok() && !m_positionsLoaded) {
+        std::cerr << "error at list_positions: " << status.message << std::endl;
+        pacedClient()->cancelPositions();  // the next call subscribes again
+        m_positionsSubscribed = false;
+    }
+    return positionsLocked();
+}
+
+// Called with m_mutex held.
+std::vector<Position> TwsApi::positionsLocked() const {
+    std::vector<Position> positions;
+    positions.reserve(m_positions.size());
+    for (const auto& [key, position] : m_positions)
+        positions.push_back(position);
+    std::sort(positions.begin(), positions.end(), [](const Position& a, const Position& b) {
+        return a.symbol != b.symbol ? a.symbol < b.symbol : a.account < b.account;
+    });
+    return positions;
+}
+
+// Called with m_mutex held. Net quantity of `symbol` over all accounts.
+int TwsApi::symbolPositionLocked(const std::string& symbol) const {
+    int qty = 0;
+    auto [first, last] = m_positionsBySymbol.equal_range(symbol);
+    for (auto it = first; it != last; ++it)
+        qty += m_positions.at(it->second).qty;
+    return qty;
+}
+
 std::vector<Position> TwsApi::list_positions() {
-    m_positions.clear();
-    m_client->reqPositions();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    std::unique_lock<std::mutex> lock(m_mutex);
-    return m_positions;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_positionsLoaded)
+            return positionsLocked();
+    }
+    const int reqId = m_requests.nextId();
+    auto done = m_requests.track(reqId, kRequestTimeout);
+    bool subscribe = false;
+    if (!beginPositionsRequest(reqId, subscribe))
+        m_requests.complete(reqId);  // loaded meanwhile
+    else if (subscribe)
+        pacedClient()->reqPositions();
+    return finishPositionsRequest(done.get());
+}
+
+bool TwsApi::ensurePositionsLoaded() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_positionsLoaded)
+            return true;
+    }
+    list_positions();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_positionsLoaded;
 }
 
-Position TwsApi::get_position(const std::string& symbol) {
-    auto positions = list_positions();
-    for(const auto& pos : positions) {
-        if(pos.symbol == symbol)
-            return pos;
+Position TwsApi::get_position(const std::string& symbol, const std::string& account) {
+    ensurePositionsLoaded();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Position* found = nullptr;
+    auto [first, last] = m_positionsBySymbol.equal_range(symbol);
+    for (auto it = first; it != last; ++it) {
+        auto row = m_positions.find(it->second);
+        if (row == m_positions.end())
+            continue;
+        const std::string& rowAccount = row->first.second;
+        if (account.empty() ? (!found || rowAccount < found->account) : rowAccount == account)
+            found = &row->second;
     }
+    if (found)
+        return *found;
     std::cerr << "error at get_position: " << symbol << " not found" <<  std::endl;
     return Position {};
 }
 
+Position TwsApi::get_position_by_conid(long conId, const std::string& account) {
+    ensurePositionsLoaded();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Keys sort by conId, then account: the first row at or after (conId, account).
+    auto it = m_positions.lower_bound(PositionKey{conId, account});
+    if (it != m_positions.end() && it->first.first == conId && (account.empty() || it->first.second == account))
+        return it->second;
+    std::cerr << "error at get_position_by_conid: " << conId << " not found" <<  std::endl;
+    return Position {};
+}
+
+// --- P&L ---
+
+bool TwsApi::subscribe_pnl(const std::string& account) {
+    if (!ensurePositionsLoaded()) {
+        std::cerr << "error at subscribe_pnl: positions not available" << std::endl;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pnlSubscribed)
+        return true;
+    m_pnlAccount = account.empty() ? m_managedAccount : account;
+    if (m_pnlAccount.empty()) {
+        // reqPnL needs an account code; managedAccounts arrives shortly after connecting.
+        std::cerr << "error at subscribe_pnl: no account (managed accounts not received yet)" << std::endl;
+        return false;
+    }
+    m_pnlSubscribed = true;
+    m_pnlAccountReqId = m_requests.nextId();
+    pacedClient()->reqPnL(m_pnlAccountReqId, m_pnlAccount, "");
+    for (const auto& [key, position] : m_positions)
+        updatePnlLine(position);
+    return true;
+}
+
+void TwsApi::unsubscribe_pnl() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pnlSubscribed)
+        cancelPnlLocked();
+}
+
+// Called with m_mutex held.
+void TwsApi::cancelPnlLocked() {
+    m_pnlSubscribed = false;
+    pacedClient()->cancelPnL(m_pnlAccountReqId);
+    for (const auto& [reqId, line] : m_pnlLines)
+        pacedClient()->cancelPnLSingle(reqId);
+    m_pnlLines.clear();
+    m_pnlLineIds.clear();
+    m_pnl.clear();
+}
+
+// TWS rejected a P&L line (e.g. unknown account or conId). These ids are not tracked by the
+// registry, so error() hands them here. A failed account line ends the whole subscription, so
+// the next subscribe_pnl starts over; a failed position line just drops that row.
+bool TwsApi::failPnlLine(int reqId, const std::string& message) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_pnlSubscribed)
+        return false;
+    if (reqId == m_pnlAccountReqId) {
+        std::cerr << "error at subscribe_pnl: " << m_pnlAccount << ": " << message << std::endl;
+        cancelPnlLocked();
+        return true;
+    }
+    auto it = m_pnlLines.find(reqId);
+    if (it == m_pnlLines.end())
+        return false;
+    std::cerr << "error at subscribe_pnl: " << it->second.symbol << ": " << message << std::endl;
+    m_pnl.removePosition(it->second.symbol);
+    m_pnlLineIds.erase(it->second.conId);
+    m_pnlLines.erase(it);
+    return true;
+}
+
+// Called with m_mutex held, for every position change: opens a pnlSingle line for a new
+// position and cancels the line (and drops the row) of a closed one. Sent under the lock so
+// a subscribe and a close of the same position cannot pass each other.
+void TwsApi::updatePnlLine(const Position& position) {
+    // pnlSingle lines are per account: only the subscribed account's positions get one.
+    if (!m_pnlSubscribed || position.conId == 0 || position.account != m_pnlAccount)
+        return;
+    auto it = m_pnlLineIds.find(position.conId);
+    if (position.qty != 0) {
+        if (it != m_pnlLineIds.end())
+            return;
+        const int reqId = m_requests.nextId();
+        m_pnlLineIds[position.conId] = reqId;
+        m_pnlLines[reqId] = PnlLine{position.conId, position.symbol};
+        pacedClient()->reqPnLSingle(reqId, m_pnlAccount, "", static_cast<int>(position.conId));
+    } else if (it != m_pnlLineIds.end()) {
+        pacedClient()->cancelPnLSingle(it->second);
+        m_pnlLines.erase(it->second);
+        m_pnlLineIds.erase(it);
+        m_pnl.removePosition(position.symbol);
+    }
+}
+
+// --- Account Updates ---
+
+// Like reqPositions, reqAccountUpdates has no request id: callers queue their own ids and
+// accountDownloadEnd completes all of them.
+bool TwsApi::subscribe_account_updates(const std::string& account) {
+    const int reqId = m_requests.nextId();
+    auto done = m_requests.track(reqId, kRequestTimeout);
+    std::string target;
+    bool subscribe = false, loaded = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        target = account.empty() ? m_managedAccount : account;
+        if (!m_accountUpdatesSubscribed || m_accountUpdatesAccount != target) {
+            // TWS streams one account at a time; subscribing another one replaces it.
+            subscribe = true;
+            m_accountUpdatesSubscribed = true;
+            m_accountUpdatesLoaded = false;
+            m_accountUpdatesAccount = target;
+            m_accountState.reset(target);
+        }
+        loaded = m_accountUpdatesLoaded;
+        if (!loaded)
+            m_accountUpdateRequests.push_back(reqId);
+    }
+    if (loaded)
+        m_requests.complete(reqId);
+    else if (subscribe)
+        pacedClient()->reqAccountUpdates(true, target);
+
+    RequestResult status = done.get();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!status.ok() && !m_accountUpdatesLoaded && m_accountUpdatesAccount == target) {
+        std::cerr << "error at subscribe_account_updates: " << status.message << std::endl;
+        pacedClient()->reqAccountUpdates(false, target);  // the next call subscribes again
+        m_accountUpdatesSubscribed = false;
+    }
+    return m_accountUpdatesLoaded && m_accountUpdatesAccount == target;
+}
+
+void TwsApi::unsubscribe_account_updates() {
+    std::string account;
+    std::vector<int> waiting;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_accountUpdatesSubscribed)
+            return;
+        account = m_accountUpdatesAccount;
+        m_accountUpdatesSubscribed = false;
+        m_accountUpdatesLoaded = false;
+        waiting.swap(m_accountUpdateRequests);
+    }
+    pacedClient()->reqAccountUpdates(false, account);
+    m_accountState.setStreaming(false, account);
+    for (int reqId : waiting)
+        m_requests.fail(reqId, "account updates cancelled");
+}
+
 // --- Order Modification and Query ---
 
 OrderResult TwsApi::change_order_by_order_id(OrderId order_id,
@@ -375,6 +1108,9 @@ OrderResult TwsApi::change_order_by_order_id(OrderId order_id,
     // Update only specified fields, retain original if not provided.
     parentOrder.lmtPrice = limit_price.value_or(orig.limit_price);
     parentOrder.auxPrice = stop_price.value_or(orig.stop_price);
+    parentOrder.lmtPrice = roundOrderPrice(orig.symbol, parentOrder.lmtPrice,
+        orig.side == "BUY" ? PriceRounding::Down : PriceRounding::Up);
+    parentOrder.auxPrice = roundOrderPrice(orig.symbol, parentOrder.auxPrice, PriceRounding::Nearest);
 
     if (parentOrder.lmtPrice != 0.0 && parentOrder.auxPrice != 0.0)
         parentOrder.orderType = "STP LMT";
@@ -390,16 +1126,24 @@ OrderResult TwsApi::change_order_by_order_id(OrderId order_id,
 
     // Recreate the appropriate contract based on the original order's asset type.
     Contract contract;
-    if(orig.assetType == "OPT")
-        contract = createOptionContract(orig.symbol);
-    else
-        contract = createStockContract(orig.symbol);
+    if(orig.assetType == "OPT") {
+        std::shared_ptr<const Contract> option = optionContract(orig.symbol);
+        if (!option) {
+            OrderResult res;
+            res.orderId = order_id;
+            res.status = "InvalidSymbol";
+            return res;
+        }
+        contract = *option;
+    } else {
+        contract = *stockContract(orig.symbol);
+    }
 
     // Explicitly set the transmit flag.
     parentOrder.transmit = true;
 
     // Modify the order in TWS.
-    m_client->placeOrder(order_id, contract, parentOrder);
+    pacedClient()->placeOrder(order_id, contract, parentOrder);
 
     // Update local record to reflect modification.
     orig.qty = parentOrder.totalQuantity;
@@ -417,12 +1161,33 @@ OrderResult TwsApi::change_order_by_order_id(OrderId order_id,
 
 // --- Historical Data ---
 
-std::vector<HistoricalBar> TwsApi::get_historical_data_stocks(const std::string& symbol,
+BarSeries TwsApi::get_historical_data_stocks(const std::string& symbol,
     const std::string& start, const std::string& end, int limit)
 {
-    Contract contract = createStockContract(symbol);
-    int reqId = std::hash<std::string>{}(symbol) % 10000;
+    if (!start.empty()) {
+        HistoricalQuery query;
+        query.symbol = symbol;
+        query.barSize = "1 day";
+        query.start = parseIbDateTime(start);
+        query.end = end.empty() ? std::time(nullptr) : parseIbDateTime(end);
+        if (query.start < 0 || query.end < 0) {
+            std::cerr << "error at get_historical_data_stocks: bad date range " << start << " - " << end << std::endl;
+            return {};
+        }
+        BarSeries bars = get_historical_range(query).bars;
+        bars.truncate(static_cast<size_t>(std::max(0, limit)));
+        return bars;
+    }
 
+    Contract contract = *stockContract(symbol);
+    int reqId = m_requests.nextId();
+
+    auto done = m_requests.track(reqId, kPacedHistoricalTimeout);
+    sendHistoricalRequest(reqId, contract, end);
+    return finishHistoricalRequest(reqId, symbol, done.get(), limit);
+}
+
+void TwsApi::sendHistoricalRequest(int reqId, const Contract& contract, const std::string& end) {
     // IB expects datetime format "YYYYMMDD HH:mm:ss" in GMT
     const std::string& endDateTime = end;  // Example: "20250324 16:00:00"
     std::string durationStr = "1 D";
@@ -431,19 +1196,642 @@ std::vector<HistoricalBar> TwsApi::get_historical_data_stocks(const std::string&
     int useRTH = 1;
     int formatDate = 1;
 
-    m_client->reqHistoricalData(reqId, contract, endDateTime, durationStr, barSizeSetting, whatToShow, useRTH, formatDate, false, TagValueListSPtr());
-    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    queueHistoricalRequest(reqId, contract, endDateTime, durationStr, barSizeSetting, whatToShow, useRTH, formatDate);
+}
+
+void TwsApi::sendHistoricalChunk(int reqId, const Contract& contract, const HistoricalQuery& query,
+    const HistoricalChunk& chunk)
+{
+    // formatDate 2 returns epoch seconds for intraday bars, so chunks can be stitched without
+    // knowing the TWS login time zone.
+    queueHistoricalRequest(reqId, contract, chunk.endDateTime, chunk.duration, query.barSize,
+                           query.whatToShow, query.useRTH ? 1 : 0, 2);
+}
+
+HistoricalPacer::Key TwsApi::historicalPacingKey(const Contract& contract, const std::string& end,
+    const std::string& duration, const std::string& barSize, const std::string& whatToShow,
+    int useRTH, int formatDate)
+{
+    HistoricalPacer::Key key;
+    key.contract = contract.symbol + "|" + contract.secType + "|" + contract.exchange + "|" + whatToShow;
+    key.request = key.contract + "|" + end + "|" + duration + "|" + barSize + "|"
+                + std::to_string(useRTH) + "|" + std::to_string(formatDate);
+    key.weight = whatToShow == "BID_ASK" ? 2 : 1;
+    return key;
+}
+
+// Paced requests are registered with kPacedHistoricalTimeout. A request the pacer has to hold
+// back gets its expected wait added on top, so a bulk backfill queued hours deep does not time
+// out while still waiting its turn; once it is actually sent the deadline restarts at
+// kHistoricalTimeout.
+void TwsApi::submitPaced(const HistoricalPacer::Key& key, int reqId, std::function<void()> send) {
+    const std::chrono::milliseconds wait = m_historicalPacer.submit(key, reqId, [this, reqId, send = std::move(send)]() {
+        m_requests.resetDeadline(reqId, kHistoricalTimeout);
+        send();
+    });
+    if (wait.count() > 0)
+        m_requests.resetDeadline(reqId, wait + kPacedHistoricalTimeout);
+}
+
+void TwsApi::queueHistoricalRequest(int reqId, const Contract& contract, const std::string& end,
+    const std::string& duration, const std::string& barSize, const std::string& whatToShow,
+    int useRTH, int formatDate, bool keepUpToDate)
+{
+    HistoricalPacer::Key key = historicalPacingKey(contract, end, duration, barSize, whatToShow, useRTH, formatDate);
+    submitPaced(key, reqId, [=, this]() {
+        pacedClient()->reqHistoricalData(reqId, contract, end, duration, barSize, whatToShow, useRTH,
+                                    formatDate, keepUpToDate, TagValueListSPtr());
+    });
+}
+
+std::chrono::milliseconds TwsApi::estimateHistoricalWait(const HistoricalQuery& query) const {
+    Contract contract;
+    contract.symbol = query.symbol;
+    contract.secType = "STK";
+    contract.exchange = "SMART";
+    std::vector<HistoricalPacer::Key> keys;
+    for (const auto& chunk : planHistoricalChunks(query.start, query.end, query.barSize))
+        keys.push_back(historicalPacingKey(contract, chunk.endDateTime, chunk.duration, query.barSize,
+                                           query.whatToShow, query.useRTH ? 1 : 0, 2));
+    return m_historicalPacer.estimate(keys);
+}
+
+PacingStats TwsApi::getHistoricalPacingStats() const {
+    return m_historicalPacer.stats();
+}
+
+BarSeries TwsApi::takeHistoricalBars(int reqId, const std::string& symbol,
+    const RequestResult& status)
+{
+    // Still queued behind the pacer means TWS never saw it; otherwise cancel it there.
+    if (status.status == RequestStatus::TimedOut && !m_historicalPacer.cancel(reqId))
+        pacedClient()->cancelHistoricalData(reqId);
+    if (!status.ok())
+        std::cerr << "error at get_historical_data_stocks: " << symbol << ": " << status.message << std::endl;
+
     std::unique_lock<std::mutex> lock(m_mutex);
-    std::vector<HistoricalBar> bars;
-    if(m_historicalData.find(reqId) != m_historicalData.end()) {
-        bars = m_historicalData[reqId];
-        if(bars.size() > static_cast<size_t>(limit))
-            bars.resize(limit);
+    BarSeries bars;
+    auto it = m_historicalData.find(reqId);
+    if (it != m_historicalData.end()) {
+        bars = std::move(it->second);
+        m_historicalData.erase(it);
     }
+    return bars;
+}
 
+BarSeries TwsApi::finishHistoricalRequest(int reqId, const std::string& symbol,
+    const RequestResult& status, int limit)
+{
+    BarSeries bars = takeHistoricalBars(reqId, symbol, status);
+    bars.truncate(static_cast<size_t>(std::max(0, limit)));
     return bars;
 }
 
+HistoricalRangeResult TwsApi::get_historical_range(const HistoricalQuery& query, int maxInFlight) {
+    const auto started = std::chrono::steady_clock::now();
+    HistoricalRangeResult result;
+    if (barSizeSeconds(query.barSize) == 0 || query.end <= query.start) {
+        std::cerr << "error at get_historical_range: empty range or unknown bar size '" << query.barSize << "'" << std::endl;
+        return result;
+    }
+    const HistoricalQuery clipped = clipToHeadTimestamp(query);
+
+    // Only the parts of the window the cache has never seen go to TWS.
+    std::vector<TimeRange> missing;
+    if (clipped.start < clipped.end)
+        missing.emplace_back(clipped.start, clipped.end);
+    if (m_barCache) {
+        BarSlice cached = m_barCache->read(clipped, &missing);
+        result.bars.append(cached);  // appended first, so freshly fetched bars win on equal timestamps
+        result.cachedBars = cached.count;
+    }
+    fetchHistoricalWindows(clipped, sessionWindows(clipped, missing), maxInFlight, result);
+    result.bars.normalize();
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (result.seconds > 0.0)
+        result.barsPerSecond = static_cast<double>(result.bars.size()) / result.seconds;
+    return result;
+}
+
+// Nothing exists before the contract's first data point, so that part is never requested.
+HistoricalQuery TwsApi::clipToHeadTimestamp(const HistoricalQuery& query) {
+    HistoricalQuery clipped = query;
+    const time_t head = get_head_timestamp(query.symbol, query.whatToShow, query.useRTH);
+    if (head > clipped.start)
+        clipped.start = std::min(head, clipped.end);
+    return clipped;
+}
+
+// Trims each missing range to the trading sessions inside it, so weekends and holidays are
+// not requested. The schedule costs a request of its own, so it is only fetched when the
+// ranges need more than one request anyway (or is already cached).
+std::vector<TwsApi::HistoricalWindow> TwsApi::sessionWindows(const HistoricalQuery& query,
+    const std::vector<TimeRange>& missing)
+{
+    std::vector<HistoricalWindow> windows;
+    if (missing.empty())
+        return windows;
+    size_t chunks = 0;
+    for (const auto& m : missing)
+        chunks += planHistoricalChunks(m.first, m.second, query.barSize).size();
+
+    const time_t start = missing.front().first;
+    const time_t end = missing.back().second;
+    std::optional<std::vector<TradingSession>> sessions =
+        cachedSchedule(query.symbol + (query.useRTH ? "|rth" : "|all"), start, end);
+    if (!sessions && chunks > 1)
+        sessions = get_trading_schedule(query.symbol, start, end, query.useRTH);
+
+    const long long barSeconds = barSizeSeconds(query.barSize);
+    for (const auto& m : missing)
+        windows.push_back({sessions ? trimToSessions(m, *sessions, barSeconds) : m, m});
+    return windows;
+}
+
+void TwsApi::fetchHistoricalWindows(const HistoricalQuery& query, const std::vector<HistoricalWindow>& windows,
+    int maxInFlight, HistoricalRangeResult& result)
+{
+    struct PlannedChunk {
+        HistoricalChunk chunk;
+        size_t window;
+    };
+    std::vector<PlannedChunk> planned;
+    for (size_t w = 0; w < windows.size(); ++w) {
+        for (auto& chunk : planHistoricalChunks(windows[w].fetch.first, windows[w].fetch.second, query.barSize))
+            planned.push_back({std::move(chunk), w});
+    }
+    result.chunks += planned.size();
+
+    const Contract contract = *stockContract(query.symbol);
+    std::vector<size_t> windowFailures(windows.size(), 0);
+    std::vector<BarSeries> fetched(windows.size());
+    struct InFlight {
+        int reqId;
+        size_t window;
+        std::future<RequestResult> done;
+    };
+    std::deque<InFlight> inFlight;
+
+    auto collectOldest = [&]() {
+        InFlight f = std::move(inFlight.front());
+        inFlight.pop_front();
+        RequestResult status = f.done.get();
+        if (!status.ok()) {
+            ++result.failedChunks;
+            ++windowFailures[f.window];
+        }
+        const TimeRange& window = windows[f.window].covers;
+        const BarSeries bars = takeHistoricalBars(f.reqId, query.symbol, status);
+        const BarView inWindow = bars.between(window.first, window.second);
+        fetched[f.window].append(inWindow);
+        result.bars.append(inWindow);
+    };
+
+    for (const auto& p : planned) {
+        if (inFlight.size() >= static_cast<size_t>(std::max(1, maxInFlight)))
+            collectOldest();
+        int reqId = m_requests.nextId();
+        auto done = m_requests.track(reqId, kPacedHistoricalTimeout);
+        sendHistoricalChunk(reqId, contract, query, p.chunk);
+        inFlight.push_back({reqId, p.window, std::move(done)});
+    }
+    while (!inFlight.empty())
+        collectOldest();
+
+    if (m_barCache) {
+        // The bar still forming at "now" is not final, so coverage stops one bar short of it.
+        const time_t settled = std::time(nullptr) - static_cast<time_t>(barSizeSeconds(query.barSize));
+        for (size_t w = 0; w < windows.size(); ++w) {
+            const TimeRange& covers = windows[w].covers;
+            const time_t coveredEnd = std::min(covers.second, settled);
+            if (windowFailures[w] == 0 && coveredEnd > covers.first)
+                m_barCache->store(query, {covers.first, coveredEnd}, fetched[w]);
+        }
+    }
+}
+
+// --- Head timestamps, trading schedule and gap backfill ---
+
+time_t TwsApi::get_head_timestamp(const std::string& symbol, const std::string& whatToShow, bool useRTH) {
+    const std::string key = symbol + "|" + whatToShow + (useRTH ? "|rth" : "|all");
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_headTimestampCache.find(key);
+        if (it != m_headTimestampCache.end())
+            return it->second;
+    }
+    time_t head = m_barCache ? m_barCache->headTimestamp(key) : -1;
+    if (head < 0) {
+        const Contract contract = *stockContract(symbol);
+        const int reqId = m_requests.nextId();
+        auto done = m_requests.track(reqId, kPacedHistoricalTimeout);
+        // Counts against the historical pacing limits like any other historical request.
+        HistoricalPacer::Key pacingKey = historicalPacingKey(contract, "", "", "head timestamp", whatToShow,
+                                                             useRTH ? 1 : 0, 2);
+        submitPaced(pacingKey, reqId, [=, this]() {
+            pacedClient()->reqHeadTimestamp(reqId, contract, whatToShow, useRTH ? 1 : 0, 2);
+        });
+        RequestResult status = done.get();
+
+        std::string reply;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            reply = std::move(m_headTimestampReplies[reqId]);
+            m_headTimestampReplies.erase(reqId);
+        }
+        if (!status.ok()) {
+            if (status.status == RequestStatus::TimedOut && !m_historicalPacer.cancel(reqId))
+                pacedClient()->cancelHeadTimestamp(reqId);
+            std::cerr << "error at get_head_timestamp: " << symbol << ": " << status.message << std::endl;
+            return -1;
+        }
+        pacedClient()->cancelHeadTimestamp(reqId);  // TWS keeps the request open otherwise
+        head = parseBarTime(reply);
+        if (head < 0) {
+            std::cerr << "error at get_head_timestamp: " << symbol << ": unrecognised time '" << reply << "'" << std::endl;
+            return -1;
+        }
+        if (m_barCache)
+            m_barCache->storeHeadTimestamp(key, head);
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_headTimestampCache[key] = head;
+    return head;
+}
+
+// Sessions overlapping [start, end) if the cache has seen all of that range.
+std::optional<std::vector<TradingSession>> TwsApi::cachedSchedule(const std::string& key, time_t start, time_t end) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const ScheduleCache& cache = m_schedules[key];
+    if (!subtractRanges({start, end}, cache.covered).empty())
+        return std::nullopt;
+    std::vector<TradingSession> sessions;
+    for (const auto& [sessionStart, session] : cache.sessions) {
+        if (session.end > start && session.start < end)
+            sessions.push_back(session);
+        else if (session.day >= start && session.day < end)
+            sessions.push_back(session);  // daily bars go by trading date
+    }
+    return sessions;
+}
+
+std::optional<std::vector<TradingSession>> TwsApi::get_trading_schedule(const std::string& symbol,
+    time_t start, time_t end, bool useRTH)
+{
+    const std::string key = symbol + (useRTH ? "|rth" : "|all");
+    std::vector<TimeRange> missing;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        missing = subtractRanges({start, end}, m_schedules[key].covered);
+    }
+
+    const Contract contract = *stockContract(symbol);
+    for (const auto& m : missing) {
+        for (const auto& chunk : planHistoricalChunks(m.first, m.second, "1 day")) {
+            const int reqId = m_requests.nextId();
+            auto done = m_requests.track(reqId, kPacedHistoricalTimeout);
+            queueHistoricalRequest(reqId, contract, chunk.endDateTime, chunk.duration, "1 day", "SCHEDULE",
+                                   useRTH ? 1 : 0, 2);
+            RequestResult status = done.get();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::vector<TradingSession> reply = std::move(m_scheduleReplies[reqId]);
+            m_scheduleReplies.erase(reqId);
+            if (!status.ok()) {
+                if (status.status == RequestStatus::TimedOut && !m_historicalPacer.cancel(reqId))
+                    pacedClient()->cancelHistoricalData(reqId);
+                std::cerr << "error at get_trading_schedule: " << symbol << ": " << status.message << std::endl;
+                return std::nullopt;
+            }
+            ScheduleCache& cache = m_schedules[key];
+            for (const auto& session : reply)
+                cache.sessions[session.start] = session;
+            // Sessions still to come are not final; only the past counts as seen.
+            const time_t seenEnd = std::min(chunk.end, std::time(nullptr));
+            cache.covered.emplace_back(chunk.start, std::max(chunk.start, seenEnd));
+            cache.covered = mergeRanges(std::move(cache.covered));
+        }
+    }
+
+    std::vector<TradingSession> sessions;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [sessionStart, session] : m_schedules[key].sessions) {
+        if ((session.end > start && session.start < end) || (session.day >= start && session.day < end))
+            sessions.push_back(session);
+    }
+    return sessions;
+}
+
+std::vector<TimeRange> TwsApi::find_historical_gaps(const HistoricalQuery& query, size_t minMissingBars) {
+    const long long barSeconds = barSizeSeconds(query.barSize);
+    if (!m_barCache || barSeconds == 0) {
+        std::cerr << "error at find_historical_gaps: needs a bar cache and a known bar size" << std::endl;
+        return {};
+    }
+    const HistoricalQuery clipped = clipToHeadTimestamp(query);
+    // Only settled bars can be missing.
+    const time_t to = std::min(clipped.end, std::time(nullptr) - static_cast<time_t>(barSeconds));
+    if (clipped.start >= to)
+        return {};
+    std::optional<std::vector<TradingSession>> sessions = get_trading_schedule(query.symbol, clipped.start, to, query.useRTH);
+    if (!sessions)
+        return {};
+    BarSlice cached = m_barCache->read(clipped);
+    return findBarGaps(cached.time, cached.count, *sessions, barSeconds, clipped.start, to, minMissingBars);
+}
+
+HistoricalRangeResult TwsApi::backfill_historical_gaps(const HistoricalQuery& query, size_t minMissingBars,
+    int maxInFlight)
+{
+    const auto started = std::chrono::steady_clock::now();
+    HistoricalRangeResult result;
+    std::vector<HistoricalWindow> windows;
+    for (const auto& r : coalesceRanges(find_historical_gaps(query, minMissingBars), maxChunkSeconds(query.barSize)))
+        windows.push_back({r, r});
+    fetchHistoricalWindows(query, windows, maxInFlight, result);
+    result.bars.normalize();
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (result.seconds > 0.0)
+        result.barsPerSecond = static_cast<double>(result.bars.size()) / result.seconds;
+    return result;
+}
+
+// --- Live bar series (keepUpToDate) ---
+
+int TwsApi::subscribeLiveBars(const std::string& symbol, const std::string& duration, const std::string& barSize,
+    const std::string& whatToShow, bool useRTH, LiveBarHandler onChange)
+{
+    const Contract contract = *stockContract(symbol);
+    const int reqId = m_requests.nextId();
+    {
+        std::lock_guard<std::mutex> lock(m_liveBarsMutex);
+        LiveBarSubscription& sub = m_liveBars[reqId];
+        sub.series.symbol = symbol;
+        sub.series.barSize = barSize;
+        sub.onChange = std::move(onChange);
+    }
+    auto done = m_requests.track(reqId, kPacedHistoricalTimeout);
+    // keepUpToDate requires an empty end time; formatDate 2 keeps intraday bar times in epoch seconds.
+    queueHistoricalRequest(reqId, contract, "", duration, barSize, whatToShow, useRTH ? 1 : 0, 2, true);
+    RequestResult status = done.get();
+    if (!status.ok()) {
+        if (status.status == RequestStatus::TimedOut && !m_historicalPacer.cancel(reqId))
+            pacedClient()->cancelHistoricalData(reqId);
+        std::cerr << "error at subscribeLiveBars: " << symbol << ": " << status.message << std::endl;
+        std::lock_guard<std::mutex> lock(m_liveBarsMutex);
+        m_liveBars.erase(reqId);
+        return -1;
+    }
+    return reqId;
+}
+
+void TwsApi::cancelLiveBars(int id) {
+    {
+        std::lock_guard<std::mutex> lock(m_liveBarsMutex);
+        if (m_liveBars.erase(id) == 0)
+            return;
+    }
+    pacedClient()->cancelHistoricalData(id);
+}
+
+bool TwsApi::withLiveBars(int id, const std::function<void(const LiveBarSeries&)>& fn) {
+    std::lock_guard<std::mutex> lock(m_liveBarsMutex);
+    auto it = m_liveBars.find(id);
+    if (it == m_liveBars.end())
+        return false;
+    fn(it->second.series);
+    return true;
+}
+
+// Returns false if the event does not belong to a live subscription.
+bool TwsApi::applyLiveBarEvent(const HistoricalEvent& event) {
+    std::unique_lock<std::mutex> lock(m_liveBarsMutex);
+    auto it = m_liveBars.find(event.reqId);
+    if (it == m_liveBars.end()) {
+        // Updates for a cancelled subscription can still be in flight; they have no other owner.
+        return event.type == HistoricalEventType::Update;
+    }
+    LiveBarSubscription& sub = it->second;
+    BarSeries& bars = sub.series.bars;
+
+    if (event.type == HistoricalEventType::Bar) {
+        bars.push_back(event.bar);
+        return true;
+    }
+    if (event.type == HistoricalEventType::End) {
+        bars.normalize();
+        sub.series.ready = true;
+        if (sub.onChange)
+            sub.onChange(bars, 0);
+        lock.unlock();
+        m_requests.complete(event.reqId);
+        return true;
+    }
+
+    const HistoricalBar& bar = event.bar;
+    size_t changed;
+    if (bars.empty() || bar.time > bars.time.back()) {
+        bars.push_back(bar);
+        changed = bars.size() - 1;
+        if (bars.size() > 1)
+            ++sub.series.rolls;
+    } else {
+        // Normally the forming (last) bar; an older time is only a late revision.
+        const auto pos = std::lower_bound(bars.time.begin(), bars.time.end(), bar.time);
+        changed = static_cast<size_t>(pos - bars.time.begin());
+        if (*pos != bar.time) {
+            std::cerr << "error at historicalDataUpdate: " << sub.series.symbol
+                      << ": update for a bar not in the series, ignored" << std::endl;
+            return true;
+        }
+        bars.open[changed] = bar.open;
+        bars.high[changed] = bar.high;
+        bars.low[changed] = bar.low;
+        bars.close[changed] = bar.close;
+        bars.volume[changed] = bar.volume;
+    }
+    ++sub.series.updates;
+    if (sub.series.ready && sub.onChange)
+        sub.onChange(bars, changed);
+    return true;
+}
+
+// --- Historical ticks ---
+
+// Ticks come back oldest first from the page's start second. The next page starts at the
+// last second seen and skips the ticks of that second it already has, so nothing is lost or
+// repeated whether or not TWS cuts a page in the middle of a second.
+HistoricalTicksResult TwsApi::get_historical_ticks(const std::string& symbol, time_t start, time_t end,
+    const std::string& whatToShow, bool useRTH, size_t reserveTicks)
+{
+    const auto started = std::chrono::steady_clock::now();
+    HistoricalTicksResult result;
+    const bool trades = whatToShow == "TRADES";
+    const bool bidAsk = whatToShow == "BID_ASK";
+    if (end <= start || (!trades && !bidAsk && whatToShow != "MIDPOINT")) {
+        std::cerr << "error at get_historical_ticks: empty range or unsupported whatToShow '" << whatToShow << "'" << std::endl;
+        return result;
+    }
+    result.ticks.reserve(reserveTicks, bidAsk, trades);
+
+    const Contract contract = *stockContract(symbol);
+    time_t cursor = start;
+    size_t skip = 0;
+    while (cursor < end) {
+        int reqId = m_requests.nextId();
+        {
+            std::lock_guard<std::mutex> lock(m_tickPageMutex);
+            TickPageSink& sink = m_tickPages[reqId];
+            sink.out = &result.ticks;
+            sink.end = end;
+            sink.skipTime = cursor;
+            sink.skip = skip;
+        }
+        auto done = m_requests.track(reqId, kPacedHistoricalTimeout);
+        queueHistoricalTicksRequest(reqId, contract, formatIbDateTimeUtc(cursor), whatToShow, useRTH ? 1 : 0);
+        RequestResult status = done.get();
+
+        TickPageSink page;
+        {
+            std::lock_guard<std::mutex> lock(m_tickPageMutex);
+            page = m_tickPages[reqId];
+            m_tickPages.erase(reqId);  // a late callback now finds no sink and is ignored
+        }
+        ++result.pages;
+        if (!status.ok()) {
+            // There is no cancel for tick requests; only one still waiting for the pacer can be withdrawn.
+            if (status.status == RequestStatus::TimedOut)
+                m_historicalPacer.cancel(reqId);
+            ++result.failedPages;
+            std::cerr << "error at get_historical_ticks: " << symbol << ": " << status.message << std::endl;
+            break;  // the next page's start depends on this one
+        }
+        if (page.received < static_cast<size_t>(kTicksPerPage) || page.lastTime >= end)
+            break;
+        if (page.lastTime <= cursor) {
+            // A whole page inside one second: paging cannot split a second any further.
+            std::cerr << "error at get_historical_ticks: " << symbol << ": more than " << kTicksPerPage
+                      << " ticks at " << formatIbDateTimeUtc(cursor) << ", rest of that second skipped" << std::endl;
+            ++cursor;
+            skip = 0;
+        } else {
+            cursor = page.lastTime;
+            skip = page.atLastTime;
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (result.seconds > 0.0)
+        result.ticksPerSecond = static_cast<double>(result.ticks.count()) / result.seconds;
+    return result;
+}
+
+void TwsApi::queueHistoricalTicksRequest(int reqId, const Contract& contract, const std::string& start,
+    const std::string& whatToShow, int useRTH)
+{
+    HistoricalPacer::Key key = historicalPacingKey(contract, start, "", std::to_string(kTicksPerPage) + " ticks",
+                                                   whatToShow, useRTH, 0);
+    submitPaced(key, reqId, [=, this]() {
+        pacedClient()->reqHistoricalTicks(reqId, contract, start, "", kTicksPerPage, whatToShow, useRTH,
+                                     false, TagValueListSPtr());
+    });
+}
+
+template <typename Tick, typename Append>
+void TwsApi::appendTickPage(int reqId, const std::vector<Tick>& ticks, bool done, Append append) {
+    {
+        std::lock_guard<std::mutex> lock(m_tickPageMutex);
+        auto it = m_tickPages.find(reqId);
+        if (it == m_tickPages.end())
+            return;  // timed out or failed already
+        TickPageSink& sink = it->second;
+        for (const Tick& tick : ticks) {
+            const time_t t = tick.time;
+            ++sink.received;
+            if (t == sink.lastTime) {
+                ++sink.atLastTime;
+            } else {
+                sink.lastTime = t;
+                sink.atLastTime = 1;
+            }
+            if (t < sink.skipTime || t >= sink.end)
+                continue;
+            if (t == sink.skipTime && sink.skip > 0) {
+                --sink.skip;
+                continue;
+            }
+            sink.out->time.push_back(static_cast<int64_t>(t));
+            append(*sink.out, tick);
+        }
+    }
+    if (done)
+        m_requests.complete(reqId);
+}
+
+// --- Coroutine (awaitable) request API ---
+
+RequestAwaiter TwsApi::awaitRequest(int reqId, std::chrono::milliseconds timeout, std::function<void()> send) {
+    return RequestAwaiter(m_requests, m_executor, reqId, timeout, std::move(send));
+}
+
+Task<BarSeries> TwsApi::historical(std::string symbol, std::string start, std::string end, int limit) {
+    Contract contract = *stockContract(symbol);
+    int reqId = m_requests.nextId();
+    RequestResult status = co_await awaitRequest(reqId, kPacedHistoricalTimeout, [this, reqId, contract, end]() {
+        sendHistoricalRequest(reqId, contract, end);
+    });
+    co_return finishHistoricalRequest(reqId, symbol, status, limit);
+}
+
+Task<std::vector<Position>> TwsApi::positions() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_positionsLoaded)
+            co_return positionsLocked();
+    }
+    int reqId = m_requests.nextId();
+    RequestResult status = co_await awaitRequest(reqId, kRequestTimeout, [this, reqId]() {
+        bool subscribe = false;
+        if (!beginPositionsRequest(reqId, subscribe))
+            m_requests.complete(reqId);
+        else if (subscribe)
+            pacedClient()->reqPositions();
+    });
+    co_return finishPositionsRequest(status);
+}
+
+Task<OptionQuote> TwsApi::optionQuote(std::string optionSymbol) {
+    std::shared_ptr<const Contract> contract = optionContract(optionSymbol);
+    if (!contract)
+        co_return OptionQuote{optionSymbol};
+    int tickerId = beginOptionQuote(optionSymbol);
+    RequestResult status = co_await awaitRequest(tickerId, kOptionQuoteTimeout, [this, tickerId, contract]() {
+        pacedClient()->reqMktData(tickerId, *contract, "100,101,106", false, false, TagValueListSPtr());
+    });
+    co_return finishOptionQuote(tickerId, optionSymbol, status);
+}
+
+Task<double> TwsApi::cashBalance() {
+    auto state = m_accountState.snapshot();
+    if (state->streaming)
+        co_return state->totalCashValue;  // streamed by subscribe_account_updates
+    int reqId = m_requests.nextId();
+    RequestResult status = co_await awaitRequest(reqId, kRequestTimeout, [this, reqId]() {
+        pacedClient()->reqAccountSummary(reqId, "All", "TotalCashValue");
+    });
+    pacedClient()->cancelAccountSummary(reqId);
+    if (!status.ok()) {
+        std::cerr << "error at cashBalance: " << status.message << std::endl;
+        co_return 0.0;
+    }
+
+    std::lock_guard<std::mutex> lock(m_accountMutex);
+    auto it = m_accountValues.find("TotalCashValue");
+    co_return it != m_accountValues.end() ? std::stod(it->second) : 0.0;
+}
+
 
 // Convenience function to get latest trades for one or more symbols.
 void TwsApi::subscribe_stock_trades(const std::string& symbols) {
@@ -452,11 +1840,10 @@ void TwsApi::subscribe_stock_trades(const std::string& symbols) {
 
     // Subscribe to tick-by-tick trade data ("Last") for each symbol.
     for (const auto& sym : symbolList) {
-        Contract contract = createStockContract(sym);
-        int tickerId = m_nextTickerId++;
-        m_tickerIdToSymbol[tickerId] = sym;
+        Contract contract = *stockContract(sym);
+        int tickerId = newTickerId(sym);
         // "Last" returns individual trade ticks.
-        m_client-> reqTickByTickData(tickerId, contract, "Last", 0, false);
+        pacedClient()-> reqTickByTickData(tickerId, contract, "Last", 0, false);
         tickerIds.push_back(tickerId);
     }
 }
@@ -468,11 +1855,10 @@ void TwsApi::subscribe_stock_quotes(const std::string& symbols) {
 
     // Subscribe to tick-by-tick quote data ("BidAsk") for each symbol.
     for (const auto& sym : symbolList) {
-        Contract contract = createStockContract(sym);
-        int tickerId = m_nextTickerId++;
-        m_tickerIdToSymbol[tickerId] = sym;
+        Contract contract = *stockContract(sym);
+        int tickerId = newTickerId(sym);
         // "BidAsk" returns bid and ask updates.
-        m_client-> reqTickByTickData(tickerId, contract, "BidAsk", 0, false);
+        pacedClient()-> reqTickByTickData(tickerId, contract, "BidAsk", 0, false);
         tickerIds.push_back(tickerId);
     }
 }
@@ -484,71 +1870,351 @@ void TwsApi::subscribe_option_trades(const std::string& symbols) {
 
     // Subscribe to tick-by-tick trade data ("Last") for each option symbol.
     for (const auto& sym : symbolList) {
-        Contract contract = createOptionContract(sym);
-        int tickerId = m_nextTickerId++;
-        m_tickerIdToSymbol[tickerId] = sym;
+        std::shared_ptr<const Contract> contract = optionContract(sym);
+        if (!contract)
+            continue;
+        int tickerId = newTickerId(sym);
         // "Last" returns individual trade ticks.
-        m_client-> reqTickByTickData(tickerId, contract, "Last", 0, false);
+        pacedClient()-> reqTickByTickData(tickerId, *contract, "Last", 0, false);
         tickerIds.push_back(tickerId);
     }
 }
 
-void TwsApi::requestOptionMarketData(const std::string& optionSymbol) {
-    Contract contract = createOptionContract(optionSymbol);
-    int tickerId = m_nextTickerId++;
-    m_tickerIdToSymbol[tickerId] = optionSymbol;
+int TwsApi::requestOptionMarketData(const std::string& optionSymbol) {
+    std::shared_ptr<const Contract> contract = optionContract(optionSymbol);
+    if (!contract)
+        return -1;
+    int tickerId = newTickerId(optionSymbol);
+    feedVolSurface(tickerId, optionSymbol);
 
     std::string genericTicks = "100,101,106";
-    m_client->reqMktData(tickerId, contract, genericTicks, false, false, TagValueListSPtr());
+    pacedClient()->reqMktData(tickerId, *contract, genericTicks, false, false, TagValueListSPtr());
+    return tickerId;
 }
 
-void TwsApi::tickOptionComputation(TickerId tickerId, TickType tickType, int, double impliedVol, double, double,
-                                   double, double, double, double, double) {
-    std::lock_guard<std::mutex> lock(m_tickMutex);
-    m_optionQuotes[tickerId].impliedVolatility = impliedVol;
+void TwsApi::tickOptionComputation(TickerId tickerId, TickType tickType, int, double impliedVol, double delta,
+                                   double optPrice, double pvDividend, double gamma, double vega, double theta,
+                                   double undPrice) {
+    MarketDataEvent event;
+    event.type = MarketDataEventType::OptionComputation;
+    event.field = tickType;
+    event.tickerId = tickerId;
+    event.time = std::time(nullptr);
+    event.computation = {impliedVol, delta, optPrice, pvDividend, gamma, vega, theta, undPrice};
+    pushMarketDataEvent(std::move(event));
 }
+
 void TwsApi::tickSize(TickerId tickerId, const TickType field, const Decimal size) {
+    MarketDataEvent event;
+    event.type = MarketDataEventType::Size;
+    event.field = field;
+    event.tickerId = tickerId;
+    event.size = DecimalFunctions::decimalToDouble(size);
+    pushMarketDataEvent(std::move(event));
+}
+
+OptionQuote TwsApi::getOptionQuote(const std::string& optionSymbol) {
+    std::shared_ptr<const Contract> contract = optionContract(optionSymbol);
+    if (!contract)
+        return OptionQuote{optionSymbol};
+    int tickerId = beginOptionQuote(optionSymbol);
+
+    // Completed by the market data dispatcher as soon as bid, ask and IV have all arrived.
+    auto done = m_requests.track(tickerId, kOptionQuoteTimeout);
+    std::string genericTicks = "100,101,106"; // Volume (100), OI (101), IV (106)
+    pacedClient()->reqMktData(tickerId, *contract, genericTicks, false, false, TagValueListSPtr());
+    return finishOptionQuote(tickerId, optionSymbol, done.get());
+}
+
+int TwsApi::beginOptionQuote(const std::string& optionSymbol) {
+    int tickerId = newTickerId(optionSymbol);
+    feedVolSurface(tickerId, optionSymbol);
     std::lock_guard<std::mutex> lock(m_tickMutex);
+    m_optionQuotes[tickerId] = {}; // Initialize empty OptionQuote
+    m_optionQuotes[tickerId].symbol = optionSymbol;
+    m_pendingOptionQuotes.insert(tickerId);
+    return tickerId;
+}
 
-    if (field == 27 || field == 28)
-        m_optionQuotes[tickerId].volume = size;
-    else if (field == 101)
-        m_optionQuotes[tickerId].volume = size;
-    else if (field == 100)
-        m_optionQuotes[tickerId].volume = size;
+OptionQuote TwsApi::finishOptionQuote(int tickerId, const std::string& optionSymbol, const RequestResult& status) {
+    pacedClient()->cancelMktData(tickerId);
+    if (!status.ok())
+        std::cerr << "error at getOptionQuote: " << optionSymbol << ": " << status.message << std::endl;
+
+    std::lock_guard<std::mutex> lock(m_tickMutex);
+    m_greeks.removeTicker(tickerId);
+    m_volSurfaceFeeds.erase(tickerId);
+    m_pendingOptionQuotes.erase(tickerId);
+    OptionQuote result = m_optionQuotes[tickerId];
+    m_optionQuotes.erase(tickerId);
+    return result;
 }
 
-OptionQuote TwsApi::getOptionQuote(const std::string& optionSymbol) {
-    Contract contract = createOptionContract(optionSymbol);
-    int tickerId = m_nextTickerId++;
+void TwsApi::applyOptionSnapshotEvent(OptionSnapshot& snapshot, const MarketDataEvent& event) {
+    switch (event.type) {
+        case MarketDataEventType::Price:
+            if (event.field == BID || event.field == DELAYED_BID) {
+                snapshot.bid = event.price;
+                snapshot.fields |= OptionSnapshot::Bid;
+            } else if (event.field == ASK || event.field == DELAYED_ASK) {
+                snapshot.ask = event.price;
+                snapshot.fields |= OptionSnapshot::Ask;
+            } else if (event.field == LAST || event.field == DELAYED_LAST) {
+                snapshot.last = event.price;
+                snapshot.fields |= OptionSnapshot::Last;
+            }
+            break;
+        case MarketDataEventType::Size:
+            if (event.field == BID_SIZE || event.field == DELAYED_BID_SIZE) {
+                snapshot.bidSize = event.size;
+            } else if (event.field == ASK_SIZE || event.field == DELAYED_ASK_SIZE) {
+                snapshot.askSize = event.size;
+            } else if (event.field == VOLUME || event.field == DELAYED_VOLUME) {
+                snapshot.volume = event.size;
+                snapshot.fields |= OptionSnapshot::Volume;
+            }
+            break;
+        case MarketDataEventType::OptionComputation:
+            if (event.field == MODEL_OPTION || event.field == DELAYED_MODEL_OPTION_COMPUTATION) {
+                snapshot.model = event.computation;
+                snapshot.fields |= OptionSnapshot::Model;
+            }
+            break;
+        default:
+            break;
+    }
+}
 
-    {
-        std::lock_guard<std::mutex> lock(m_tickMutex);
-        m_tickerIdToSymbol[tickerId] = optionSymbol;
-        m_optionQuotes[tickerId] = {}; // Initialize empty OptionQuote
+// Streaming lines rather than snapshot=true: a snapshot only ends after TWS has collected
+// every field (up to 11 s), while a streaming line is cancelled as soon as the required ones
+// are in. tickSnapshotEnd still completes a contract if it arrives.
+OptionSnapshotResult TwsApi::get_option_snapshots(const std::vector<Contract>& contracts, int maxLines,
+                                                  uint8_t requiredFields) {
+    const auto started = std::chrono::steady_clock::now();
+    OptionSnapshotResult result;
+    result.snapshots.resize(contracts.size());
+
+    // Completions arrive from the dispatch thread (fields), the reader (errors) and the
+    // registry sweeper (timeouts); all of them just queue the ticker id for this thread.
+    struct Finished {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::vector<std::pair<int, RequestResult>> ids;
+    };
+    auto finished = std::make_shared<Finished>();
+    std::unordered_map<int, size_t> inFlight;  // tickerId -> contract index
+
+    auto collect = [&](int tickerId, const RequestResult& status) {
+        if (status.status != RequestStatus::Failed)  // a line TWS rejected is already gone
+            pacedClient()->cancelMktData(tickerId);
+        const size_t i = inFlight[tickerId];
+        inFlight.erase(tickerId);
+        {
+            std::lock_guard<std::mutex> lock(m_tickMutex);
+            m_optionSnapshots.erase(tickerId);
+            m_tickerIdToSymbol.erase(tickerId);
+            m_quotes.erase(tickerId);
+            m_trades.erase(tickerId);
+            m_greeks.removeTicker(tickerId);
+        }
+        OptionSnapshot& snapshot = result.snapshots[i];
+        snapshot.complete = (snapshot.fields & requiredFields) == requiredFields;
+        if (snapshot.complete) {
+            ++result.completed;
+        } else {
+            snapshot.error = status.ok() ? "snapshot ended before all fields arrived" : status.message;
+            if (status.status == RequestStatus::Failed)
+                ++result.failed;
+        }
+    };
+
+    const size_t lines = static_cast<size_t>(std::max(1, maxLines));
+    size_t next = 0;
+    while (next < contracts.size() || !inFlight.empty()) {
+        while (next < contracts.size() && inFlight.size() < lines) {
+            const Contract& contract = contracts[next];
+            OptionSnapshot& snapshot = result.snapshots[next];
+            if (contract.secType == "OPT") {
+                char strike[16];
+                std::snprintf(strike, sizeof(strike), "%08lld", std::llround(contract.strike * 1000.0));
+                snapshot.symbol = contract.symbol + contract.lastTradeDateOrContractMonth.substr(
+                                      std::min<size_t>(2, contract.lastTradeDateOrContractMonth.size()))
+                                  + (contract.right.empty() ? "" : contract.right.substr(0, 1)) + strike;
+            } else {
+                snapshot.symbol = contract.symbol;
+            }
+
+            const int tickerId = newTickerId(snapshot.symbol);
+            {
+                std::lock_guard<std::mutex> lock(m_tickMutex);
+                m_optionSnapshots[tickerId] = {&snapshot, requiredFields};
+            }
+            inFlight[tickerId] = next++;
+            m_requests.add(tickerId, kOptionQuoteTimeout, [finished, tickerId](const RequestResult& status) {
+                std::lock_guard<std::mutex> lock(finished->mutex);
+                finished->ids.emplace_back(tickerId, status);
+                finished->cond.notify_one();
+            });
+            pacedClient()->reqMktData(tickerId, contract, "", false, false, TagValueListSPtr());
+        }
+
+        std::vector<std::pair<int, RequestResult>> done;
+        {
+            std::unique_lock<std::mutex> lock(finished->mutex);
+            finished->cond.wait(lock, [&]() { return !finished->ids.empty(); });
+            done.swap(finished->ids);
+        }
+        for (const auto& [tickerId, status] : done)
+            collect(tickerId, status);
     }
 
-    std::string genericTicks = "100,101,106"; // Volume (100), OI (101), IV (106)
-    m_client->reqMktData(tickerId, contract, genericTicks, false, false, TagValueListSPtr());
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return result;
+}
+std::optional<OptionComputation> TwsApi::getOptionGreeks(int tickerId, GreekSource source) {
+    std::lock_guard<std::mutex> lock(m_tickMutex);
+    const long row = m_greeks.row(tickerId);
+    OptionComputation c;
+    if (row < 0 || !m_greeks.get(static_cast<size_t>(row), source, c))
+        return std::nullopt;
+    return c;
+}
 
-    // Wait for data (e.g., 2 seconds)
-    std::unique_lock<std::mutex> lock(m_optionQuoteMutex);
-    m_optionQuoteCondition.wait_for(lock, std::chrono::milliseconds(200), [&](){
-        const auto& quote = m_optionQuotes[tickerId];
-        return quote.bidPrice > 0 && quote.ask_price > 0 && quote.impliedVolatility > 0;
-    });
+PortfolioGreeks TwsApi::getPortfolioGreeks() {
+    std::lock_guard<std::mutex> lock(m_tickMutex);
+    return m_greeks.portfolio();
+}
 
-    m_client->cancelMktData(tickerId);
+ChainGreeks TwsApi::get_chain_greeks(const std::string& symbol, int32_t fromExpiry, int32_t toExpiry,
+                                     double rate, double dividendYield, int maxLines) {
+    std::shared_ptr<const OptionChain> chain = get_option_chain(symbol);
+    if (!chain)
+        return {};
+    const size_t first = chain->firstExpiryFrom(fromExpiry);
+    const size_t last = std::max(first, chain->firstExpiryFrom(toExpiry + 1));
+
+    std::vector<Contract> contracts;
+    std::vector<size_t> slots;
+    for (size_t e = first; e < last; ++e) {
+        for (size_t k = 0; k < chain->expiry(e).strikes.size(); ++k) {
+            for (OptionRight right : {OptionRight::Call, OptionRight::Put}) {
+                contracts.push_back(createOptionContract(*chain, e, k, right));
+                slots.push_back(chain->slot(e, k, right));
+            }
+        }
+    }
+    OptionSnapshotResult quotes = get_option_snapshots(contracts, maxLines, OptionSnapshot::Bid | OptionSnapshot::Ask);
+
+    std::vector<double> mids(chain->slotCount(), std::numeric_limits<double>::quiet_NaN());
+    std::vector<double> underlyingPrices;
+    for (size_t i = 0; i < quotes.snapshots.size(); ++i) {
+        const OptionSnapshot& s = quotes.snapshots[i];
+        if ((s.fields & OptionSnapshot::Bid) && (s.fields & OptionSnapshot::Ask) && s.bid > 0.0 && s.ask >= s.bid)
+            mids[slots[i]] = 0.5 * (s.bid + s.ask);
+        if ((s.fields & OptionSnapshot::Model) && s.model.undPrice > 0.0 && s.model.undPrice != DBL_MAX)
+            underlyingPrices.push_back(s.model.undPrice);
+    }
 
-    OptionQuote result;
+    // The stock's streamed quote, if its line is still open and ticked in the last few seconds.
+    double spot = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(m_tickMutex);
+        const long now = static_cast<long>(std::time(nullptr));
+        long newest = 0;
+        for (const auto& [tickerId, quote] : m_quotes) {
+            if (quote.symbol != symbol || quote.timestamp <= newest || now - quote.timestamp > kLiveQuoteSeconds ||
+                !m_tickerIdToSymbol.count(tickerId))
+                continue;
+            if (quote.bid_price > 0.0 && quote.ask_price >= quote.bid_price)
+                spot = 0.5 * (quote.bid_price + quote.ask_price);
+            else if (quote.last_price > 0.0)
+                spot = quote.last_price;
+            else
+                continue;
+            newest = quote.timestamp;
+        }
+    }
+    if (spot <= 0.0) {
+        // Not streamed: quote the stock once, on the same short-lived line as the options.
+        OptionSnapshotResult underlying = get_option_snapshots({*stockContract(symbol)}, 1,
+                                                               OptionSnapshot::Bid | OptionSnapshot::Ask);
+        const OptionSnapshot& u = underlying.snapshots.front();
+        if (u.complete && u.bid > 0.0 && u.ask >= u.bid)
+            spot = 0.5 * (u.bid + u.ask);
+        else if ((u.fields & OptionSnapshot::Last) && u.last > 0.0)
+            spot = u.last;
+    }
+    if (spot <= 0.0 && !underlyingPrices.empty()) {
+        auto middle = underlyingPrices.begin() + underlyingPrices.size() / 2;
+        std::nth_element(underlyingPrices.begin(), middle, underlyingPrices.end());
+        spot = *middle;
+    }
+    if (spot <= 0.0) {
+        std::cerr << "error at get_chain_greeks: " << symbol << ": no underlying price" << std::endl;
+        return {};
+    }
+    ChainGreeks greeks = priceChain(*chain, mids, spot, rate, dividendYield, std::time(nullptr), first, last);
+
+    std::shared_ptr<VolSurface> surface;
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        result = m_optionQuotes[tickerId];
+        auto it = m_volSurfaces.find(symbol);
+        if (it != m_volSurfaces.end() && it->second->chain() == chain)
+            surface = it->second;
+    }
+    if (surface) {
+        surface->setSpot(spot);
+        for (size_t slot = 0; slot < greeks.iv.size(); ++slot) {
+            if (std::isfinite(greeks.iv[slot]))
+                surface->update(slot, greeks.iv[slot]);
+        }
     }
+    return greeks;
+}
 
-    return result;
+std::shared_ptr<VolSurface> TwsApi::get_vol_surface(const std::string& symbol) {
+    std::shared_ptr<const OptionChain> chain = get_option_chain(symbol);
+    if (!chain)
+        return nullptr;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::shared_ptr<VolSurface>& surface = m_volSurfaces[symbol];
+    if (!surface || surface->chain() != chain)
+        surface = std::make_shared<VolSurface>(chain);  // the chain was fetched again (new day)
+    return surface;
 }
 
+void TwsApi::feedVolSurface(int tickerId, const std::string& optionSymbol) {
+    OccSymbol occ;
+    if (!parseOccSymbol(optionSymbol, occ))
+        return;
+    std::shared_ptr<VolSurface> surface;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_volSurfaces.empty())
+            return;
+        auto it = m_volSurfaces.find(std::string(occ.root));
+        if (it == m_volSurfaces.end()) {
+            // The root is the trading class; surfaces are keyed by the underlying (SPXW -> SPX).
+            it = std::find_if(m_volSurfaces.begin(), m_volSurfaces.end(), [&](const auto& entry) {
+                const OptionChain& c = *entry.second->chain();
+                const long e = c.findExpiry(occ.expiry);
+                return e >= 0 && c.expiry(e).tradingClass == occ.root;
+            });
+        }
+        if (it == m_volSurfaces.end())
+            return;
+        surface = it->second;
+    }
+    const OptionChain& chain = *surface->chain();
+    const long e = chain.findExpiry(occ.expiry);
+    if (e < 0 || chain.expiry(e).strikes.empty())
+        return;
+    const size_t k = chain.nearestStrike(e, occ.strike());
+    if (std::llround(chain.expiry(e).strikes[k] * 1000.0) != occ.strikeMillis)
+        return;  // not a strike of the chain
+    std::lock_guard<std::mutex> lock(m_tickMutex);
+    m_volSurfaceFeeds[tickerId] = {surface, chain.slot(e, k, occ.right)};
+}
 
 // Convenience function to get latest quotes for one or more option symbols.
 void TwsApi::subscribe_option_quotes(const std::string& symbols) {
@@ -557,11 +2223,12 @@ void TwsApi::subscribe_option_quotes(const std::string& symbols) {
 
     // Subscribe to tick-by-tick quote data ("BidAsk") for each option symbol.
     for (const auto& sym : symbolList) {
-        Contract contract = createOptionContract(sym);
-        int tickerId = m_nextTickerId++;
-        m_tickerIdToSymbol[tickerId] = sym;
+        std::shared_ptr<const Contract> contract = optionContract(sym);
+        if (!contract)
+            continue;
+        int tickerId = newTickerId(sym);
         // "BidAsk" returns bid and ask updates.
-        m_client-> reqTickByTickData(tickerId, contract, "BidAsk", 0, false);
+        pacedClient()-> reqTickByTickData(tickerId, *contract, "BidAsk", 0, false);
         tickerIds.push_back(tickerId);
     }
 }
@@ -575,45 +2242,158 @@ Contract TwsApi::createStockContract(const std::string& symbol) {
     return contract;
 }
 
-Contract TwsApi::createOptionContract(const std::string& symbol) {
-    size_t pos = 0;
-    while (pos < symbol.size() && std::isalpha(symbol[pos])) {
-        ++pos;
+std::optional<Contract> TwsApi::createOptionContract(const std::string& symbol) {
+    OccSymbol occ;
+    if (!parseOccSymbol(symbol, occ))
+        return std::nullopt;
+
+    Contract contract;
+    contract.symbol = std::string(occ.root);
+    contract.tradingClass = std::string(occ.root);  // keeps SPX monthlies apart from SPXW
+    contract.lastTradeDateOrContractMonth = std::to_string(occ.expiry);
+    contract.strike = occ.strike();
+    contract.right = occ.right == OptionRight::Call ? "CALL" : "PUT";
+    contract.secType = "OPT";
+    contract.exchange = "SMART";
+    contract.currency = "USD";
+    contract.multiplier = "100";
+
+    return contract;
+}
+
+std::shared_ptr<const Contract> TwsApi::optionContract(const std::string& symbol) {
+    if (std::shared_ptr<const ContractInfo> info = m_contracts.find(symbol))
+        return std::shared_ptr<const Contract>(info, &info->contract);
+    std::optional<Contract> parsed = createOptionContract(symbol);
+    if (!parsed) {
+        std::cerr << "error at optionContract: invalid OCC symbol " << symbol << std::endl;
+        return nullptr;
+    }
+    return cacheContract(symbol, std::move(*parsed));
+}
+
+std::shared_ptr<const Contract> TwsApi::stockContract(const std::string& symbol) {
+    if (std::shared_ptr<const ContractInfo> info = m_contracts.find(symbol))
+        return std::shared_ptr<const Contract>(info, &info->contract);
+    return cacheContract(symbol, createStockContract(symbol));
+}
+
+std::shared_ptr<const Contract> TwsApi::cacheContract(const std::string& key, Contract contract) {
+    ContractInfo unresolved;
+    unresolved.contract = std::move(contract);
+    auto [info, inserted] = m_contracts.insert(key, std::move(unresolved));
+    if (inserted) {
+        // Resolve in the background so the caller's request goes out now with the built contract.
+        const int reqId = m_requests.nextId();
+        m_requests.add(reqId, kRequestTimeout, [this, reqId, key](const RequestResult& status) {
+            std::vector<ContractDetails> details;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                details = std::move(m_contractDetails[reqId]);
+                m_contractDetails.erase(reqId);
+            }
+            // Otherwise keep the built contract; TWS resolves it on every request instead.
+            if (status.ok() && details.size() == 1) {
+                auto info = m_contracts.store(key, contractInfoFromDetails(details.front(), utcDateYmd(std::time(nullptr))));
+                requestMarketRule(info->marketRuleId);
+            }
+        });
+        pacedClient()->reqContractDetails(reqId, info->contract);
     }
-    if (pos == 0 || symbol.size() < pos + 6 + 1 + 8) {
-        throw std::invalid_argument("Symbol format is invalid");
+    return std::shared_ptr<const Contract>(info, &info->contract);
+}
+
+std::shared_ptr<const ContractInfo> TwsApi::get_contract_info(const std::string& symbol) {
+    std::shared_ptr<const ContractInfo> cached = m_contracts.find(symbol);
+    if (cached && cached->resolved())
+        return cached;
+
+    std::optional<Contract> query = createOptionContract(symbol);
+    std::vector<ContractDetails> details = get_contract_details(query ? *query : createStockContract(symbol));
+    if (details.size() != 1) {
+        if (!details.empty())
+            std::cerr << "error at get_contract_info: " << symbol << ": " << details.size() << " matching contracts" << std::endl;
+        return nullptr;
     }
+    auto info = m_contracts.store(symbol, contractInfoFromDetails(details.front(), utcDateYmd(std::time(nullptr))));
+    requestMarketRule(info->marketRuleId);
+    return info;
+}
 
-    std::string ticker = symbol.substr(0, pos);
-    std::string dateStr = symbol.substr(pos, 6);
-    char rightChar = symbol[pos + 6];
-    std::string strikeStr = symbol.substr(pos + 6 + 1, 8);
+void TwsApi::requestMarketRule(int marketRuleId) {
+    if (marketRuleId > 0 && m_marketRules.markRequested(marketRuleId))
+        pacedClient()->reqMarketRule(marketRuleId);
+}
 
-    std::string right;
-    if (rightChar == 'C') {
-        right = "CALL";
-    } else if (rightChar == 'P') {
-        right = "PUT";
-    } else {
-        throw std::invalid_argument("Symbol format is invalid: invalid option type");
+double TwsApi::roundOrderPrice(const std::string& symbol, double price, PriceRounding mode) {
+    if (!(price > 0.0) || price == UNSET_DOUBLE)
+        return price;  // not set (market orders, no stop)
+    std::shared_ptr<const ContractInfo> info = m_contracts.find(symbol);
+    if (info && info->marketRuleId > 0) {
+        if (std::shared_ptr<const PriceLadder> ladder = m_marketRules.find(info->marketRuleId))
+            return ladder->round(price, mode);
+        requestMarketRule(info->marketRuleId);  // for the next order; use the min tick meanwhile
+    }
+    double minTick = info ? info->minTick : 0.0;
+    if (!(minTick > 0.0)) {
+        std::lock_guard<std::mutex> lock(m_tickMutex);
+        auto it = m_tickMinTicks.find(symbol);
+        if (it != m_tickMinTicks.end())
+            minTick = it->second;
+    }
+    return roundToIncrement(price, minTick, mode);
+}
+
+// Blocking: resolves the contract and waits for its market rule when neither is cached, so
+// even the first order for a symbol goes out on the grid. False if its increment is still
+// unknown afterwards (lookup failed or timed out).
+bool TwsApi::resolvePriceIncrement(const std::string& symbol) {
+    std::shared_ptr<const ContractInfo> info = get_contract_info(symbol);
+    if (info && info->marketRuleId > 0) {
+        requestMarketRule(info->marketRuleId);
+        if (m_marketRules.wait(info->marketRuleId, kRequestTimeout))
+            return true;
     }
+    if (info && info->minTick > 0.0)
+        return true;
+    std::lock_guard<std::mutex> lock(m_tickMutex);
+    auto it = m_tickMinTicks.find(symbol);
+    return it != m_tickMinTicks.end() && it->second > 0.0;
+}
+
+bool TwsApi::roundOrderPrices(const std::string& symbol, bool buy, double& limitPrice, double& stopPrice,
+                              double& takeProfitPrice, double& stopLossPrice) {
+    auto isSet = [](double price) { return price > 0.0 && price != UNSET_DOUBLE; };
+    if ((isSet(limitPrice) || isSet(stopPrice) || isSet(takeProfitPrice) || isSet(stopLossPrice)) &&
+        !resolvePriceIncrement(symbol))
+        return false;
+    // Limits round towards the safe side for the order's action; stops to the nearest tick.
+    limitPrice = roundOrderPrice(symbol, limitPrice, buy ? PriceRounding::Down : PriceRounding::Up);
+    stopPrice = roundOrderPrice(symbol, stopPrice, PriceRounding::Nearest);
+    takeProfitPrice = roundOrderPrice(symbol, takeProfitPrice, buy ? PriceRounding::Up : PriceRounding::Down);
+    stopLossPrice = roundOrderPrice(symbol, stopLossPrice, PriceRounding::Nearest);
+    return true;
+}
 
-    double strike = std::stod(strikeStr) / 1000.0;
+void TwsApi::setContractCacheFile(const std::string& path) {
+    m_contracts.setFile(path, utcDateYmd(std::time(nullptr)));
+}
 
+Contract TwsApi::createOptionContract(const OptionChain& chain, size_t expiry, size_t strike, OptionRight right) {
+    const OptionChain::Expiry& e = chain.expiry(expiry);
     Contract contract;
-    contract.symbol = ticker;
-    contract.lastTradeDateOrContractMonth = "20" + dateStr;
-    contract.strike = strike;
-    contract.right = right;
+    contract.symbol = chain.symbol();
+    contract.lastTradeDateOrContractMonth = std::to_string(e.date);
+    contract.strike = e.strikes[strike];
+    contract.right = right == OptionRight::Call ? "CALL" : "PUT";
     contract.secType = "OPT";
     contract.exchange = "SMART";
     contract.currency = "USD";
-    contract.multiplier = "100";
-
+    contract.tradingClass = e.tradingClass;
+    contract.multiplier = e.multiplier;
     return contract;
 }
 
-
 void TwsApi::nextValidId(OrderId orderId) {
     std::unique_lock<std::mutex> lock(m_mutex);
     m_nextOrderId = orderId;
@@ -622,38 +2402,44 @@ void TwsApi::nextValidId(OrderId orderId) {
 
 // Callback for tick-by-tick trade ticks ("Last").
 void TwsApi::tickByTickAllLast(int reqId, int tickType, time_t time, double price,
-                               Decimal size, const TickAttribLast& tickAttribLast,
-                               const std::string& exchange, const std::string& specialConditions) {
-    Trade trade;
-    {
-        std::lock_guard<std::mutex> lock(m_tickMutex);
-        auto it = m_tickerIdToSymbol.find(reqId);
-        trade.symbol = (it != m_tickerIdToSymbol.end()) ? it->second : "UNKNOWN";
-        trade.trade_price = price;
-        trade.timestamp = time;  // Assuming time_t is already in seconds.
-        trade.size = size;
-        trade.tickType = tickType;
-        // You might want to do something with tickType, size, and tickAttribLast if needed.
-        m_latestTrades.push_back(trade);
-    }
+                               Decimal size, const TickAttribLast& /*tickAttribLast*/,
+                               const std::string& /*exchange*/, const std::string& /*specialConditions*/) {
+    MarketDataEvent event;
+    event.type = MarketDataEventType::TickByTickLast;
+    event.field = tickType;
+    event.tickerId = reqId;
+    event.time = time;  // Assuming time_t is already in seconds.
+    event.price = price;
+    event.size = DecimalFunctions::decimalToDouble(size);
+    pushMarketDataEvent(std::move(event));
 }
 
 // Callback for tick-by-tick bid/ask ticks ("BidAsk").
 void TwsApi::tickByTickBidAsk(int reqId, long time, double bidPrice, double askPrice,
                               int bidSize, int askSize,
-                              const std::string& tickAttribBidAsk) {
-    Quote quote;
-    {
-        std::lock_guard<std::mutex> lock(m_tickMutex);
-        auto it = m_tickerIdToSymbol.find(reqId);
-        quote.symbol = (it != m_tickerIdToSymbol.end()) ? it->second : "UNKNOWN";
-        quote.bid_price = bidPrice;
-        quote.ask_price = askPrice;
-        quote.timestamp = time;
-        quote.askSize = askSize;
-        quote.bidSize = bidSize;
-        m_latestQuotes.push_back(quote);
-    }
+                              const std::string& /*tickAttribBidAsk*/) {
+    MarketDataEvent event;
+    event.type = MarketDataEventType::TickByTickBidAsk;
+    event.tickerId = reqId;
+    event.time = time;
+    event.price = bidPrice;
+    event.size = bidSize;
+    event.askPrice = askPrice;
+    event.askSize = askSize;
+    pushMarketDataEvent(std::move(event));
+}
+
+void TwsApi::tickByTickBidAsk(int reqId, time_t time, double bidPrice, double askPrice,
+                              Decimal bidSize, Decimal askSize, const TickAttribBidAsk& /*tickAttribBidAsk*/) {
+    MarketDataEvent event;
+    event.type = MarketDataEventType::TickByTickBidAsk;
+    event.tickerId = reqId;
+    event.time = time;
+    event.price = bidPrice;
+    event.size = DecimalFunctions::decimalToDouble(bidSize);
+    event.askPrice = askPrice;
+    event.askSize = DecimalFunctions::decimalToDouble(askSize);
+    pushMarketDataEvent(std::move(event));
 }
 
 // Función auxiliar para separar un string con delimitador (coma) en un vector de strings.
@@ -674,6 +2460,7 @@ std::vector<Trade> TwsApi::filterTradesForLastSeconds(const std::string& symbols
     long now = static_cast<long>(time(nullptr));
     long threshold = now - seconds;
 
+    std::lock_guard<std::mutex> lock(m_tickMutex);
     for (const auto& trade : m_latestTrades) {
         if (std::find(symbolList.begin(), symbolList.end(), trade.symbol) != symbolList.end() &&
             trade.timestamp >= threshold) {
@@ -690,6 +2477,7 @@ std::vector<Quote> TwsApi::filterQuotesForLastSeconds(const std::string& symbols
     long now = static_cast<long>(time(nullptr));
     long threshold = now - seconds;
 
+    std::lock_guard<std::mutex> lock(m_tickMutex);
     for (const auto& quote : m_latestQuotes) {
         if (std::find(symbolList.begin(), symbolList.end(), quote.symbol) != symbolList.end() &&
             quote.timestamp >= threshold) {
@@ -701,50 +2489,36 @@ std::vector<Quote> TwsApi::filterQuotesForLastSeconds(const std::string& symbols
 // Example implementation of cancelTickByTickData (you need to call the underlying client).
 void TwsApi::cancelTickByTickData(int tickerId) {
     if (m_client) {
-        m_client->cancelTickByTickData(tickerId);
+        pacedClient()->cancelTickByTickData(tickerId);
     }
 }
 
 
-void TwsApi::tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& attrib) {
-    std::lock_guard<std::mutex> lock(m_tickMutex);
-    auto symbolIt = m_tickerIdToSymbol.find(tickerId);
-    if (symbolIt != m_tickerIdToSymbol.end()) {
-        std::string symbol = symbolIt->second;
-        Quote& quote = m_quotes[tickerId];
-        quote.symbol = symbol;
-        quote.timestamp = std::time(nullptr);
-
-        if (field == BID)
-            quote.bid_price = price;
-        else if (field == ASK)
-            quote.ask_price = price;
-        else if (field == LAST)
-            quote.last_price = price;
-        else if (field == CLOSE)
-            quote.close_price = price;
-    }
-    if (field == BID) m_optionQuotes[tickerId].bidPrice = price;
-    else if (field == ASK) m_optionQuotes[tickerId].ask_price = price;
+void TwsApi::tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& /*attrib*/) {
+    MarketDataEvent event;
+    event.type = MarketDataEventType::Price;
+    event.field = field;
+    event.tickerId = tickerId;
+    event.time = std::time(nullptr);
+    event.price = price;
+    pushMarketDataEvent(std::move(event));
 }
 
 void TwsApi::orderStatus(OrderId orderId, const std::string& status, Decimal /*filled*/,
     Decimal /*remaining*/, double /*avgFillPrice*/, long long /*permId*/, int /*parentId*/,
     double /*lastFillPrice*/, int /*clientId*/, const std::string& /*whyHeld*/, double /*mktCapPrice*/) {
-    // std::unique_lock<std::mutex> lock(m_mutex);
-    // std::string client_order_id = std::to_string(orderId);
-    // OrderResult result;
-    // result.status = status;
-    // result.orderId = orderId;
-    // m_orders[orderId] = result;
-    // std::cout << "dentro de orderStatus" << std::endl;
-    // m_cond.notify_all();
+    OrderEvent event;
+    event.type = OrderEventType::Status;
+    event.order.orderId = orderId;
+    event.order.status = status;
+    pushLossless(m_orderQueue, std::move(event));
 }
 
 
 void TwsApi::openOrder(OrderId orderId, const Contract& contract, const Order& order, const OrderState& orderState) {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    OrderResult result;
+    OrderEvent event;
+    event.type = OrderEventType::OpenOrder;
+    OrderResult& result = event.order;
     result.orderId = orderId;
     result.assetType = contract.secType;
     result.orderRef = order.orderRef;
@@ -754,53 +2528,95 @@ void TwsApi::openOrder(OrderId orderId, const Contract& contract, const Order& o
     }
     else result.symbol = contract.symbol;
     result.side = order.action;
-    result.qty = order.totalQuantity;
+    result.qty = static_cast<int>(DecimalFunctions::decimalToDouble(order.totalQuantity));
     result.orderType = order.orderType;
     result.limit_price = order.lmtPrice;
     result.stop_price = order.auxPrice;
     result.tif = order.tif;
-    m_orders[order.orderId] = result;
+    result.timestamp = std::chrono::system_clock::now();
+    pushLossless(m_orderQueue, std::move(event));
 }
 
 void TwsApi::historicalData(TickerId reqId, const Bar& bar) {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    HistoricalBar hbar;
-    hbar.time = bar.time;
+    HistoricalEvent event;
+    event.type = HistoricalEventType::Bar;
+    event.reqId = reqId;
+    HistoricalBar& hbar = event.bar;
+    hbar.time = parseBarTime(bar.time);  // parsed once here, the dispatch side only sees epoch seconds
+    if (hbar.time < 0) {
+        std::cerr << "error at historicalData: unrecognised bar time '" << bar.time << "'" << std::endl;
+        return;
+    }
     hbar.open = bar.open;
     hbar.high = bar.high;
     hbar.low = bar.low;
     hbar.close = bar.close;
-    hbar.volume = bar.volume;
-    m_historicalData[reqId].push_back(hbar);
+    hbar.volume = static_cast<int64_t>(DecimalFunctions::decimalToDouble(bar.volume));
+    pushLossless(m_historicalQueue, std::move(event));
 }
 
-void TwsApi::historicalDataEnd(int /*reqId*/, const std::string& /*startDateStr*/, const std::string& /*endDateStr*/) {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    m_cond.notify_all();
+void TwsApi::historicalDataUpdate(TickerId reqId, const Bar& bar) {
+    HistoricalEvent event;
+    event.type = HistoricalEventType::Update;
+    event.reqId = static_cast<int>(reqId);
+    HistoricalBar& hbar = event.bar;
+    hbar.time = parseBarTime(bar.time);
+    if (hbar.time < 0) {
+        std::cerr << "error at historicalDataUpdate: unrecognised bar time '" << bar.time << "'" << std::endl;
+        return;
+    }
+    hbar.open = bar.open;
+    hbar.high = bar.high;
+    hbar.low = bar.low;
+    hbar.close = bar.close;
+    hbar.volume = static_cast<int64_t>(DecimalFunctions::decimalToDouble(bar.volume));
+    pushLossless(m_historicalQueue, std::move(event));
+}
+
+void TwsApi::historicalDataEnd(int reqId, const std::string& /*startDateStr*/, const std::string& /*endDateStr*/) {
+    HistoricalEvent event;
+    event.type = HistoricalEventType::End;
+    event.reqId = reqId;
+    pushLossless(m_historicalQueue, std::move(event));
 }
 
 
-void TwsApi::requestMarketData(const std::string& symbol) {
-    Contract contract = createStockContract(symbol);
-    int tickerId = m_nextTickerId++;
+int TwsApi::requestMarketData(const std::string& symbol) {
+    Contract contract = *stockContract(symbol);
+    int tickerId = newTickerId(symbol);
+    pacedClient()->reqMktData(tickerId, contract, "", false, false, TagValueListSPtr());
+    return tickerId;
+}
+
+int TwsApi::newTickerId(const std::string& symbol) {
+    int tickerId = m_requests.nextId();
+    std::lock_guard<std::mutex> lock(m_tickMutex);
     m_tickerIdToSymbol[tickerId] = symbol;
-    m_client->reqMktData(tickerId, contract, "", false, false, TagValueListSPtr());
+    return tickerId;
 }
 
 void TwsApi::cancelMarketData(int tickerId) {
-    m_client->cancelMktData(tickerId);
+    pacedClient()->cancelMktData(tickerId);
+    std::lock_guard<std::mutex> lock(m_tickMutex);
+    m_volSurfaceFeeds.erase(tickerId);
 }
 
 double TwsApi::getCashBalance() {
-    std::unique_lock<std::mutex> lock(m_accountMutex);
-    m_accountSummaryReceived = false;  // Reset flag before making the request
-
-    m_client->reqAccountSummary(9001, "All", "TotalCashValue");
-
-    m_accountCondVar.wait(lock, [this]() { return m_accountSummaryReceived; });
-
-    m_client->cancelAccountSummary(9001);
+    auto state = m_accountState.snapshot();
+    if (state->streaming)
+        return state->totalCashValue;  // streamed by subscribe_account_updates
+    int reqId = m_requests.nextId();
+    auto done = m_requests.track(reqId, kRequestTimeout);
+    pacedClient()->reqAccountSummary(reqId, "All", "TotalCashValue");
+
+    RequestResult status = done.get();
+    pacedClient()->cancelAccountSummary(reqId);
+    if (!status.ok()) {
+        std::cerr << "error at getCashBalance: " << status.message << std::endl;
+        return 0.0;
+    }
 
+    std::lock_guard<std::mutex> lock(m_accountMutex);
     auto it = m_accountValues.find("TotalCashValue");
     if (it != m_accountValues.end()) {
         return std::stod(it->second);
@@ -808,17 +2624,88 @@ double TwsApi::getCashBalance() {
     return 0.0;
 }
 
+std::vector<ContractDetails> TwsApi::get_contract_details(const Contract& contract) {
+    int reqId = m_requests.nextId();
+    auto done = m_requests.track(reqId, kRequestTimeout);
+    pacedClient()->reqContractDetails(reqId, contract);
+
+    RequestResult status = done.get();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<ContractDetails> details = std::move(m_contractDetails[reqId]);
+    m_contractDetails.erase(reqId);
+    if (!status.ok())
+        std::cerr << "error at get_contract_details: " << contract.symbol << ": " << status.message << std::endl;
+    return details;
+}
 
-void TwsApi::accountSummary(int reqId, const std::string& account, const std::string& tag, const std::string& value, const std::string& currency) {
-    if (reqId == 9001) {
-        {
-            std::lock_guard<std::mutex> lock(m_accountMutex);
-            m_accountValues[tag] = value;
-            m_accountSummaryReceived = true;
+std::shared_ptr<const OptionChain> TwsApi::get_option_chain(const std::string& symbol) {
+    const int32_t today = utcDateYmd(std::time(nullptr));
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_optionChains.find(symbol);
+        if (it != m_optionChains.end() && it->second->fetchedDate() == today)
+            return it->second;
+        if (!m_optionChainDirectory.empty())
+            path = m_optionChainDirectory + "/" + symbol + ".chain";
+    }
+    if (!path.empty()) {
+        auto chain = std::make_shared<const OptionChain>(OptionChain::load(path));
+        if (!chain->empty() && chain->fetchedDate() == today) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_optionChains[symbol] = chain;
+            return chain;
         }
-        m_accountCondVar.notify_one();
-        std::cout << "Account Summary Received: " << tag << " = " << value << " " << currency << std::endl;
     }
+
+    // reqSecDefOptParams wants the underlying's conId.
+    std::shared_ptr<const ContractInfo> underlying = get_contract_info(symbol);
+    if (!underlying) {
+        std::cerr << "error at get_option_chain: " << symbol << ": underlying not found" << std::endl;
+        return nullptr;
+    }
+    const int conId = static_cast<int>(underlying->contract.conId);
+
+    int reqId = m_requests.nextId();
+    auto done = m_requests.track(reqId, kRequestTimeout);
+    pacedClient()->reqSecDefOptParams(reqId, symbol, "", "STK", conId);
+    RequestResult status = done.get();
+
+    std::vector<OptionChainParams> rows;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        rows = std::move(m_secDefParams[reqId]);
+        m_secDefParams.erase(reqId);
+    }
+    if (!status.ok() || rows.empty()) {
+        std::cerr << "error at get_option_chain: " << symbol << ": "
+                  << (status.ok() ? "no option parameters" : status.message) << std::endl;
+        return nullptr;
+    }
+
+    auto chain = std::make_shared<const OptionChain>(OptionChain::build(symbol, conId, rows, today));
+    if (!path.empty())
+        chain->save(path);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_optionChains[symbol] = chain;
+    return chain;
+}
+
+void TwsApi::accountSummary(int reqId, const std::string& /*account*/, const std::string& tag, const std::string& value, const std::string& currency) {
+    AccountEvent event;
+    event.type = AccountEventType::Summary;
+    event.reqId = reqId;
+    event.tag = tag;
+    event.value = value;
+    event.currency = currency;
+    pushLossless(m_accountQueue, std::move(event));
+}
+
+void TwsApi::accountSummaryEnd(int reqId) {
+    AccountEvent event;
+    event.type = AccountEventType::SummaryEnd;
+    event.reqId = reqId;
+    pushLossless(m_accountQueue, std::move(event));
 }
 
 
@@ -831,15 +2718,57 @@ void TwsApi::tickString(TickerId, TickType, const std::string&) { }
 void TwsApi::tickEFP(TickerId, TickType, double, const std::string&, double, int, const std::string&, double, double) { }
 void TwsApi::winError(const std::string&, int) { }
 void TwsApi::connectionClosed() { }
-void TwsApi::updatePortfolio(const Contract&, Decimal, double, double, double, double, double, const std::string&) { }
-void TwsApi::updateAccountTime(const std::string&) { }
-void TwsApi::accountDownloadEnd(const std::string&) { }
-void TwsApi::contractDetails(int, const ContractDetails&) { }
+void TwsApi::updatePortfolio(const Contract& contract, Decimal position, double marketPrice, double marketValue,
+        double averageCost, double unrealizedPNL, double realizedPNL, const std::string& accountName) {
+    AccountEvent event;
+    event.type = AccountEventType::Portfolio;
+    event.account = accountName;
+    PortfolioRow& row = event.row;
+    if (contract.secType == "STK") row.symbol = contract.symbol;
+    else row.symbol = removeSpaces(contract.localSymbol);
+    row.conId = contract.conId;
+    row.secType = contract.secType;
+    row.position = DecimalFunctions::decimalToDouble(position);
+    row.marketPrice = marketPrice;
+    row.marketValue = marketValue;
+    row.averageCost = averageCost;
+    row.unrealizedPnl = unrealizedPNL;
+    row.realizedPnl = realizedPNL;
+    pushLossless(m_accountQueue, std::move(event));
+}
+void TwsApi::updateAccountTime(const std::string& timeStamp) {
+    AccountEvent event;
+    event.type = AccountEventType::Time;
+    event.tag = timeStamp;
+    pushLossless(m_accountQueue, std::move(event));
+}
+void TwsApi::accountDownloadEnd(const std::string& accountName) {
+    AccountEvent event;
+    event.type = AccountEventType::DownloadEnd;
+    event.account = accountName;
+    pushLossless(m_accountQueue, std::move(event));
+}
+// Reference data is rare and small, so it is stored directly from the reader thread.
+void TwsApi::contractDetails(int reqId, const ContractDetails& contractDetails) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_contractDetails[reqId].push_back(contractDetails);
+}
 void TwsApi::bondContractDetails(int, const ContractDetails&) { }
-void TwsApi::contractDetailsEnd(int) { }
+void TwsApi::contractDetailsEnd(int reqId) {
+    m_requests.complete(reqId);
+}
 void TwsApi::execDetails(int, const Contract&, const Execution&) { }
 void TwsApi::execDetailsEnd(int) { }
 void TwsApi::error(int id, time_t errorTime, int errorCode, const std::string& errorString, const std::string& advancedOrderRejectJson) {
+    // Fail the matching pending request right away instead of letting it run into its timeout.
+    // Codes 2100-2199 and 10167 are informational (farm status, delayed data) and not failures.
+    // Ids below kFirstRequestId are order ids and must not fail an unrelated request.
+    bool warning = (errorCode >= 2100 && errorCode < 2200) || errorCode == 10167;
+    if (id >= kFirstRequestId && !warning) {
+        const std::string message = std::to_string(errorCode) + " " + errorString;
+        if (!m_requests.fail(id, message))
+            failPnlLine(id, message);  // standing subscriptions have no pending entry
+    }
     // std::unique_lock<std::mutex> lock(m_mutex);
     // // ANSI escape code for green text: "\033[32m"
     // // Reset code: "\033[0m"
@@ -850,7 +2779,10 @@ void TwsApi::error(int id, time_t errorTime, int errorCode, const std::string& e
 void TwsApi::updateMktDepth(TickerId, int, int, int, double, Decimal) { }
 void TwsApi::updateMktDepthL2(TickerId, int, const std::string&, int, int, double, Decimal, bool) { }
 void TwsApi::updateNewsBulletin(int, int, const std::string&, const std::string&) { }
-void TwsApi::managedAccounts(const std::string&) { }
+void TwsApi::managedAccounts(const std::string& accountsList) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_managedAccount = accountsList.substr(0, accountsList.find(','));
+}
 void TwsApi::receiveFA(faDataType, const std::string&) { }
 void TwsApi::scannerParameters(const std::string&) { }
 void TwsApi::scannerData(int, int, const ContractDetails&, const std::string&, const std::string&, const std::string&, const std::string&) { }
@@ -860,19 +2792,36 @@ void TwsApi::realtimeBar(TickerId reqId, long time, double open, double high, do
 void TwsApi::currentTime(long) { }
 void TwsApi::fundamentalData(TickerId, const std::string&) { }
 void TwsApi::deltaNeutralValidation(int, const DeltaNeutralContract&) { }
-void TwsApi::tickSnapshotEnd(int) { }
+void TwsApi::tickSnapshotEnd(int reqId) {
+    // Routed through the market data queue so it is applied after the snapshot's ticks.
+    MarketDataEvent event;
+    event.type = MarketDataEventType::SnapshotEnd;
+    event.tickerId = reqId;
+    pushMarketDataEvent(std::move(event));
+}
 void TwsApi::marketDataType(TickerId, int) { }
 void TwsApi::commissionAndFeesReport(const CommissionAndFeesReport&) { }
-void TwsApi::position(const std::string& /*account*/, const Contract& contract, Decimal position, double avgCost) {
-    Position pos;
+void TwsApi::position(const std::string& account, const Contract& contract, Decimal position, double avgCost) {
+    AccountEvent event;
+    event.type = AccountEventType::Position;
+    Position& pos = event.position;
     if (contract.secType == "STK") pos.symbol = contract.symbol;
     else pos.symbol = removeSpaces(contract.localSymbol);
-    pos.qty = static_cast<int>(position);
+    pos.qty = static_cast<int>(DecimalFunctions::decimalToDouble(position));
+    pos.conId = contract.conId;
+    pos.account = account;
     pos.avgCost = avgCost;
-    m_positions.push_back(pos);
+    event.underlying = contract.symbol;
+    event.option = contract.secType == "OPT";
+    if (!contract.multiplier.empty())
+        event.multiplier = std::atof(contract.multiplier.c_str());
+    pushLossless(m_accountQueue, std::move(event));
+}
+void TwsApi::positionEnd() {
+    AccountEvent event;
+    event.type = AccountEventType::PositionEnd;
+    pushLossless(m_accountQueue, std::move(event));
 }
-void TwsApi::positionEnd() { }
-void TwsApi::accountSummaryEnd(int) { }
 void TwsApi::verifyMessageAPI(const std::string&) { }
 void TwsApi::verifyCompleted(bool, const std::string&) { }
 void TwsApi::displayGroupList(int, const std::string&) { }
@@ -884,31 +2833,96 @@ void TwsApi::positionMulti(int reqId, const std::string& account, const std::str
 void TwsApi::positionMultiEnd(int) { }
 void TwsApi::accountUpdateMulti(int, const std::string&, const std::string&, const std::string&, const std::string&, const std::string&) { }
 void TwsApi::accountUpdateMultiEnd(int) { }
-void TwsApi::securityDefinitionOptionalParameter(int, const std::string&, int, const std::string&, const std::string&, const std::set<std::string>&, const std::set<double>&) { }
-void TwsApi::securityDefinitionOptionalParameterEnd(int) { }
+void TwsApi::securityDefinitionOptionalParameter(int reqId, const std::string& exchange, int underlyingConId,
+                                                 const std::string& tradingClass, const std::string& multiplier,
+                                                 const std::set<std::string>& expirations, const std::set<double>& strikes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_secDefParams[reqId].push_back({exchange, underlyingConId, tradingClass, multiplier, expirations, strikes});
+}
+void TwsApi::securityDefinitionOptionalParameterEnd(int reqId) {
+    m_requests.complete(reqId);
+}
 void TwsApi::softDollarTiers(int, const std::vector<SoftDollarTier>&) { }
 void TwsApi::familyCodes(const std::vector<FamilyCode>&) { }
 void TwsApi::symbolSamples(int, const std::vector<ContractDescription>&) { }
 void TwsApi::mktDepthExchanges(const std::vector<DepthMktDataDescription>&) { }
 void TwsApi::tickNews(int, time_t, const std::string&, const std::string&, const std::string&, const std::string&) { }
 void TwsApi::smartComponents(int, const SmartComponentsMap&) { }
-void TwsApi::tickReqParams(int, double, const std::string&, int) { }
+void TwsApi::tickReqParams(int tickerId, double minTick, const std::string&, int) {
+    if (!(minTick > 0.0))
+        return;
+    std::lock_guard<std::mutex> lock(m_tickMutex);
+    auto it = m_tickerIdToSymbol.find(tickerId);
+    if (it != m_tickerIdToSymbol.end())
+        m_tickMinTicks[it->second] = minTick;
+}
 void TwsApi::newsProviders(const std::vector<NewsProvider>&) { }
 void TwsApi::newsArticle(int, int, const std::string&) { }
 void TwsApi::historicalNews(int, const std::string&, const std::string&, const std::string&, const std::string&) { }
 void TwsApi::historicalNewsEnd(int, bool) { }
-void TwsApi::headTimestamp(int, const std::string&) { }
+void TwsApi::headTimestamp(int reqId, const std::string& headTimestamp) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_headTimestampReplies[reqId] = headTimestamp;
+    }
+    m_requests.complete(reqId);
+}
 void TwsApi::histogramData(int, const HistogramDataVector&) { }
-void TwsApi::historicalDataUpdate(TickerId, const Bar&) { }
 void TwsApi::rerouteMktDataReq(int, int, const std::string&) { }
 void TwsApi::rerouteMktDepthReq(int, int, const std::string&) { }
-void TwsApi::marketRule(int, const std::vector<PriceIncrement>&) { }
-void TwsApi::pnl(int, double, double, double) { }
-void TwsApi::pnlSingle(int, Decimal, double, double, double, double) { }
-void TwsApi::historicalTicks(int, const std::vector<HistoricalTick>&, bool) { }
-void TwsApi::historicalTicksBidAsk(int, const std::vector<HistoricalTickBidAsk>&, bool) { }
-void TwsApi::historicalTicksLast(int, const std::vector<HistoricalTickLast>&, bool) { }
-void TwsApi::tickByTickBidAsk(int, time_t, double, double, Decimal, Decimal, const TickAttribBidAsk&) { }
+void TwsApi::marketRule(int marketRuleId, const std::vector<PriceIncrement>& priceIncrements) {
+    std::vector<std::pair<double, double>> rungs;
+    rungs.reserve(priceIncrements.size());
+    for (const PriceIncrement& p : priceIncrements)
+        rungs.emplace_back(p.lowEdge, p.increment);
+    m_marketRules.store(marketRuleId, PriceLadder(rungs));
+}
+void TwsApi::pnl(int reqId, double dailyPnL, double unrealizedPnL, double realizedPnL) {
+    AccountEvent event;
+    event.type = AccountEventType::Pnl;
+    event.reqId = reqId;
+    event.pnl = PnlValues{pnlValue(dailyPnL), pnlValue(unrealizedPnL), pnlValue(realizedPnL)};
+    pushLossless(m_accountQueue, std::move(event));
+}
+void TwsApi::pnlSingle(int reqId, Decimal pos, double dailyPnL, double unrealizedPnL, double realizedPnL, double value) {
+    AccountEvent event;
+    event.type = AccountEventType::PnlSingle;
+    event.reqId = reqId;
+    event.row.position = DecimalFunctions::decimalToDouble(pos);
+    event.row.marketValue = pnlValue(value);
+    event.pnl = PnlValues{pnlValue(dailyPnL), pnlValue(unrealizedPnL), pnlValue(realizedPnL)};
+    pushLossless(m_accountQueue, std::move(event));
+}
+void TwsApi::historicalTicks(int reqId, const std::vector<HistoricalTick>& ticks, bool done) {
+    appendTickPage(reqId, ticks, done, [](TickColumns& out, const HistoricalTick& tick) {
+        out.price.push_back(tick.price);
+        out.size.push_back(DecimalFunctions::decimalToDouble(tick.size));
+        out.attribs.push_back(0);
+    });
+}
+
+void TwsApi::historicalTicksBidAsk(int reqId, const std::vector<HistoricalTickBidAsk>& ticks, bool done) {
+    appendTickPage(reqId, ticks, done, [](TickColumns& out, const HistoricalTickBidAsk& tick) {
+        out.price.push_back(tick.priceBid);
+        out.size.push_back(DecimalFunctions::decimalToDouble(tick.sizeBid));
+        out.askPrice.push_back(tick.priceAsk);
+        out.askSize.push_back(DecimalFunctions::decimalToDouble(tick.sizeAsk));
+        out.attribs.push_back((tick.tickAttribBidAsk.bidPastLow ? TickColumns::PastLimit : 0)
+                            | (tick.tickAttribBidAsk.askPastHigh ? TickColumns::Unreported : 0));
+    });
+}
+
+void TwsApi::historicalTicksLast(int reqId, const std::vector<HistoricalTickLast>& ticks, bool done) {
+    appendTickPage(reqId, ticks, done, [](TickColumns& out, const HistoricalTickLast& tick) {
+        out.price.push_back(tick.price);
+        out.size.push_back(DecimalFunctions::decimalToDouble(tick.size));
+        out.exchange.push_back(out.internExchange(tick.exchange));
+        out.conditions.push_back(conditionsMask(tick.specialConditions));
+        out.attribs.push_back((tick.tickAttribLast.pastLimit ? TickColumns::PastLimit : 0)
+                            | (tick.tickAttribLast.unreported ? TickColumns::Unreported : 0));
+    });
+}
+
 void TwsApi::tickByTickMidPoint(int, time_t, double) { }
 void TwsApi::orderBound(long long, int, int) { }
 void TwsApi::completedOrder(const Contract&, const Order&, const OrderState&) { }
@@ -916,10 +2930,42 @@ void TwsApi::completedOrdersEnd() { }
 void TwsApi::replaceFAEnd(int, const std::string&) { }
 void TwsApi::wshMetaData(int, const std::string&) { }
 void TwsApi::wshEventData(int, const std::string&) { }
-void TwsApi::historicalSchedule(int, const std::string&, const std::string&, const std::string&, const std::vector<HistoricalSession>&) { }
+void TwsApi::historicalSchedule(int reqId, const std::string&, const std::string&, const std::string& timeZone,
+                                const std::vector<HistoricalSession>& sessions) {
+    // Session times are exchange-local ("20250324-09:30:00" in timeZone).
+    std::shared_ptr<const TimeZone> zone = TimeZone::find(timeZone);
+    if (!zone) {
+        m_requests.fail(reqId, "unknown time zone " + timeZone);
+        return;
+    }
+    std::vector<TradingSession> out;
+    out.reserve(sessions.size());
+    for (const auto& s : sessions) {
+        const time_t start = parseIbDateTime(s.startDateTime);
+        const time_t end = parseIbDateTime(s.endDateTime);
+        const time_t day = parseIbDateTime(s.refDate);
+        if (start < 0 || end < 0 || day < 0)
+            continue;
+        out.push_back({zone->toUtc(start), zone->toUtc(end), day});
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_scheduleReplies[reqId] = std::move(out);
+    }
+    m_requests.complete(reqId);
+}
 void TwsApi::userInfo(int, const std::string&) { }
-void TwsApi::currentTimeInMillis(time_t) { }
+void TwsApi::currentTimeInMillis(time_t timeInMillis) {
+    m_linkMonitor.onServerTime(static_cast<int64_t>(timeInMillis));
+}
 void TwsApi::updateAccountValue(const std::string& key, const std::string& val,
-        const std::string& currency, const std::string& accountName) { } ;
-    // Empty implementation for now.
+        const std::string& currency, const std::string& accountName) {
+    AccountEvent event;
+    event.type = AccountEventType::Value;
+    event.tag = key;
+    event.value = val;
+    event.currency = currency;
+    event.account = accountName;
+    pushLossless(m_accountQueue, std::move(event));
+}
 
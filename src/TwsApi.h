@@ -11,14 +11,40 @@
 #include <ctime>  // for time()
 #include <iomanip>
 #include <iostream>
+#include <atomic>
+#include <thread>
+#include <functional>
 
 
 #include "EWrapper.h"
 #include "EClientSocket.h"
-#include "EReaderOSSignal.h"  // Added to support asynchronous message processing
+#include "ReaderSignal.h"
 #include "Contract.h"
 #include "Order.h"
 #include "Decimal.h"
+#include "SpscQueue.h"
+#include "WaitStrategy.h"
+#include "RequestRegistry.h"
+#include "Executor.h"
+#include "Task.h"
+#include "AsyncRequest.h"
+#include "LinkMonitor.h"
+#include "HistoricalPlanner.h"
+#include "BarSeries.h"
+#include "BarCache.h"
+#include "HistoricalPacer.h"
+#include "MessagePacer.h"
+#include "TimeZone.h"
+#include "TickColumns.h"
+#include "OptionChain.h"
+#include "GreeksStore.h"
+#include "OptionPricer.h"
+#include "VolSurface.h"
+#include "ContractCache.h"
+#include "PriceIncrements.h"
+#include "AccountState.h"
+#include "PnlTable.h"
+#include <set>
 
 struct OrderResult {
     OrderId orderId = 0;
@@ -33,6 +59,7 @@ struct OrderResult {
     double stop_price = 0.0;
     std::string assetType = "";
     std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::time_point{};
+    double linkRttUs = 0.0;  // heartbeat RTT when the last status update was applied
 
 };
 
@@ -40,7 +67,7 @@ struct OptionQuote {
     std::string symbol;
     double bidPrice = 0.0;
     double ask_price = 0.0;
-    Decimal volume = 0;
+    double volume = 0.0;
     double impliedVolatility = 0.0;
 };
 
@@ -49,6 +76,8 @@ struct Position {
     std::string symbol;
     int qty;
     double avgCost;
+    long conId = 0;
+    std::string account;
 };
 
 struct Quote {
@@ -71,13 +100,132 @@ struct Trade {
 };
 
 
-struct HistoricalBar {
-    std::string time;
-    double open;
-    double high;
-    double low;
-    double close;
-    long volume;
+struct HistoricalRangeResult {
+    BarSeries bars;                   // ascending, de-duplicated
+    size_t chunks = 0;
+    size_t failedChunks = 0;
+    size_t cachedBars = 0;            // served from the on-disk cache instead of TWS
+    double seconds = 0.0;
+    double barsPerSecond = 0.0;
+};
+
+// One keepUpToDate subscription. `bars` holds the initial history followed by every
+// historicalDataUpdate merged in place: an update stamped with the last bar's time replaces
+// it (that bar is still forming), a later time appends a bar (the previous one is final).
+struct LiveBarSeries {
+    std::string symbol;
+    std::string barSize;
+    BarSeries bars;
+    bool ready = false;     // initial history received
+    uint64_t updates = 0;   // historicalDataUpdate messages merged
+    uint64_t rolls = 0;     // updates that started a new bar
+};
+
+// Called on the historical dispatch thread after each merge, with the index of the first bar
+// that changed (0 once the initial history is in). It runs under the series lock and must
+// not call back into TwsApi.
+using LiveBarHandler = std::function<void(const BarSeries& bars, size_t firstChanged)>;
+
+struct HistoricalTicksResult {
+    TickColumns ticks;                // ascending by time, no duplicates across pages
+    size_t pages = 0;
+    size_t failedPages = 0;
+    double seconds = 0.0;
+    double ticksPerSecond = 0.0;
+};
+
+// --- Dispatch events ---
+// The reader thread only decodes callbacks into these events and pushes them onto the
+// per-domain queues; the dispatch threads apply them to the shared state.
+
+enum class MarketDataEventType : uint8_t { Price, Size, OptionComputation, TickByTickLast, TickByTickBidAsk, SnapshotEnd };
+
+// One contract of a bulk snapshot (TwsApi::get_option_snapshots). Prices are as TWS sent
+// them (-1 means no market on that side); `fields` tells which ones arrived at all.
+struct OptionSnapshot {
+    enum Field : uint8_t {
+        Bid = 1,
+        Ask = 2,
+        Last = 4,
+        Volume = 8,
+        Model = 16,           // model option computation (price, IV, greeks)
+    };
+
+    std::string symbol;       // OCC-style, e.g. AAPL250321C00170000
+    double bid = 0.0;
+    double ask = 0.0;
+    double last = 0.0;
+    double bidSize = 0.0;
+    double askSize = 0.0;
+    double volume = 0.0;
+    OptionComputation model;
+    uint8_t fields = 0;
+    bool complete = false;    // every required field arrived before the timeout
+    std::string error;        // TWS error or timeout, if the contract did not complete
+};
+
+struct OptionSnapshotResult {
+    std::vector<OptionSnapshot> snapshots;  // in request order
+    size_t completed = 0;
+    size_t failed = 0;                      // rejected by TWS (bad contract, no permissions)
+    double seconds = 0.0;
+};
+
+struct MarketDataEvent {
+    MarketDataEventType type = MarketDataEventType::Price;
+    int field = 0;            // TickType, or tick-by-tick type for TickByTickLast
+    TickerId tickerId = 0;
+    time_t time = 0;
+    double price = 0.0;       // price, or bid price for TickByTickBidAsk
+    double size = 0.0;        // size, or bid size for TickByTickBidAsk
+    double askPrice = 0.0;
+    double askSize = 0.0;
+    OptionComputation computation;
+};
+
+enum class OrderEventType : uint8_t { OpenOrder, Status };
+
+struct OrderEvent {
+    OrderEventType type = OrderEventType::OpenOrder;
+    OrderResult order;        // full order for OpenOrder, orderId + status for Status
+};
+
+enum class AccountEventType : uint8_t {
+    Position, PositionEnd, Summary, SummaryEnd,
+    Value, Portfolio, Time, DownloadEnd,  // reqAccountUpdates
+    Pnl, PnlSingle,                       // reqPnL, reqPnLSingle
+};
+
+struct AccountEvent {
+    AccountEventType type = AccountEventType::Position;
+    int reqId = 0;
+    Position position;
+    std::string underlying;   // Position: contract symbol, for greek aggregation
+    double multiplier = 1.0;
+    bool option = false;
+    std::string tag;          // Summary and Value: key; Time: time stamp
+    std::string value;
+    std::string currency;
+    std::string account;      // Value, Portfolio and DownloadEnd
+    PortfolioRow row;         // Portfolio; PnlSingle: position and marketValue
+    PnlValues pnl;            // Pnl and PnlSingle
+};
+
+enum class HistoricalEventType : uint8_t { Bar, Update, End };
+
+struct HistoricalEvent {
+    HistoricalEventType type = HistoricalEventType::Bar;
+    int reqId = 0;
+    HistoricalBar bar;
+};
+
+struct QueueStats {
+    std::string domain;
+    size_t depth = 0;
+    size_t capacity = 0;
+    uint64_t pushed = 0;
+    uint64_t dropped = 0;     // market data only: ticks discarded because the queue was full
+    uint64_t fullWaits = 0;   // lossless domains: times the reader had to wait for room
 };
 
 class TwsApi : public EWrapper {
@@ -89,6 +237,12 @@ public:
     bool connect(const std::string& host, int port, int clientId);
     void disconnect();
 
+    // Wait strategy and CPU affinity of the reader and dispatch threads. Takes effect on the
+    // next connect(); refused while connected.
+    void setReaderConfig(const ReaderConfig& config);
+    // Heartbeat interval and stall threshold of the link monitor. Takes effect on the next connect().
+    void setLinkMonitorConfig(const LinkMonitorConfig& config);
+
     // Order functions (stocks and options)
     OrderResult submit_order_stock(const std::string& symbol, int qty, const std::string& side,
     const std::string& type, const std::string& time_in_force,
@@ -149,9 +303,33 @@ public:
                   << "  assetType: " << order.assetType << "\n"
                   << "}" << std::endl;
     }
-    // Position functions
-    std::vector<Position> list_positions();
-    Position get_position(const std::string& symbol);
+    // Position functions. The first call subscribes with reqPositions and waits for
+    // positionEnd; from then on the subscription keeps an in-memory map current, so these
+    // calls are plain reads. Every managed account has its own rows; with an empty `account`
+    // the lookups return the row of the first account (by name) holding the contract.
+    std::vector<Position> list_positions();  // sorted by symbol, then account
+    Position get_position(const std::string& symbol, const std::string& account = "");
+    Position get_position_by_conid(long conId, const std::string& account = "");
+
+    // Account updates (reqAccountUpdates). Subscribes `account` (the first managed account if
+    // empty) and waits for accountDownloadEnd; true once the state is complete. From then on TWS
+    // pushes every change (values about every three minutes, portfolio rows as prices move)
+    // into the state getAccountState() returns. Only one account streams at a time.
+    bool subscribe_account_updates(const std::string& account = "");
+    void unsubscribe_account_updates();
+    // Mutex-free (see AccountState): the latest published snapshot, empty before the first subscription.
+    std::shared_ptr<const AccountSnapshot> getAccountState() const { return m_accountState.snapshot(); }
+
+    // Real-time P&L. subscribe_pnl opens reqPnL for `account` (the first managed account if
+    // empty) and, from the position subscription, one reqPnLSingle line per open position:
+    // lines are added as positions open and cancelled when they go flat. TWS pushes updates
+    // about once a second into the table getPnl() returns without taking a mutex.
+    bool subscribe_pnl(const std::string& account = "");
+    void unsubscribe_pnl();
+    std::shared_ptr<const PnlSnapshot> getPnl() const { return m_pnl.snapshot(); }
+    // Threshold alerts on the account or one position; see PnlAlert.
+    int addPnlAlert(const PnlAlert& alert, PnlAlertHandler handler) { return m_pnl.addAlert(alert, std::move(handler)); }
+    void removePnlAlert(int alertId) { m_pnl.removeAlert(alertId); }
 
     // Market data (quotes and trades)
     void subscribe_stock_quotes(const std::string& symbols);
@@ -160,27 +338,131 @@ public:
     void subscribe_option_trades(const std::string& symbols);
     void subscribe_option_quotes(const std::string& symbols);
 
-    void requestOptionMarketData(const std::string& optionSymbol);
+    int requestOptionMarketData(const std::string& optionSymbol);  // returns the ticker id, -1 if the symbol is malformed
 
     OptionQuote getOptionQuote(const std::string& optionSymbol);
+    // Quotes many option contracts at once. Up to maxLines market data lines are open at a time
+    // (accounts get 100 lines by default, shared with every other subscription). Each contract
+    // is finished and its line cancelled as soon as all requiredFields have arrived (or on
+    // tickSnapshotEnd), and requests are paced under the API limit of 50 messages per second.
+    // Contracts that time out come back with whatever arrived and complete = false.
+    OptionSnapshotResult get_option_snapshots(const std::vector<Contract>& contracts, int maxLines = 50,
+        uint8_t requiredFields = OptionSnapshot::Bid | OptionSnapshot::Ask | OptionSnapshot::Model);
+    // Latest option computation TWS sent for a ticker of requestOptionMarketData/getOptionQuote,
+    // per source (bid, ask, last or model quote).
+    std::optional<OptionComputation> getOptionGreeks(int tickerId, GreekSource source = GreekSource::Model);
+    // Net delta, gamma, vega and theta per underlying and for the whole book: positions from
+    // list_positions() weighted with the greeks of the option tickers streaming them. Kept
+    // current on every option computation tick.
+    PortfolioGreeks getPortfolioGreeks();
+    // Implied volatility and greeks of every strike of `symbol` expiring in [fromExpiry, toExpiry]
+    // (YYYYMMDD), computed in-process from bid/ask mids quoted with get_option_snapshots. The
+    // spot is the stock's streamed quote when it is subscribed and ticked within kLiveQuoteSeconds,
+    // otherwise a one-off snapshot of the stock, and failing that the median underlying price of
+    // any model computations the option snapshots caught. Indexed by the slots of get_option_chain(symbol).
+    ChainGreeks get_chain_greeks(const std::string& symbol, int32_t fromExpiry, int32_t toExpiry,
+                                 double rate = 0.0, double dividendYield = 0.0, int maxLines = 50);
+    // Implied volatility surface of an underlying, created on the grid of its option chain on
+    // first use. From then on it is fed the model IV of every option of that underlying streamed
+    // with requestOptionMarketData/getOptionQuote and the IVs get_chain_greeks computes.
+    // Returns nullptr if the chain is not available.
+    std::shared_ptr<VolSurface> get_vol_surface(const std::string& symbol);
 
     // Order modification and query
     OrderResult change_order_by_order_id(OrderId order_id,
     int qty, std::string time_in_force,
     std::optional<double> limit_price, std::optional<double> stop_price);
 
-    void requestMarketData(const std::string& symbol);
+    int requestMarketData(const std::string& symbol);  // returns the ticker id
     void cancelMarketData(int tickerId);
 
     // Historical data (for stocks)
-    std::vector<HistoricalBar> get_historical_data_stocks(const std::string& symbol,
+    BarSeries get_historical_data_stocks(const std::string& symbol,
       const std::string& start, const std::string& end, int limit);
+    // Fetches an arbitrary [start, end) window by splitting it into chunks TWS accepts for the
+    // bar size and keeping up to maxInFlight of them outstanding at once.
+    HistoricalRangeResult get_historical_range(const HistoricalQuery& query, int maxInFlight = 4);
+    // Enables the on-disk bar cache for get_historical_range (empty = disabled). Ranges already
+    // fetched are served from disk and only the missing gaps are requested. Call before use.
+    void setBarCacheDirectory(const std::string& directory);
+    // Earliest time TWS has data for (reqHeadTimestamp), cached per symbol, whatToShow and RTH
+    // setting in memory and in the bar cache directory. Range fetches clip their start to it.
+    // Returns -1 on failure.
+    time_t get_head_timestamp(const std::string& symbol, const std::string& whatToShow = "TRADES", bool useRTH = true);
+    // Trading sessions overlapping [start, end) ("SCHEDULE" request), cached in memory per
+    // symbol and RTH setting. Range fetches use it to skip weekends and holidays.
+    std::optional<std::vector<TradingSession>> get_trading_schedule(const std::string& symbol,
+        time_t start, time_t end, bool useRTH = true);
+    // Stretches of the query where the schedule expects bars that the cache does not have
+    // (needs setBarCacheDirectory). See findBarGaps for minMissingBars.
+    std::vector<TimeRange> find_historical_gaps(const HistoricalQuery& query, size_t minMissingBars = 1);
+    // Requests only those stretches (nearby ones share a request) and stores them in the
+    // cache. `bars` of the result holds just the refetched bars.
+    HistoricalRangeResult backfill_historical_gaps(const HistoricalQuery& query, size_t minMissingBars = 1,
+                                                   int maxInFlight = 4);
+    // All historical requests go through a scheduler that enforces the IB pacing rules
+    // (60 per 10 minutes, identical requests 15 s apart, at most 5 per contract in 2 s).
+    // Expected time until every chunk of the query would have been sent, given the current queue.
+    std::chrono::milliseconds estimateHistoricalWait(const HistoricalQuery& query) const;
+    PacingStats getHistoricalPacingStats() const;
+    // Live bar series: `duration` of history (e.g. "1 D") that TWS then keeps current with
+    // historicalDataUpdate. Blocks until the history has arrived and returns the subscription
+    // id, or -1 on failure. Bar sizes below "5 secs" are not accepted by TWS in this mode.
+    int subscribeLiveBars(const std::string& symbol, const std::string& duration, const std::string& barSize,
+        const std::string& whatToShow = "TRADES", bool useRTH = true, LiveBarHandler onChange = nullptr);
+    void cancelLiveBars(int id);
+    // Runs fn on the subscription's series under its lock. Returns false for an unknown id.
+    bool withLiveBars(int id, const std::function<void(const LiveBarSeries&)>& fn);
+    // Pages through reqHistoricalTicks (1000 ticks per request) over [start, end) and appends
+    // every page into one set of columns. whatToShow is TRADES, BID_ASK or MIDPOINT;
+    // reserveTicks presizes the columns (a liquid stock prints several hundred thousand
+    // trades a day).
+    HistoricalTicksResult get_historical_ticks(const std::string& symbol, time_t start, time_t end,
+        const std::string& whatToShow = "TRADES", bool useRTH = false, size_t reserveTicks = 0);
 
     // NEW: Request all open orders from TWS.
     void reqAllOpenOrders();
 
     double getCashBalance() ;
 
+    // Resolves a (possibly partial) contract into all matching contract details.
+    std::vector<ContractDetails> get_contract_details(const Contract& contract);
+
+    // Option chain of an underlying stock: the expirations and strikes reqSecDefOptParams
+    // reports, indexed by OptionChain. Kept in memory and, after setOptionChainCacheDirectory,
+    // on disk; a chain fetched on an earlier day is fetched again. Returns nullptr on failure.
+    std::shared_ptr<const OptionChain> get_option_chain(const std::string& symbol);
+
+    // Reference data of a stock or OCC option symbol (conId, primary exchange, min tick,
+    // multiplier, trading hours), resolved with reqContractDetails on the first call and cached
+    // in memory and, after setContractCacheFile, on disk for the next start. nullptr if TWS
+    // does not know the symbol or it is ambiguous.
+    std::shared_ptr<const ContractInfo> get_contract_info(const std::string& symbol);
+    void setContractCacheFile(const std::string& path);
+    // `price` on the contract's tick grid: the price increments of its market rule (requested
+    // once per rule and cached), else its min tick from contract details or tickReqParams.
+    // Unchanged if none of them is known yet. Order submission and modification apply it to
+    // every limit and stop price, so orders are not rejected for invalid increments; new
+    // orders first resolve an uncached contract and its rule, and are refused (status
+    // "UnknownPriceIncrement") if the increment is still unknown.
+    double roundOrderPrice(const std::string& symbol, double price, PriceRounding mode);
+    void setOptionChainCacheDirectory(const std::string& directory);
+
+    // Awaitable versions of the request/response calls. They suspend instead of blocking a
+    // thread and resume on m_executor, so one caller can keep many requests in flight:
+    //     auto bars = co_await api.historical("AAPL", "", "20250324 16:00:00", 100);
+    //     auto all  = co_await whenAll(std::move(tasks));
+    // Arguments are taken by value because the task may run after the caller's frame is gone.
+    Task<BarSeries> historical(std::string symbol, std::string start, std::string end, int limit);
+    Task<std::vector<Position>> positions();
+    Task<OptionQuote> optionQuote(std::string optionSymbol);
+    Task<double> cashBalance();
+
+    // Depth and drop counters of the per-domain dispatch queues.
+    std::vector<QueueStats> getQueueStats() const;
+    // Round-trip time, clock offset against TWS and stall state of the reader/link.
+    LinkStats getLinkStats() const;
+
     // --- EWrapper callbacks ---
 
     // void reqTickByTickData(int tickerId, const Contract& contract,
@@ -303,35 +585,213 @@ public:
 
 public:
     EClientSocket* m_client;
-    EReaderOSSignal* m_signal; // Added signal for asynchronous processing
+    ReaderSignal* m_signal; // Added signal for asynchronous processing
     int m_nextOrderId;
     std::mutex m_mutex;
     std::condition_variable m_cond;
     std::map<OrderId, OrderResult> m_orders;  // Keyed by client_order_id
-    std::vector<Position> m_positions;
+    // Kept current by the reqPositions subscription (opened by the first position request,
+    // then never cancelled): position() updates or removes entries as they change.
+    using PositionKey = std::pair<long, std::string>;  // conId, account
+    std::map<PositionKey, Position> m_positions;        // rows of one contract are adjacent
+    std::unordered_multimap<std::string, PositionKey> m_positionsBySymbol;
+    int symbolPositionLocked(const std::string& symbol) const;
+    bool m_positionsSubscribed = false;
+    bool m_positionsLoaded = false;  // positionEnd received since subscribing
     std::map<TickerId, Quote> m_quotes;
     std::map<TickerId, Trade> m_trades;
-    std::map<int, std::vector<HistoricalBar>> m_historicalData;  // Keyed by request id
+    std::map<int, BarSeries> m_historicalData;  // Keyed by request id
+    std::unique_ptr<BarCache> m_barCache;
     std::unordered_map<int, std::string> m_reqIdToSymbol;
     std::map<int, std::string> m_tickerIdToSymbol;
 
-    int m_nextTickerId = 1000; // Starting ticker id (can be any number)
+    // Declared before m_requests so it outlives the registry's timeout handlers.
+    Executor m_executor{2};  // resumes awaiting coroutines
+    // Request/ticker id allocator and pending request table. Order ids (nextValidId) count up
+    // from wherever TWS left them and share error()'s id argument, so request ids start far
+    // above any order id an account reaches.
+    static constexpr int kFirstRequestId = 1000000000;
+    RequestRegistry m_requests{kFirstRequestId};
+    static constexpr std::chrono::milliseconds kRequestTimeout{5000};
+    static constexpr std::chrono::milliseconds kHistoricalTimeout{30000};
+    static constexpr std::chrono::milliseconds kPacedHistoricalTimeout{660000};  // a full pacing window, on top of the expected queue wait
+    static constexpr std::chrono::milliseconds kOptionQuoteTimeout{2000};
+    static constexpr long kLiveQuoteSeconds = 5;  // older streamed quotes are not used as a spot
+    int newTickerId(const std::string& symbol);
+    RequestAwaiter awaitRequest(int reqId, std::chrono::milliseconds timeout, std::function<void()> send);
+
+    void sendHistoricalRequest(int reqId, const Contract& contract, const std::string& end);
+    void sendHistoricalChunk(int reqId, const Contract& contract, const HistoricalQuery& query,
+                             const HistoricalChunk& chunk);
+    BarSeries takeHistoricalBars(int reqId, const std::string& symbol, const RequestResult& status);
+    HistoricalPacer m_historicalPacer;  // declared after m_requests, which its send callbacks use
+    static constexpr int kMaxMessagesPerSecond = 45;  // TWS disconnects clients above 50
+    MessagePacer m_outbound{kMaxMessagesPerSecond};  // every request and cancel, from any thread
+    // Takes one message of the shared outbound budget (blocking while the last second is full)
+    // and returns the client for that one call: pacedClient()->reqMktData(...).
+    EClientSocket* pacedClient() {
+        m_outbound.acquire();
+        return m_client;
+    }
+    static HistoricalPacer::Key historicalPacingKey(const Contract& contract, const std::string& end,
+        const std::string& duration, const std::string& barSize, const std::string& whatToShow,
+        int useRTH, int formatDate);
+    void submitPaced(const HistoricalPacer::Key& key, int reqId, std::function<void()> send);
+    void queueHistoricalRequest(int reqId, const Contract& contract, const std::string& end,
+        const std::string& duration, const std::string& barSize, const std::string& whatToShow,
+        int useRTH, int formatDate, bool keepUpToDate = false);
+    struct LiveBarSubscription {
+        LiveBarSeries series;
+        LiveBarHandler onChange;
+    };
+    std::mutex m_liveBarsMutex;
+    std::map<int, LiveBarSubscription> m_liveBars;  // keyed by request id
+    bool applyLiveBarEvent(const HistoricalEvent& event);
+    // A range still to fetch: `fetch` is sent to TWS, `covers` (which contains it) is what the
+    // cache may mark as complete once it arrived, e.g. including the weekend trimmed off.
+    struct HistoricalWindow {
+        TimeRange fetch;
+        TimeRange covers;
+    };
+    HistoricalQuery clipToHeadTimestamp(const HistoricalQuery& query);
+    std::vector<HistoricalWindow> sessionWindows(const HistoricalQuery& query, const std::vector<TimeRange>& missing);
+    void fetchHistoricalWindows(const HistoricalQuery& query, const std::vector<HistoricalWindow>& windows,
+                                int maxInFlight, HistoricalRangeResult& result);
+    std::map<std::string, time_t> m_headTimestampCache;   // keyed by symbol|whatToShow|rth
+    std::map<int, std::string> m_headTimestampReplies;    // keyed by request id
+    struct ScheduleCache {
+        std::vector<TimeRange> covered;
+        std::map<time_t, TradingSession> sessions;         // keyed by session start
+    };
+    std::map<std::string, ScheduleCache> m_schedules;      // keyed by symbol|rth
+    std::map<int, std::vector<TradingSession>> m_scheduleReplies;
+    std::optional<std::vector<TradingSession>> cachedSchedule(const std::string& key, time_t start, time_t end);
+    void queueHistoricalTicksRequest(int reqId, const Contract& contract, const std::string& start,
+        const std::string& whatToShow, int useRTH);
+    // Destination of an outstanding reqHistoricalTicks page. A page arrives as a single
+    // callback, so the reader thread appends it straight into the caller's columns instead of
+    // queueing a thousand per-tick events for the dispatch thread.
+    struct TickPageSink {
+        TickColumns* out = nullptr;
+        time_t end = 0;          // ticks at or after end are dropped
+        time_t skipTime = 0;     // the first `skip` ticks stamped skipTime came with the previous page
+        size_t skip = 0;
+        size_t received = 0;     // ticks in the page, including skipped ones
+        time_t lastTime = 0;
+        size_t atLastTime = 0;   // ticks in the page stamped lastTime
+    };
+    static constexpr int kTicksPerPage = 1000;
+    std::mutex m_tickPageMutex;
+    std::unordered_map<int, TickPageSink> m_tickPages;
+    template <typename Tick, typename Append>
+    void appendTickPage(int reqId, const std::vector<Tick>& ticks, bool done, Append append);
+    BarSeries finishHistoricalRequest(int reqId, const std::string& symbol,
+                                      const RequestResult& status, int limit);
+    std::vector<int> m_positionRequests;  // ids waiting for positionEnd
+    bool beginPositionsRequest(int reqId, bool& subscribe);
+    std::vector<Position> finishPositionsRequest(const RequestResult& status);
+    std::vector<Position> positionsLocked() const;
+    bool ensurePositionsLoaded();
+    int beginOptionQuote(const std::string& optionSymbol);
+    OptionQuote finishOptionQuote(int tickerId, const std::string& optionSymbol, const RequestResult& status);
     std::mutex m_tickMutex;
     std::vector<Trade> m_latestTrades;
     std::vector<Quote> m_latestQuotes;
 
     std::map<std::string, std::string> m_accountValues;
-    std::condition_variable m_accountCondVar;
     std::mutex m_accountMutex;
-    bool m_accountSummaryReceived = false;
+    AccountState m_accountState;
+    std::string m_managedAccount;               // first of managedAccounts, guarded by m_mutex
+    std::string m_accountUpdatesAccount;        // subscribed account, guarded by m_mutex
+    bool m_accountUpdatesSubscribed = false;    // guarded by m_mutex
+    bool m_accountUpdatesLoaded = false;        // guarded by m_mutex
+    std::vector<int> m_accountUpdateRequests;   // ids waiting for accountDownloadEnd, guarded by m_mutex
+    PnlTable m_pnl;
+    struct PnlLine {
+        long conId = 0;
+        std::string symbol;
+    };
+    // P&L subscriptions, guarded by m_mutex.
+    bool m_pnlSubscribed = false;
+    std::string m_pnlAccount;
+    int m_pnlAccountReqId = 0;
+    std::unordered_map<int, PnlLine> m_pnlLines;    // reqPnLSingle id -> position
+    std::unordered_map<long, int> m_pnlLineIds;     // conId -> reqPnLSingle id
+    void updatePnlLine(const Position& position);
+    void cancelPnlLocked();
+    bool failPnlLine(int reqId, const std::string& message);
 
-    std::mutex m_optionQuoteMutex;
-    std::condition_variable m_optionQuoteCondition;
     std::map<int, OptionQuote> m_optionQuotes; // keyed by tickerId
+    std::set<int> m_pendingOptionQuotes;       // getOptionQuote requests still waiting for fields
+    // Destination of an outstanding get_option_snapshots line, written by the market data
+    // dispatch thread under m_tickMutex.
+    struct OptionSnapshotSink {
+        OptionSnapshot* out = nullptr;
+        uint8_t required = 0;
+    };
+    std::unordered_map<int, OptionSnapshotSink> m_optionSnapshots;  // keyed by tickerId
+    GreeksStore m_greeks;  // guarded by m_tickMutex
+    // Option tickers whose model IV goes into a surface, keyed by tickerId, guarded by m_tickMutex.
+    struct VolSurfaceFeed {
+        std::shared_ptr<VolSurface> surface;
+        size_t slot = 0;
+    };
+    std::unordered_map<int, VolSurfaceFeed> m_volSurfaceFeeds;
+    void feedVolSurface(int tickerId, const std::string& optionSymbol);
+    bool resolvePriceIncrement(const std::string& symbol);
+    // False (prices untouched) if a price is set and the symbol's increment cannot be found.
+    bool roundOrderPrices(const std::string& symbol, bool buy, double& limitPrice, double& stopPrice,
+                          double& takeProfitPrice, double& stopLossPrice);
+    static void applyOptionSnapshotEvent(OptionSnapshot& snapshot, const MarketDataEvent& event);
+    std::map<int, std::vector<ContractDetails>> m_contractDetails;  // keyed by request id
+    ContractCache m_contracts;  // keyed by stock symbol or OCC symbol; may be used while holding m_mutex
+    MarketRuleCache m_marketRules;
+    std::unordered_map<std::string, double> m_tickMinTicks;  // tickReqParams by symbol, guarded by m_tickMutex
+    void requestMarketRule(int marketRuleId);
+    std::shared_ptr<const Contract> cacheContract(const std::string& key, Contract contract);
+    std::string m_optionChainDirectory;
+    std::map<std::string, std::shared_ptr<const OptionChain>> m_optionChains;  // keyed by symbol
+    std::map<int, std::vector<OptionChainParams>> m_secDefParams;               // keyed by request id
+    std::map<std::string, std::shared_ptr<VolSurface>> m_volSurfaces;           // keyed by underlying
+
+    // Per-domain event queues (reader thread -> dispatch threads).
+    SpscQueue<MarketDataEvent> m_marketDataQueue{65536};
+    SpscQueue<OrderEvent> m_orderQueue{4096};
+    SpscQueue<AccountEvent> m_accountQueue{4096};
+    SpscQueue<HistoricalEvent> m_historicalQueue{65536};
+    std::atomic<bool> m_dispatchRunning{false};
+    std::vector<std::thread> m_dispatchThreads;
+    ReaderConfig m_readerConfig;        // as set, applied by the next connect()
+    ReaderConfig m_activeReaderConfig;  // copy the running reader and dispatch threads use
+    std::thread m_readerThread;
+    LinkMonitorConfig m_linkMonitorConfig;
+    LinkMonitor m_linkMonitor{[this]() {
+        m_outbound.record();  // counted but never delayed, so the measured RTT stays honest
+        m_client->reqCurrentTimeInMillis();
+    }};
+
+    void startDispatchThreads();
+    void stopDispatchThreads();
+    void pushMarketDataEvent(MarketDataEvent&& event);
+    template <typename Event>
+    void pushLossless(SpscQueue<Event>& queue, Event&& event);
+    void applyMarketDataEvent(const MarketDataEvent& event);
+    void applyOrderEvent(const OrderEvent& event);
+    void applyAccountEvent(const AccountEvent& event);
+    void applyHistoricalEvent(const HistoricalEvent& event);
 
     // Helper functions to build IB contracts
     Contract createStockContract(const std::string& symbol);
-    Contract createOptionContract(const std::string& symbol);
+    // OCC symbol -> contract, std::nullopt if the symbol is malformed.
+    std::optional<Contract> createOptionContract(const std::string& symbol);
+    // Cached createOptionContract/createStockContract: a hash lookup after the first call for a
+    // symbol. The first call also requests the contract details in the background, and once
+    // they arrive the cached contract carries the conId (and trading class, multiplier and
+    // primary exchange) TWS resolved. Every order and market data call goes through these.
+    std::shared_ptr<const Contract> optionContract(const std::string& symbol);
+    std::shared_ptr<const Contract> stockContract(const std::string& symbol);
+    // One chain entry, with its trading class and multiplier.
+    Contract createOptionContract(const OptionChain& chain, size_t expiry, size_t strike, OptionRight right);
 };
 
 #endif // TWS_API_H
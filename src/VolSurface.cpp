@@ -0,0 +1,172 @@
+#include "VolSurface.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr double kSecondsPerYear = 365.0 * 86400.0;
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+constexpr double kMaxVol = 10.0;  // 1000%; anything above is a bad print or an unset marker
+
+bool validVol(double v) { return std::isfinite(v) && v > 0.0 && v <= kMaxVol; }
+
+} // namespace
+
+double VolSmile::volAt(double x) const {
+    if (vol.empty())
+        return kNaN;
+    if (x <= logStrike.front())
+        return vol.front();
+    if (x >= logStrike.back())
+        return vol.back();
+    const size_t i = static_cast<size_t>(std::upper_bound(logStrike.begin(), logStrike.end(), x) - logStrike.begin());
+    const double t = (x - logStrike[i - 1]) / (logStrike[i] - logStrike[i - 1]);
+    const double variance = (1.0 - t) * vol[i - 1] * vol[i - 1] + t * vol[i] * vol[i];
+    return std::sqrt(variance);
+}
+
+double VolSurfaceSnapshot::vol(double moneyness, double years) const {
+    return volAtStrike(moneyness * spot, years);
+}
+
+double VolSurfaceSnapshot::volAtStrike(double strike, double years) const {
+    if (!(strike > 0.0))
+        return kNaN;
+    const double x = std::log(strike);
+    // Neighbouring fitted smiles around `years`; smiles are sorted by expiry.
+    const VolSmile* before = nullptr;
+    const VolSmile* after = nullptr;
+    double tBefore = 0.0, tAfter = 0.0;
+    for (const auto& smile : smiles) {
+        if (!smile || smile->empty())
+            continue;
+        const double t = static_cast<double>(smile->expiry - asOf) / kSecondsPerYear;
+        if (t <= 0.0)
+            continue;
+        if (t <= years) {
+            before = smile.get();
+            tBefore = t;
+        } else {
+            after = smile.get();
+            tAfter = t;
+            break;
+        }
+    }
+    if (!before && !after)
+        return kNaN;
+    if (!after)
+        return before->volAt(x);
+    if (!before || years <= 0.0)
+        return after->volAt(x);
+    const double vBefore = before->volAt(x), vAfter = after->volAt(x);
+    const double wBefore = vBefore * vBefore * tBefore, wAfter = vAfter * vAfter * tAfter;
+    const double w = wBefore + (wAfter - wBefore) * (years - tBefore) / (tAfter - tBefore);
+    return std::sqrt(std::max(w, 0.0) / years);
+}
+
+VolSurface::VolSurface(std::shared_ptr<const OptionChain> chain)
+    : m_chain(std::move(chain)),
+      m_iv(m_chain ? m_chain->slotCount() : 0, kNaN),
+      m_stale(m_chain ? m_chain->expiries().size() : 0, 0),
+      m_smiles(m_stale.size()) {}
+
+bool VolSurface::update(size_t slot, double iv) {
+    if (!validVol(iv))
+        return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (slot >= m_iv.size())
+        return false;
+    if (m_iv[slot] == iv)
+        return true;
+    m_iv[slot] = iv;
+    m_stale[m_chain->key(slot).expiry] = 1;
+    m_changed.store(true, std::memory_order_release);
+    return true;
+}
+
+void VolSurface::setSpot(double spot) {
+    if (!(spot > 0.0))
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_spot == spot)
+        return;
+    // The spot picks the side each strike's vol comes from: refit the smiles fitted without a
+    // spot, and those with a strike the spot moved across. The others stay valid in strike space.
+    const double lo = std::min(m_spot, spot), hi = std::max(m_spot, spot);
+    for (size_t e = 0; e < m_stale.size(); ++e) {
+        const std::vector<double>& strikes = m_chain->expiry(e).strikes;
+        if (m_spot <= 0.0 || std::lower_bound(strikes.begin(), strikes.end(), lo) !=
+                              std::lower_bound(strikes.begin(), strikes.end(), hi))
+            m_stale[e] = 1;
+    }
+    m_spot = spot;
+    m_changed.store(true, std::memory_order_release);
+}
+
+// Called with m_mutex held.
+std::shared_ptr<const VolSmile> VolSurface::fitSmile(size_t e) const {
+    const OptionChain::Expiry& expiry = m_chain->expiry(e);
+    auto smile = std::make_shared<VolSmile>();
+    smile->date = expiry.date;
+    smile->expiry = OptionChain::expiryTime(expiry.date);
+    smile->logStrike.reserve(expiry.strikes.size());
+    smile->vol.reserve(expiry.strikes.size());
+    for (size_t k = 0; k < expiry.strikes.size(); ++k) {
+        const double strike = expiry.strikes[k];
+        const double call = m_iv[m_chain->slot(e, k, OptionRight::Call)];
+        const double put = m_iv[m_chain->slot(e, k, OptionRight::Put)];
+        double v;
+        if (m_spot > 0.0) {
+            const bool putSide = strike < m_spot;
+            v = validVol(putSide ? put : call) ? (putSide ? put : call) : (putSide ? call : put);
+        } else {
+            v = validVol(call) && validVol(put) ? 0.5 * (call + put) : (validVol(call) ? call : put);
+        }
+        if (!validVol(v))
+            continue;
+        smile->logStrike.push_back(std::log(strike));
+        smile->vol.push_back(v);
+    }
+    return smile;
+}
+
+std::shared_ptr<const VolSurfaceSnapshot> VolSurface::snapshot(time_t now) {
+    if (!m_changed.load(std::memory_order_acquire)) {
+        auto current = m_snapshot.load(std::memory_order_acquire);
+        if (current && current->asOf == now)
+            return current;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto current = m_snapshot.load(std::memory_order_acquire);
+    if (current && !m_changed.load(std::memory_order_acquire)) {
+        if (current->asOf == now)
+            return current;  // another reader published it meanwhile
+        // Nothing to refit, but tenors are measured from asOf: republish with the new time.
+        auto next = std::make_shared<VolSurfaceSnapshot>(*current);
+        next->asOf = now;
+        m_snapshot.store(next, std::memory_order_release);
+        return next;
+    }
+
+    m_changed.store(false, std::memory_order_release);
+    size_t refitted = 0;
+    for (size_t e = 0; e < m_stale.size(); ++e) {
+        if (!m_stale[e])
+            continue;
+        m_smiles[e] = fitSmile(e);
+        m_stale[e] = 0;
+        ++refitted;
+    }
+    m_refits.fetch_add(refitted, std::memory_order_relaxed);
+
+    auto next = std::make_shared<VolSurfaceSnapshot>();
+    next->asOf = now;
+    next->spot = m_spot;
+    next->smiles = m_smiles;  // unchanged smiles are shared, not copied
+    m_snapshot.store(next, std::memory_order_release);
+    return next;
+}
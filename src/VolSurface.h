@@ -0,0 +1,76 @@
+#ifndef VOL_SURFACE_H
+#define VOL_SURFACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "OptionChain.h"
+
+// Smile of one expiry: implied volatility at the listed strikes, sorted by strike.
+struct VolSmile {
+    int32_t date = 0;                // YYYYMMDD
+    time_t expiry = 0;               // OptionChain::expiryTime(date)
+    std::vector<double> logStrike;   // ln(strike)
+    std::vector<double> vol;
+
+    bool empty() const { return vol.empty(); }
+    // Variance interpolated linearly in log-strike, flat beyond the outermost strikes.
+    double volAt(double logStrike) const;
+};
+
+// Immutable state of a surface. Readers hold it through a shared_ptr and query it without
+// locks while the surface publishes newer versions.
+struct VolSurfaceSnapshot {
+    time_t asOf = 0;   // tenors are measured from here
+    double spot = 0.0;
+    std::vector<std::shared_ptr<const VolSmile>> smiles;  // one per chain expiry, by date
+
+    // Volatility at moneyness = strike / spot and `years` to expiry. Total variance is
+    // interpolated linearly in time between the neighbouring smiles at the same strike, with
+    // flat volatility before the first and after the last one. NaN if nothing has been fitted.
+    double vol(double moneyness, double years) const;
+    double volAtStrike(double strike, double years) const;
+};
+
+// Implied volatility surface of one underlying on the strike x expiry grid of its option
+// chain. update() stores an IV (from a TWS option computation or from priceChain) in the
+// contract's slot and only marks its expiry stale; the next snapshot() refits just the stale
+// smiles and publishes a new snapshot that shares every other smile with the previous one.
+// Each smile takes the out-of-the-money side per strike (puts below spot, calls above),
+// falling back to the other side where one is missing.
+// Writers may call from any thread; readers only pay for an atomic load unless something
+// changed or the clock moved since the last snapshot (a new second costs a copy of the smile
+// pointers, not a refit).
+class VolSurface {
+public:
+    explicit VolSurface(std::shared_ptr<const OptionChain> chain);
+
+    const std::shared_ptr<const OptionChain>& chain() const { return m_chain; }
+
+    // False if the slot is out of range or iv is not in (0, 10] (TWS marks an unset IV with DBL_MAX).
+    bool update(size_t slot, double iv);
+    void setSpot(double spot);
+
+    std::shared_ptr<const VolSurfaceSnapshot> snapshot(time_t now = std::time(nullptr));
+    size_t refits() const { return m_refits.load(std::memory_order_relaxed); }  // smiles refitted so far
+
+private:
+    std::shared_ptr<const VolSmile> fitSmile(size_t expiry) const;
+
+    std::shared_ptr<const OptionChain> m_chain;
+    std::mutex m_mutex;                 // guards the members below
+    std::vector<double> m_iv;           // per chain slot, NaN = none
+    std::vector<uint8_t> m_stale;       // per expiry
+    std::vector<std::shared_ptr<const VolSmile>> m_smiles;
+    double m_spot = 0.0;
+    std::atomic<bool> m_changed{true};  // anything to publish since the last snapshot
+    std::atomic<size_t> m_refits{0};
+    std::atomic<std::shared_ptr<const VolSurfaceSnapshot>> m_snapshot;
+};
+
+#endif // VOL_SURFACE_H
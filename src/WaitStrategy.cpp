@@ -0,0 +1,36 @@
+#include "WaitStrategy.h"
+
+#include <iostream>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+const char* waitStrategyName(WaitStrategy strategy) {
+    switch (strategy) {
+        case WaitStrategy::Block: return "block";
+        case WaitStrategy::SpinYield: return "spin-yield";
+        case WaitStrategy::BusyPoll: return "busy-poll";
+    }
+    return "unknown";
+}
+
+bool pinCurrentThreadToCpu(int cpu) {
+    if (cpu < 0)
+        return false;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        std::cerr << "error at pinCurrentThreadToCpu: cannot pin to cpu " << cpu << " (rc=" << rc << ")" << std::endl;
+        return false;
+    }
+    return true;
+#else
+    std::cerr << "error at pinCurrentThreadToCpu: CPU affinity not supported on this platform" << std::endl;
+    return false;
+#endif
+}
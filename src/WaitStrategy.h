@@ -0,0 +1,34 @@
+#ifndef WAIT_STRATEGY_H
+#define WAIT_STRATEGY_H
+
+#include <string>
+#include <vector>
+
+// How the reader and dispatch threads wait for the next message.
+//  Block     - sleep on the reader signal or the queue doorbell (dispatch). Lowest CPU.
+//  SpinYield - poll spinIterations times, then yield the time slice and poll again.
+//  BusyPoll  - poll continuously; burns a full core per thread but has no wakeup latency.
+enum class WaitStrategy { Block, SpinYield, BusyPoll };
+
+struct ReaderConfig {
+    WaitStrategy waitStrategy = WaitStrategy::Block;
+    int spinIterations = 2000;
+    int readerCpu = -1;               // -1 = let the OS schedule the thread
+    std::vector<int> dispatchCpus;    // market data, orders, account, historical; -1 or missing = unpinned
+};
+
+const char* waitStrategyName(WaitStrategy strategy);
+
+// Pins the calling thread to one CPU. Returns false if the platform refuses (or cpu < 0).
+bool pinCurrentThreadToCpu(int cpu);
+
+// Hint to the CPU that we are in a spin loop.
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+#endif // WAIT_STRATEGY_H
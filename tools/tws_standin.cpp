@@ -0,0 +1,76 @@
+// Local stand-in for TWS / IB Gateway. Start it, then point the tws client at 127.0.0.1:<port>.
+//
+//   tws_standin [--port N] [--quote-rate R] [--tbt-rate R] [--fill-delay-ms N]
+//               [--bar-update-ms N] [--max-bars N] [--server-version V] [--seed S]
+#include "StandInServer.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static std::atomic<bool> g_stop{false};
+
+static void onSignal(int) { g_stop = true; }
+
+static void usage() {
+    std::cerr << "usage: tws_standin [--port N] [--quote-rate R] [--tbt-rate R] [--fill-delay-ms N]\n"
+                 "                   [--bar-update-ms N] [--max-bars N] [--server-version V] [--seed S]"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    StandInConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "--port") config.port = std::atoi(value);
+        else if (arg == "--quote-rate") config.quoteRate = std::atof(value);
+        else if (arg == "--tbt-rate") config.tickByTickRate = std::atof(value);
+        else if (arg == "--fill-delay-ms") config.fillDelay = std::chrono::milliseconds(std::atoi(value));
+        else if (arg == "--bar-update-ms") config.barUpdateInterval = std::chrono::milliseconds(std::atoi(value));
+        else if (arg == "--max-bars") config.maxHistoricalBars = std::atoi(value);
+        else if (arg == "--server-version") config.serverVersion = std::atoi(value);
+        else if (arg == "--seed") config.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    TwsStandInServer server(config);
+    if (!server.start())
+        return 1;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::cout << "TWS stand-in listening on 127.0.0.1:" << server.port()
+              << " (quotes " << config.quoteRate << "/s, tick-by-tick " << config.tickByTickRate
+              << "/s per subscription)" << std::endl;
+
+    StandInStats last = server.stats();
+    auto lastTime = std::chrono::steady_clock::now();
+    while (!g_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastTime < std::chrono::seconds(5))
+            continue;
+        StandInStats s = server.stats();
+        const double secs = std::chrono::duration<double>(now - lastTime).count();
+        std::cout << "sessions " << s.sessions
+                  << "  in " << s.messagesIn
+                  << "  out " << static_cast<uint64_t>((s.messagesOut - last.messagesOut) / secs) << " msg/s"
+                  << "  " << (s.bytesOut - last.bytesOut) / secs / 1e6 << " MB/s" << std::endl;
+        last = s;
+        lastTime = now;
+    }
+    server.stop();
+    return 0;
+}